@@ -0,0 +1,324 @@
+#include "batchingest.h"
+#include "memorybudget.h"
+#include "metrics.h"
+#include "tracer.h"
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <atomic>
+#include <memory>
+#include <numeric>
+
+namespace {
+
+// Копия результата остается в QFuture до конца загрузки, поэтому данные и резерв
+// памяти общие: после записи в базу писатель освобождает их сам
+struct ParsedResultFile {
+    QString path;
+    QString modelName;
+    std::shared_ptr<ParsedData> data;
+    std::shared_ptr<MemoryReservation> memory;
+    QString error;
+    qint64 bytes = 0;
+};
+
+// Оценка памяти под разбор до его начала: QMap со строковыми ключами на строку текста
+constexpr qint64 ParseBytesPerFileByte = 6;
+
+}
+
+QString ModelNamingRule::modelFor(const QString &filePath) const
+{
+    QFileInfo info(filePath);
+
+    switch (mode) {
+    case FixedName:
+        return fixedName;
+    case ParentDirectory:
+        return info.dir().dirName();
+    case FileNamePattern: {
+        QRegularExpression re(pattern);
+        QRegularExpressionMatch match = re.match(info.completeBaseName());
+        if (match.hasMatch() && !match.captured(1).isEmpty()) {
+            return match.captured(1);
+        }
+        // Имя не подходит под шаблон - модель по имени файла
+        return info.completeBaseName();
+    }
+    }
+    return QString();
+}
+
+BatchIngest::BatchIngest(Database *database)
+    : db(database)
+{
+}
+
+QStringList BatchIngest::collectFiles(const QStringList &paths, const QStringList &nameFilters)
+{
+    QStringList files;
+
+    for (const QString &path : paths) {
+        QFileInfo info(path);
+        if (info.isDir()) {
+            QDirIterator it(path, nameFilters, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                files.append(it.next());
+            }
+        } else if (info.isFile()) {
+            files.append(info.filePath());
+        }
+    }
+
+    files.sort();
+    files.removeDuplicates();
+    return files;
+}
+
+BatchIngestStats BatchIngest::run(const QStringList &files,
+                                  const std::function<bool(const BatchIngestProgress &)> &progress)
+{
+    BD_TRACE_SCOPE("ingest", "BatchIngest::run");
+    BatchIngestStats stats;
+    stats.files = files.size();
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    if (files.isEmpty()) {
+        return stats;
+    }
+
+    BatchIngestProgress state;
+    state.filesTotal = files.size();
+    for (const QString &path : files) {
+        state.bytesTotal += QFileInfo(path).size();
+    }
+
+    // Разбор всех файлов запускается сразу, результаты забираются по порядку.
+    // При бюджете памяти разбор ждет, пока записанные файлы не освободят место;
+    // файл, который сейчас ждет писатель (nextNeeded), разбирается без ожидания
+    std::atomic<qint64> parseMs{0};
+    std::atomic<qint64> parsedBytes{0};
+    std::atomic<int> nextNeeded{0};
+    std::atomic<bool> stopping{false};
+    const ModelNamingRule rule = namingRule;
+    QVector<int> indexes(files.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    QFuture<ParsedResultFile> future = QtConcurrent::mapped(indexes,
+        [files, rule, &parseMs, &parsedBytes, &nextNeeded, &stopping](int index) {
+            ParsedResultFile result;
+            result.path = files[index];
+            result.modelName = rule.modelFor(result.path);
+            result.bytes = QFileInfo(result.path).size();
+            result.memory = std::make_shared<MemoryReservation>(MemorySubsystem::ParseBuffers);
+            result.memory->grow(result.bytes * ParseBytesPerFileByte, [index, &nextNeeded, &stopping]() {
+                return index <= nextNeeded.load() || stopping.load();
+            });
+
+            QElapsedTimer timer;
+            timer.start();
+
+            FileParser fileParser;
+            result.data = std::make_shared<ParsedData>(fileParser.parseFile(result.path, result.error));
+            result.memory->resize(result.data->memoryBytes());
+
+            parseMs += timer.elapsed();
+            parsedBytes += result.bytes;
+            return result;
+        });
+
+    auto stopParsing = [&]() {
+        stopping = true;
+        MemoryBudget::instance().wakeWaiters();
+        future.cancel();
+        future.waitForFinished();
+    };
+
+    if (!db->beginResultsBatch()) {
+        stopParsing();
+        stats.errors.append("Cannot start transaction");
+        return stats;
+    }
+
+    QList<QPair<QString, ParsedData>> batch;
+    QList<ParsedResultFile> batchFiles;
+    QElapsedTimer writeTimer;
+    bool failed = false;
+
+    auto discard = [](const ParsedResultFile &file) {
+        *file.data = ParsedData();
+        file.memory->release();
+    };
+
+    auto flush = [&]() {
+        if (batch.isEmpty()) {
+            return true;
+        }
+        writeTimer.start();
+        int written = db->appendCalculationResults(batch);
+        stats.writeMs += writeTimer.elapsed();
+        batch.clear();
+        for (const ParsedResultFile &file : batchFiles) {
+            discard(file);
+        }
+        batchFiles.clear();
+
+        if (written < 0) {
+            stats.errors.append("Database write failed");
+            return false;
+        }
+        stats.rows += written;
+        return true;
+    };
+
+    auto reportProgress = [&](int filesDone) {
+        state.filesDone = filesDone;
+        state.bytesParsed = parsedBytes;
+        state.rowsWritten = stats.rows;
+        return !progress || progress(state);
+    };
+
+    for (int i = 0; i < files.size(); ++i) {
+        nextNeeded = i;
+        MemoryBudget::instance().wakeWaiters();
+
+        if (!reportProgress(i)) {
+            stats.cancelled = true;
+            break;
+        }
+
+        // С обратной связью ждем файл короткими шагами, чтобы отмена не ждала разбора
+        if (progress) {
+            while (!future.isResultReadyAt(i) && !stats.cancelled) {
+                QThread::msleep(20);
+                stats.cancelled = !reportProgress(i);
+            }
+            if (stats.cancelled) {
+                break;
+            }
+        }
+
+        ParsedResultFile file;
+        {
+            // Время, когда запись ждет разбор
+            BD_TRACE_SCOPE("ingest", "BatchIngest::waitParsed");
+            file = future.resultAt(i);
+        }
+        stats.bytes += file.bytes;
+
+        if (!file.error.isEmpty()) {
+            stats.errors.append(file.path + ": " + file.error);
+        }
+        if (file.data->nodeValues.isEmpty() || file.modelName.isEmpty()) {
+            stats.errors.append(file.path + ": no data or model name");
+            discard(file);
+            continue;
+        }
+
+        batch.append(qMakePair(file.modelName, *file.data));
+        batchFiles.append(file);
+        stats.loadedFiles++;
+        if (!stats.models.contains(file.modelName)) {
+            stats.models.append(file.modelName);
+        }
+        if (!stats.calculationTypes.contains(file.data->calculationType)) {
+            stats.calculationTypes.append(file.data->calculationType);
+        }
+        const QPair<QString, QString> resultSet(file.modelName, file.data->calculationType);
+        if (!stats.resultSets.contains(resultSet)) {
+            stats.resultSets.append(resultSet);
+        }
+
+        if (batch.size() >= batchSize && !flush()) {
+            failed = true;
+            break;
+        }
+    }
+
+    if (!stats.cancelled && !failed && !flush()) {
+        failed = true;
+    }
+
+    if (stats.cancelled || failed) {
+        stopParsing();
+        db->rollbackResultsBatch();
+        stats.rows = 0;
+        stats.loadedFiles = 0;
+        stats.models.clear();
+        stats.calculationTypes.clear();
+        stats.resultSets.clear();
+    } else {
+        writeTimer.start();
+        stats.committed = db->commitResultsBatch();
+        stats.writeMs += writeTimer.elapsed();
+        if (!stats.committed) {
+            stats.errors.append("Commit failed");
+        }
+    }
+
+    if (progress && stats.committed) {
+        state.filesDone = files.size();
+        state.bytesParsed = state.bytesTotal;
+        state.rowsWritten = stats.rows;
+        progress(state);
+    }
+
+    stats.parseMs = parseMs;
+    stats.totalMs = totalTimer.elapsed();
+    return stats;
+}
+
+QFuture<BatchIngestStats> BatchIngest::runInBackground(const QString &databaseName,
+                                                       const QStringList &files,
+                                                       const ModelNamingRule &rule)
+{
+    // Отдельный пул на один поток: писатель в SQLite один, и ожидание разбора
+    // не занимает потоки общего пула, в котором идет сам разбор
+    static QThreadPool writerPool;
+    writerPool.setMaxThreadCount(1);
+
+    const std::shared_ptr<QueuedJob> queued = Metrics::instance().jobQueued();
+    return QtConcurrent::run(&writerPool,
+                             [databaseName, files, rule, queued](QPromise<BatchIngestStats> &promise) {
+        RunningJob job(queued);
+        static std::atomic<int> connectionCounter{0};
+
+        // Соединение живет только внутри задачи и только в ее потоке. Схему уже создало
+        // соединение GUI - здесь только открываем, без миграций за блокировку записи
+        Database database(QString("batch_ingest_%1").arg(++connectionCounter));
+        if (!database.openConnection(databaseName)) {
+            BatchIngestStats stats;
+            stats.files = files.size();
+            stats.errors.append("Cannot open database: " + databaseName);
+            promise.addResult(stats);
+            return;
+        }
+
+        BatchIngest ingest(&database);
+        ingest.setNamingRule(rule);
+
+        bool rangeSet = false;
+        BatchIngestStats stats = ingest.run(files, [&](const BatchIngestProgress &progress) {
+            if (!rangeSet) {
+                promise.setProgressRange(0, int(qMax<qint64>(1, progress.bytesTotal / 1024)));
+                rangeSet = true;
+            }
+            promise.setProgressValueAndText(int(progress.bytesParsed / 1024),
+                                            QString("%1 / %2 files, %3 / %4 MB parsed, %5 rows written")
+                                                .arg(progress.filesDone)
+                                                .arg(progress.filesTotal)
+                                                .arg(progress.bytesParsed / 1048576.0, 0, 'f', 1)
+                                                .arg(progress.bytesTotal / 1048576.0, 0, 'f', 1)
+                                                .arg(progress.rowsWritten));
+            return !promise.isCanceled();
+        });
+
+        promise.addResult(stats);
+    });
+}
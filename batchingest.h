@@ -0,0 +1,80 @@
+#ifndef BATCHINGEST_H
+#define BATCHINGEST_H
+
+#include <QString>
+#include <QStringList>
+#include <QFuture>
+#include <functional>
+#include "database.h"
+
+// Правило сопоставления файла результатов с моделью
+struct ModelNamingRule {
+    enum Mode {
+        FixedName,          // одна модель для всех файлов
+        ParentDirectory,    // имя папки с файлом
+        FileNamePattern     // первая группа захвата регулярного выражения по имени файла
+    };
+
+    Mode mode = ParentDirectory;
+    QString fixedName;
+    QString pattern = "^([^_]+)_";   // по умолчанию - префикс до "_"
+
+    QString modelFor(const QString &filePath) const;
+};
+
+struct BatchIngestProgress {
+    int filesDone = 0;
+    int filesTotal = 0;
+    qint64 bytesParsed = 0;
+    qint64 bytesTotal = 0;
+    qint64 rowsWritten = 0;     // записано в открытую транзакцию
+};
+
+struct BatchIngestStats {
+    int files = 0;
+    int loadedFiles = 0;
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    qint64 parseMs = 0;     // суммарное время разбора во всех потоках
+    qint64 writeMs = 0;
+    qint64 totalMs = 0;
+    QStringList models;             // модели и виды расчетов загруженных файлов
+    QStringList calculationTypes;
+    QList<QPair<QString, QString>> resultSets;  // записанные пары (модель, вид расчета)
+    QStringList errors;
+    bool cancelled = false;
+    bool committed = false;
+};
+
+// Пакетная загрузка файлов результатов: разбор идет параллельно в пуле потоков,
+// а вызывающий поток по мере готовности пишет файлы порциями в одну транзакцию.
+// Разбор следующих файлов перекрывается с записью предыдущих.
+class BatchIngest
+{
+public:
+    explicit BatchIngest(Database *database);
+
+    static QStringList collectFiles(const QStringList &paths,
+                                    const QStringList &nameFilters = {"*.txt", "*.csv"});
+
+    void setNamingRule(const ModelNamingRule &rule) { namingRule = rule; }
+    void setBatchSize(int files) { batchSize = qMax(1, files); }
+
+    // progress вызывается в потоке записи после каждого файла; false - отмена с откатом транзакции
+    BatchIngestStats run(const QStringList &files,
+                         const std::function<bool(const BatchIngestProgress &)> &progress = {});
+
+    // Загрузка в пуле потоков через отдельное соединение с базой (схема уже создана initDatabase).
+    // Прогресс - в килобайтах разобранных данных, текст - файлы и записанные строки.
+    // cancel() у QFuture откатывает транзакцию; результат есть только при завершении без отмены.
+    static QFuture<BatchIngestStats> runInBackground(const QString &databaseName,
+                                                     const QStringList &files,
+                                                     const ModelNamingRule &rule);
+
+private:
+    Database *db;
+    ModelNamingRule namingRule;
+    int batchSize = 8;
+};
+
+#endif // BATCHINGEST_H
@@ -1,4 +1,4 @@
-QT       += core gui sql
+QT       += core gui sql concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -8,20 +8,11 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-SOURCES += \
-    database.cpp \
-    fileparser.cpp \
-    main.cpp \
-    mainwindow.cpp \
-    materialimportdialog.cpp \
-    materialparser.cpp
+include(core.pri)
+include(gui.pri)
 
-HEADERS += \
-    database.h \
-    fileparser.h \
-    mainwindow.h \
-    materialimportdialog.h \
-    materialparser.h
+SOURCES += \
+    main.cpp
 
 FORMS +=
 
@@ -0,0 +1,13 @@
+# Бенчмарки разбора и загрузки на синтетических данных (без GUI)
+QT       = core sql concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = bd_lab3_bench
+
+include(core.pri)
+include(benchmarks.pri)
+
+SOURCES += \
+    parserbenchmarks.cpp
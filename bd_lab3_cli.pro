@@ -0,0 +1,21 @@
+# Консольная утилита: пакетная загрузка, запросы и экспорт без GUI
+QT       = core sql concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = bd_lab3_cli
+
+include(core.pri)
+
+SOURCES += \
+    commandlinetool.cpp \
+    main_cli.cpp
+
+HEADERS += \
+    commandlinetool.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,13 @@
+# Бенчмарки нагрузки на базу: запись, выборки, материалы, экспорт (без GUI)
+QT       = core sql concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = bd_lab3_dbbench
+
+include(core.pri)
+include(benchmarks.pri)
+
+SOURCES += \
+    dbbenchmarks.cpp
@@ -0,0 +1,14 @@
+# Сценарий отзывчивости GUI: MainWindow на большой синтетической базе
+QT       = core gui widgets sql concurrent
+
+CONFIG += c++17
+CONFIG -= app_bundle
+
+TARGET = bd_lab3_guibench
+
+include(core.pri)
+include(gui.pri)
+include(benchmarks.pri)
+
+SOURCES += \
+    guibenchmarks.cpp
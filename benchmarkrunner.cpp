@@ -0,0 +1,158 @@
+#include "benchmarkrunner.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+#include <numeric>
+
+double BenchmarkResult::megabytesPerSecond() const
+{
+    return medianMs > 0.0 && bytes > 0 ? bytes / 1048576.0 / (medianMs / 1000.0) : 0.0;
+}
+
+double BenchmarkResult::itemsPerSecond() const
+{
+    return medianMs > 0.0 && items > 0 ? items / (medianMs / 1000.0) : 0.0;
+}
+
+QJsonObject BenchmarkResult::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["parameters"] = QJsonObject::fromVariantMap(parameters);
+    object["iterations"] = iterations;
+    object["min_ms"] = minMs;
+    object["median_ms"] = medianMs;
+    object["mean_ms"] = meanMs;
+    object["max_ms"] = maxMs;
+    object["bytes"] = bytes;
+    object["items"] = items;
+    object["item_name"] = itemName;
+    object["mb_per_s"] = megabytesPerSecond();
+    object["items_per_s"] = itemsPerSecond();
+    return object;
+}
+
+BenchmarkRunner::BenchmarkRunner(const QString &suite)
+    : suite(suite)
+    , out(stderr)
+{
+}
+
+bool BenchmarkRunner::isSelected(const QString &name) const
+{
+    return filter.pattern().isEmpty() || filter.match(name).hasMatch();
+}
+
+bool BenchmarkRunner::run(const QString &name, qint64 bytes, qint64 items, const QString &itemName,
+                          const std::function<void()> &body, const QVariantMap &parameters,
+                          const std::function<void()> &setup)
+{
+    if (!isSelected(name)) {
+        return false;
+    }
+
+    // Прогрев: кэш файловой системы, пулы потоков, ленивые словари
+    if (setup) {
+        setup();
+    }
+    body();
+
+    QList<double> times;
+    QElapsedTimer total;
+    total.start();
+    while (times.size() < maxIterations
+           && (times.size() < minIterations || total.elapsed() < minTimeMs)) {
+        if (setup) {
+            setup();
+        }
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        times.append(timer.nsecsElapsed() / 1e6);
+    }
+
+    std::sort(times.begin(), times.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.iterations = times.size();
+    result.minMs = times.first();
+    result.maxMs = times.last();
+    result.medianMs = times.size() % 2 == 1
+                          ? times[times.size() / 2]
+                          : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2.0;
+    result.meanMs = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+    result.bytes = bytes;
+    result.items = items;
+    result.itemName = itemName;
+
+    add(result);
+    return true;
+}
+
+void BenchmarkRunner::add(const BenchmarkResult &result)
+{
+    benchmarkResults.append(result);
+    print(result);
+}
+
+void BenchmarkRunner::print(const BenchmarkResult &result)
+{
+    QString line = QString("%1  %2 ms").arg(result.name, -48).arg(result.medianMs, 10, 'f', 3);
+    if (result.bytes > 0) {
+        line += QString("  %1 MB/s").arg(result.megabytesPerSecond(), 9, 'f', 1);
+    }
+    if (result.items > 0) {
+        line += QString("  %1 %2/s").arg(result.itemsPerSecond(), 12, 'f', 0).arg(result.itemName);
+    }
+    out << line << "\n";
+    out.flush();
+}
+
+QJsonObject BenchmarkRunner::report() const
+{
+    QJsonObject machine;
+    machine["cpu"] = QSysInfo::currentCpuArchitecture();
+    machine["threads"] = QThread::idealThreadCount();
+    machine["os"] = QSysInfo::prettyProductName();
+    machine["qt"] = QString(qVersion());
+
+    QJsonArray results;
+    for (const BenchmarkResult &result : benchmarkResults) {
+        results.append(result.toJson());
+    }
+
+    QJsonObject report;
+    report["suite"] = suite;
+    report["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["machine"] = machine;
+    report["context"] = QJsonObject::fromVariantMap(context);
+    report["results"] = results;
+    return report;
+}
+
+bool BenchmarkRunner::writeReport(const QString &fileName, QString *error) const
+{
+    const QByteArray json = QJsonDocument(report()).toJson(QJsonDocument::Indented);
+
+    // "-" - в стандартный вывод (таблица идет в stderr и не мешает разбору)
+    if (fileName == "-") {
+        QTextStream(stdout) << json;
+        return true;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        if (error) {
+            *error = "Cannot write report: " + file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+#include <QTextStream>
+#include <QVariantMap>
+#include <functional>
+
+// Результат одного бенчмарка. Скорости считаются по медиане повторов
+struct BenchmarkResult {
+    QString name;
+    QVariantMap parameters;         // размер данных, формат, конфигурация
+    int iterations = 0;
+    double minMs = 0.0;
+    double medianMs = 0.0;
+    double meanMs = 0.0;
+    double maxMs = 0.0;
+    qint64 bytes = 0;               // на один повтор
+    qint64 items = 0;
+    QString itemName;               // "rows", "nodes", "materials"...
+
+    double megabytesPerSecond() const;
+    double itemsPerSecond() const;
+    QJsonObject toJson() const;
+};
+
+// Общая часть бенчмарков: повторы с прогревом, фильтр по имени, таблица в консоль
+// и отчет JSON (машиночитаемый, для сравнения между сборками)
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner(const QString &suite);
+
+    void setFilter(const QString &pattern) { filter = QRegularExpression(pattern); }
+    // Повторять, пока не наберется minIterations и minTimeMs (но не больше maxIterations)
+    void setIterations(int minimum, int maximum) { minIterations = minimum; maxIterations = maximum; }
+    void setMinTimeMs(int milliseconds) { minTimeMs = milliseconds; }
+    void setContext(const QString &key, const QVariant &value) { context.insert(key, value); }
+
+    bool isSelected(const QString &name) const;
+
+    // setup выполняется перед каждым повтором вне замера (например, новая пустая база)
+    bool run(const QString &name, qint64 bytes, qint64 items, const QString &itemName,
+             const std::function<void()> &body, const QVariantMap &parameters = QVariantMap(),
+             const std::function<void()> &setup = std::function<void()>());
+
+    // Однократный замер, сделанный вызывающим (долгие операции на больших базах)
+    void add(const BenchmarkResult &result);
+
+    const QList<BenchmarkResult> &results() const { return benchmarkResults; }
+    QJsonObject report() const;
+    bool writeReport(const QString &fileName, QString *error = nullptr) const;
+
+private:
+    void print(const BenchmarkResult &result);
+
+    QString suite;
+    QRegularExpression filter;
+    int minIterations = 3;
+    int maxIterations = 50;
+    int minTimeMs = 500;
+    QVariantMap context;
+    QList<BenchmarkResult> benchmarkResults;
+    QTextStream out;
+};
+
+#endif // BENCHMARKRUNNER_H
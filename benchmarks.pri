@@ -0,0 +1,12 @@
+# Общая часть бенчмарков: генераторы синтетических данных и отчет JSON.
+# Подключается в bd_lab3_bench.pro, bd_lab3_dbbench.pro и bd_lab3_guibench.pro вместе с core.pri.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/benchmarkrunner.cpp \
+    $$PWD/syntheticdata.cpp
+
+HEADERS += \
+    $$PWD/benchmarkrunner.h \
+    $$PWD/syntheticdata.h
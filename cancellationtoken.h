@@ -0,0 +1,24 @@
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <atomic>
+#include <memory>
+
+// Флаг отмены долгой операции. Копии токена разделяют одно состояние:
+// поток GUI вызывает cancel(), рабочий поток проверяет isCancelled().
+class CancellationToken
+{
+public:
+    CancellationToken() : state(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { state->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return state->load(std::memory_order_relaxed); }
+
+    // Для обработчиков с void * (прогресс-обработчик SQLite)
+    std::atomic<bool> *flag() const { return state.get(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+#endif // CANCELLATIONTOKEN_H
@@ -0,0 +1,576 @@
+#include "commandlinetool.h"
+#include "batchingest.h"
+#include "materialselector.h"
+#include "memorybudget.h"
+#include "resultexporter.h"
+#include "resultsnapshot.h"
+#include "resultstore.h"
+#include "slowquerylog.h"
+#include "tracer.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <limits>
+
+CommandLineTool::CommandLineTool()
+    : out(stdout)
+    , err(stderr)
+{
+}
+
+int CommandLineTool::run(const QStringList &arguments)
+{
+    parser.setApplicationDescription(
+        "Batch ingest, query and export for the materials/results database.\n\n"
+        "Commands:\n"
+        "  ingest <files|dirs...>    load Workbench text exports (*.txt)\n"
+        "  import-matml <files|dirs...>  load MatML materials (*.xml, *.matml)\n"
+        "  query                     print calculation results (--model, --type, --min, --max)\n"
+        "  summary                   count/min/max/mean per calculation type (same filters)\n"
+        "  top                       --limit largest values (--asc: smallest) over the same filters\n"
+        "  join                      values of --type and --with side by side by node (--model)\n"
+        "  select                    select materials by property ranges (--where)\n"
+        "  export                    write filtered calculation results to CSV or binary (--out, --format)\n"
+        "  snapshot                  write a memory-mappable snapshot of all results (--out *.bdsnap)");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "ingest | import-matml | query | summary | top | join | select | export | snapshot");
+    parser.addPositionalArgument("paths", "Files or directories for ingest/import-matml", "[paths...]");
+
+    parser.addOptions({
+        {{"d", "db"}, "Database file (default: materials.db).", "file", "materials.db"},
+        {{"m", "model"}, "Model name. For ingest: defaults to the parent directory name.", "name"},
+        {"model-pattern", "Ingest: regular expression over the file name, group 1 is the model name.",
+         "regex"},
+        {{"t", "type"}, "Calculation type filter.", "type"},
+        {"min", "Lower bound for result values (SI units).", "value"},
+        {"max", "Upper bound for result values (SI units).", "value"},
+        {{"n", "limit"}, "Maximum number of printed rows (default: 50).", "count", "50"},
+        {{"j", "threads"}, "Parser threads (default: all cores).", "count"},
+        {{"w", "where"}, "Material criterion 'Property:min:max', empty bound is open. Repeatable.",
+         "criterion"},
+        {"rank", "Property used to rank selected materials.", "property"},
+        {"desc", "Rank in descending order."},
+        {{"o", "out"}, "Output file for export (*.bdr - binary format).", "file"},
+        {"format", "Export format: csv or binary (default: by file extension).", "format"},
+        {"asc", "top: smallest values instead of largest."},
+        {"with", "join: second calculation type.", "type"},
+        {"trace", "Write a Chrome trace (chrome://tracing, Perfetto) of the command; build with CONFIG+=tracing.",
+         "file"},
+        {"trace-detail", "Trace also per-value spans (number parsing, per-file SQL binding)."},
+        {"slow-ms", "Slow-query threshold in milliseconds (default: 200, negative - off).", "ms"},
+        {"slow-log", "Print slow statements with parameters and query plans after the command."},
+        {"memory-limit", "Memory budget in MB: parsing waits for written files to free memory (default: 0 - unlimited).",
+         "mb"}
+    });
+
+    parser.process(arguments);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.isEmpty()) {
+        err << parser.helpText();
+        err.flush();
+        return 1;
+    }
+
+    if (parser.isSet("threads")) {
+        QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, parser.value("threads").toInt()));
+    }
+
+    if (parser.isSet("slow-ms")) {
+        SlowQueryLog::instance().setThresholdMs(parser.value("slow-ms").toInt());
+    }
+
+    if (parser.isSet("memory-limit")) {
+        MemoryBudget::instance().setLimitBytes(parser.value("memory-limit").toLongLong() * 1048576);
+    }
+
+    if (parser.isSet("trace")) {
+        Tracer::setThreadName("main");
+        Tracer::start(parser.isSet("trace-detail"));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!db.initDatabase(parser.value("db"))) {
+        err << "Cannot open database: " << parser.value("db") << "\n";
+        err.flush();
+        return 2;
+    }
+    printStage("open", 1, "database", QFileInfo(parser.value("db")).size(), timer.elapsed());
+
+    const QString command = positional.first();
+    const QStringList paths = positional.mid(1);
+
+    int status = 1;
+    if (command == "ingest") {
+        status = ingestResults(paths);
+    } else if (command == "import-matml") {
+        status = importMaterials(paths);
+    } else if (command == "query") {
+        status = queryResults();
+    } else if (command == "summary") {
+        status = summarizeResults();
+    } else if (command == "top") {
+        status = topResults();
+    } else if (command == "join") {
+        status = joinResults();
+    } else if (command == "select") {
+        status = selectMaterials();
+    } else if (command == "export") {
+        status = exportResults();
+    } else if (command == "snapshot") {
+        status = writeSnapshot();
+    } else {
+        err << "Unknown command: " << command << "\n";
+    }
+
+    if (parser.isSet("slow-log")) {
+        printSlowQueries();
+    }
+
+    QString traceError;
+    if (parser.isSet("trace") && !Tracer::writeChromeTrace(parser.value("trace"), &traceError)) {
+        err << traceError << "\n";
+    }
+
+    out.flush();
+    err.flush();
+    return status;
+}
+
+void CommandLineTool::printSlowQueries()
+{
+    const QList<SlowQuery> queries = SlowQueryLog::instance().entries();
+    err << QString("slow queries (>= %1 ms): %2\n").arg(SlowQueryLog::instance().thresholdMs())
+                                                    .arg(queries.size());
+
+    for (const SlowQuery &query : queries) {
+        err << QString("%1 ms%2  [%3]\n  %4\n")
+                   .arg(query.elapsedUs / 1000.0, 0, 'f', 1)
+                   .arg(query.fullScan ? "  FULL SCAN" : "")
+                   .arg(query.connection, query.sql);
+        if (!query.parameters.isEmpty()) {
+            err << "  parameters: " << query.parameters.join(", ") << "\n";
+        }
+        for (const QString &step : query.plan) {
+            err << "    " << step << "\n";
+        }
+    }
+}
+
+void CommandLineTool::printStage(const QString &stage, qint64 items, const QString &itemName,
+                                 qint64 bytes, qint64 elapsedMs)
+{
+    double seconds = qMax<qint64>(elapsedMs, 1) / 1000.0;
+
+    out << QString("[%1] %2 %3 in %4 ms (%5 %3/s")
+               .arg(stage, -8)
+               .arg(items)
+               .arg(itemName)
+               .arg(elapsedMs)
+               .arg(items / seconds, 0, 'f', 1);
+    if (bytes > 0) {
+        out << QString(", %1 MB, %2 MB/s")
+                   .arg(bytes / 1048576.0, 0, 'f', 2)
+                   .arg(bytes / 1048576.0 / seconds, 0, 'f', 2);
+    }
+    out << ")\n";
+    out.flush();
+}
+
+int CommandLineTool::ingestResults(const QStringList &paths)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const QStringList files = BatchIngest::collectFiles(paths);
+    if (files.isEmpty()) {
+        err << "No result files found\n";
+        return 1;
+    }
+    printStage("scan", files.size(), "files", 0, timer.elapsed());
+
+    ModelNamingRule rule;
+    if (parser.isSet("model")) {
+        rule.mode = ModelNamingRule::FixedName;
+        rule.fixedName = parser.value("model");
+    } else if (parser.isSet("model-pattern")) {
+        rule.mode = ModelNamingRule::FileNamePattern;
+        rule.pattern = parser.value("model-pattern");
+    }
+
+    BatchIngest ingest(&db);
+    ingest.setNamingRule(rule);
+    BatchIngestStats stats = ingest.run(files);
+
+    for (const QString &error : stats.errors) {
+        err << error << "\n";
+    }
+
+    // parse - суммарное время потоков разбора, write - время записи в транзакции
+    printStage("parse", stats.files, "files", stats.bytes, stats.parseMs);
+    printStage("write", stats.rows, "rows", 0, stats.writeMs);
+    printStage("ingest", stats.rows, "rows", stats.bytes, stats.totalMs);
+
+    if (!stats.committed) {
+        err << "Failed to write results, transaction rolled back\n";
+        return 2;
+    }
+
+    out << QString("Loaded %1 files (%2 skipped), %3 rows\n")
+               .arg(stats.loadedFiles).arg(stats.files - stats.loadedFiles).arg(stats.rows);
+    return stats.loadedFiles < stats.files ? 3 : 0;
+}
+
+int CommandLineTool::importMaterials(const QStringList &paths)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const QStringList files = BatchIngest::collectFiles(paths, {"*.xml", "*.matml"});
+    if (files.isEmpty()) {
+        err << "No MatML files found\n";
+        return 1;
+    }
+
+    qint64 totalBytes = 0;
+    for (const QString &file : files) {
+        totalBytes += QFileInfo(file).size();
+    }
+    printStage("scan", files.size(), "files", 0, timer.elapsed());
+
+    timer.restart();
+    const QList<ParsedMaterial> parsed = QtConcurrent::blockingMapped<QList<ParsedMaterial>>(
+        files, [](const QString &path) {
+            MaterialParser materialParser;
+            return materialParser.parseMatML(path);
+        });
+
+    QList<ParsedMaterial> materials;
+    for (const ParsedMaterial &material : parsed) {
+        if (!material.isEmpty()) {
+            materials.append(material);
+        }
+    }
+    printStage("parse", materials.size(), "materials", totalBytes, timer.elapsed());
+
+    timer.restart();
+    if (!db.importParsedMaterials(materials)) {
+        err << "Failed to import materials, transaction rolled back\n";
+        return 2;
+    }
+    printStage("write", materials.size(), "materials", 0, timer.elapsed());
+
+    int skipped = files.size() - materials.size();
+    out << QString("Imported %1 materials (%2 files skipped)\n").arg(materials.size()).arg(skipped);
+    return skipped > 0 ? 3 : 0;
+}
+
+bool CommandLineTool::parseRange(double &minimum, double &maximum)
+{
+    minimum = -std::numeric_limits<double>::infinity();
+    maximum = std::numeric_limits<double>::infinity();
+
+    bool ok = true;
+    if (parser.isSet("min")) {
+        minimum = parser.value("min").toDouble(&ok);
+        if (!ok) {
+            err << "Invalid --min value\n";
+            return false;
+        }
+    }
+    if (parser.isSet("max")) {
+        maximum = parser.value("max").toDouble(&ok);
+        if (!ok) {
+            err << "Invalid --max value\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+ResultFilter CommandLineTool::resultFilter()
+{
+    ResultFilter filter;
+    filter.modelName = parser.value("model");
+    filter.calculationType = parser.value("type");
+    parseRange(filter.minimum, filter.maximum);
+    return filter;
+}
+
+bool CommandLineTool::reportOutcome(const QueryOutcome &outcome)
+{
+    switch (outcome.status) {
+    case QueryStatus::Complete:
+    case QueryStatus::Partial:
+        return true;
+    case QueryStatus::Cancelled:
+        err << QString("Query cancelled after %1 rows\n").arg(outcome.rows);
+        return false;
+    case QueryStatus::Failed:
+        err << "Query failed: " << outcome.error << "\n";
+        return false;
+    }
+    return false;
+}
+
+int CommandLineTool::queryResults()
+{
+    double minimum = 0.0;
+    double maximum = 0.0;
+    if (!parseRange(minimum, maximum)) {
+        return 1;
+    }
+
+    // Не больше --limit строк; статус Partial - в базе есть еще
+    ResultFilter filter = resultFilter();
+    filter.limit = parser.value("limit").toInt();
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<QVector<QVariant>> results;
+    const QueryOutcome outcome = db.queryCalculationResults(filter, results);
+    printStage("query", results.size(), "rows", 0, timer.elapsed());
+    if (!reportOutcome(outcome)) {
+        return 2;
+    }
+
+    QHash<QString, QString> units;
+    for (const auto &type : db.getAllCalculationTypes()) {
+        units.insert(type.first, type.second);
+    }
+
+    for (const QVector<QVariant> &row : results) {
+        out << row[0].toString() << "\t" << row[1].toString() << "\t"
+            << row[2].toString() << "\t" << row[3].toDouble() << " "
+            << units.value(row[2].toString()) << "\n";
+    }
+    if (outcome.status == QueryStatus::Partial) {
+        out << QString("... more rows (use --limit)\n");
+    }
+    return 0;
+}
+
+int CommandLineTool::summarizeResults()
+{
+    double minimum = 0.0;
+    double maximum = 0.0;
+    if (!parseRange(minimum, maximum)) {
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<ResultSummary> summaries;
+    const QueryOutcome outcome = db.summarizeCalculationResults(resultFilter(), summaries);
+    printStage("summary", summaries.size(), "types", 0, timer.elapsed());
+    if (!reportOutcome(outcome)) {
+        return 2;
+    }
+
+    QHash<QString, QString> units;
+    for (const auto &type : db.getAllCalculationTypes()) {
+        units.insert(type.first, type.second);
+    }
+
+    out << "Calculation Type\tCount\tMin\tMax\tMean\tUnit\n";
+    for (const ResultSummary &summary : summaries) {
+        out << summary.calculationType << "\t" << summary.count << "\t"
+            << summary.minimum << "\t" << summary.maximum << "\t" << summary.mean << "\t"
+            << units.value(summary.calculationType) << "\n";
+    }
+    return 0;
+}
+
+int CommandLineTool::topResults()
+{
+    double minimum = 0.0;
+    double maximum = 0.0;
+    if (!parseRange(minimum, maximum)) {
+        return 1;
+    }
+
+    // Наборы загружаются в память один раз, отбор идет параллельно по наборам
+    ResultStore store(db.getDatabase().databaseName());
+    const int count = qMax(0, parser.value("limit").toInt());
+
+    QElapsedTimer timer;
+    timer.start();
+    ResultBlock block;
+    const QueryOutcome outcome = store.top(resultFilter(), count, !parser.isSet("asc"), block);
+    printStage("top", block.size(), "rows", store.memoryBytes(), timer.elapsed());
+    if (!reportOutcome(outcome)) {
+        return 2;
+    }
+
+    QHash<QString, QString> units;
+    for (const auto &type : db.getAllCalculationTypes()) {
+        units.insert(type.first, type.second);
+    }
+
+    for (int i = 0; i < block.size(); ++i) {
+        out << block.modelName(i) << "\t" << block.nodeNumber(i) << "\t"
+            << block.calculationType(i) << "\t" << block.value(i) << " "
+            << units.value(block.calculationType(i)) << "\n";
+    }
+    return 0;
+}
+
+int CommandLineTool::joinResults()
+{
+    const QString model = parser.value("model");
+    const QString firstType = parser.value("type");
+    const QString secondType = parser.value("with");
+    if (model.isEmpty() || firstType.isEmpty() || secondType.isEmpty()) {
+        err << "join needs --model, --type and --with\n";
+        return 1;
+    }
+
+    ResultStore store(db.getDatabase().databaseName());
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<JoinedResult> rows;
+    const QueryOutcome outcome = store.join(model, firstType, secondType, rows);
+    printStage("join", rows.size(), "nodes", store.memoryBytes(), timer.elapsed());
+    if (!reportOutcome(outcome)) {
+        return 2;
+    }
+
+    const int limit = parser.value("limit").toInt();
+    out << "Node\t" << firstType << "\t" << secondType << "\n";
+    for (int i = 0; i < rows.size() && (limit < 0 || i < limit); ++i) {
+        out << rows[i].nodeNumber << "\t" << rows[i].first << "\t" << rows[i].second << "\n";
+    }
+    if (limit >= 0 && rows.size() > limit) {
+        out << QString("... %1 more nodes (use --limit)\n").arg(rows.size() - limit);
+    }
+    return 0;
+}
+
+int CommandLineTool::selectMaterials()
+{
+    SelectionQuery query;
+    query.rankBy = parser.value("rank");
+    query.descending = parser.isSet("desc");
+    query.limit = parser.value("limit").toInt();
+
+    for (const QString &criterion : parser.values("where")) {
+        // "Property:min:max" - название свойства может содержать двоеточие
+        const QStringList parts = criterion.split(':');
+        if (parts.size() < 3) {
+            err << "Invalid criterion (expected Property:min:max): " << criterion << "\n";
+            return 1;
+        }
+
+        RangePredicate predicate;
+        predicate.propertyName = parts.mid(0, parts.size() - 2).join(':');
+        const QString minText = parts[parts.size() - 2].trimmed();
+        const QString maxText = parts.last().trimmed();
+
+        bool minOk = true;
+        bool maxOk = true;
+        if (!minText.isEmpty()) {
+            predicate.minimum = minText.toDouble(&minOk);
+        }
+        if (!maxText.isEmpty()) {
+            predicate.maximum = maxText.toDouble(&maxOk);
+        }
+        if (!minOk || !maxOk) {
+            err << "Invalid bounds in criterion: " << criterion << "\n";
+            return 1;
+        }
+        query.predicates.append(predicate);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    MaterialPropertyMatrix &matrix = db.materialMatrix();
+    printStage("matrix", matrix.liveRowCount(), "materials", 0, timer.elapsed());
+
+    MaterialSelector selector(&db);
+    SelectionResult result = selector.select(query);
+    printStage("select", result.totalMatches, "matches", 0, qint64(result.elapsedMs));
+
+    int rankColumn = query.rankBy.isEmpty() ? -1 : matrix.columnOf(query.rankBy);
+    for (int row : result.rows) {
+        out << matrix.materialName(row);
+        if (rankColumn >= 0 && matrix.hasValue(row, rankColumn)) {
+            out << "\t" << matrix.value(row, rankColumn) << " " << matrix.unit(row, rankColumn);
+        }
+        out << "\n";
+    }
+    return 0;
+}
+
+int CommandLineTool::exportResults()
+{
+    const QString fileName = parser.value("out");
+    if (fileName.isEmpty()) {
+        err << "export requires --out\n";
+        return 1;
+    }
+
+    double minimum = 0.0;
+    double maximum = 0.0;
+    if (!parseRange(minimum, maximum)) {
+        return 1;
+    }
+
+    ResultExportFormat format = ResultExporter::formatForFile(fileName);
+    if (parser.isSet("format")) {
+        const QString name = parser.value("format");
+        if (name != "csv" && name != "binary") {
+            err << "Invalid --format (expected csv or binary)\n";
+            return 1;
+        }
+        format = name == "binary" ? ResultExportFormat::Binary : ResultExportFormat::Csv;
+    }
+
+    // Чтение порциями, форматирование в пуле потоков, запись по порядку
+    ResultExporter exporter(&db);
+    const ResultExportStats stats = exporter.run(resultFilter(), fileName, format);
+    if (!stats.error.isEmpty()) {
+        err << stats.error << "\n";
+        return 2;
+    }
+    if (!reportOutcome(stats.outcome)) {
+        return 2;
+    }
+
+    printStage("export", stats.rows, "rows", stats.bytes, stats.elapsedMs);
+    return 0;
+}
+
+int CommandLineTool::writeSnapshot()
+{
+    const QString fileName = parser.value("out");
+    if (fileName.isEmpty()) {
+        err << "snapshot requires --out\n";
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!ResultSnapshot::write(&db, fileName, &error)) {
+        err << error << "\n";
+        return 2;
+    }
+
+    // Проверка: снимок открывается и содержит все наборы
+    ResultSnapshot snapshot;
+    if (!snapshot.open(fileName)) {
+        err << snapshot.errorString() << "\n";
+        return 2;
+    }
+
+    qint64 rows = 0;
+    for (int i = 0; i < snapshot.resultSetCount(); ++i) {
+        rows += snapshot.resultSet(i).rows;
+    }
+    printStage("snapshot", rows, "rows", QFileInfo(fileName).size(), timer.elapsed());
+    out << QString("Wrote %1 result sets to %2\n").arg(snapshot.resultSetCount()).arg(fileName);
+    return 0;
+}
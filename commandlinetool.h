@@ -0,0 +1,44 @@
+#ifndef COMMANDLINETOOL_H
+#define COMMANDLINETOOL_H
+
+#include <QCommandLineParser>
+#include <QStringList>
+#include <QTextStream>
+#include "database.h"
+
+// Консольный режим: пакетная загрузка результатов и MatML, запросы и экспорт.
+// Разбор файлов идет параллельно, запись в базу - одной транзакцией на пакет.
+// По каждому этапу печатается время и пропускная способность.
+class CommandLineTool
+{
+public:
+    CommandLineTool();
+
+    int run(const QStringList &arguments);
+
+private:
+    int ingestResults(const QStringList &paths);
+    int importMaterials(const QStringList &paths);
+    int queryResults();
+    int summarizeResults();
+    int topResults();
+    int joinResults();
+    int selectMaterials();
+    int exportResults();
+    int writeSnapshot();
+
+    ResultFilter resultFilter();
+    bool reportOutcome(const QueryOutcome &outcome);
+    bool parseRange(double &minimum, double &maximum);
+
+    void printSlowQueries();
+    void printStage(const QString &stage, qint64 items, const QString &itemName,
+                    qint64 bytes, qint64 elapsedMs);
+
+    Database db;
+    QCommandLineParser parser;
+    QTextStream out;
+    QTextStream err;
+};
+
+#endif // COMMANDLINETOOL_H
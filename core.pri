@@ -0,0 +1,71 @@
+# Общее ядро: база данных, разбор файлов и индексы (без зависимостей от QtWidgets).
+# Подключается и в GUI (bd_lab3.pro), и в консольную утилиту (bd_lab3_cli.pro).
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/batchingest.cpp \
+    $$PWD/database.cpp \
+    $$PWD/fileparser.cpp \
+    $$PWD/materialparser.cpp \
+    $$PWD/materialpropertymatrix.cpp \
+    $$PWD/materialsearchindex.cpp \
+    $$PWD/memorybudget.cpp \
+    $$PWD/metrics.cpp \
+    $$PWD/materialselector.cpp \
+    $$PWD/propertycurve.cpp \
+    $$PWD/resultblock.cpp \
+    $$PWD/resultcache.cpp \
+    $$PWD/resultexporter.cpp \
+    $$PWD/resultsnapshot.cpp \
+    $$PWD/resultstore.cpp \
+    $$PWD/slowquerylog.cpp \
+    $$PWD/stallwatchdog.cpp \
+    $$PWD/stringinterner.cpp \
+    $$PWD/substitutesearch.cpp \
+    $$PWD/tracer.cpp \
+    $$PWD/unitregistry.cpp \
+    $$PWD/watchfolderservice.cpp
+
+HEADERS += \
+    $$PWD/batchingest.h \
+    $$PWD/cancellationtoken.h \
+    $$PWD/database.h \
+    $$PWD/densebitmap.h \
+    $$PWD/fileparser.h \
+    $$PWD/materialparser.h \
+    $$PWD/materialpropertymatrix.h \
+    $$PWD/materialsearchindex.h \
+    $$PWD/memorybudget.h \
+    $$PWD/metrics.h \
+    $$PWD/materialselector.h \
+    $$PWD/propertycurve.h \
+    $$PWD/resultblock.h \
+    $$PWD/resultcache.h \
+    $$PWD/resultexporter.h \
+    $$PWD/resultsnapshot.h \
+    $$PWD/resultstore.h \
+    $$PWD/slowquerylog.h \
+    $$PWD/stallwatchdog.h \
+    $$PWD/stringinterner.h \
+    $$PWD/substitutesearch.h \
+    $$PWD/tracer.h \
+    $$PWD/unitregistry.h \
+    $$PWD/watchfolderservice.h
+
+# Резидентная память процесса (GetProcessMemoryInfo)
+win32: LIBS += -lpsapi
+
+# Интервалы трассировки (BD_TRACE_SCOPE); без этого макросы пустые.
+#   qmake "CONFIG+=tracing"
+tracing {
+    DEFINES += BD_TRACING
+}
+
+# Отмена долгих запросов внутри SQLite (прогресс-обработчик). Только если Qt собран
+# с системным SQLite (-system-sqlite): иначе у плагина QSQLITE своя копия библиотеки.
+#   qmake "CONFIG+=sqlite_native_cancel"
+sqlite_native_cancel {
+    DEFINES += BD_SQLITE_NATIVE_CANCEL
+    LIBS += -lsqlite3
+}
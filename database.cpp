@@ -1,8 +1,111 @@
 #include "database.h"
+#include "metrics.h"
+#include "slowquerylog.h"
+#include "stringinterner.h"
+#include "tracer.h"
+#include "unitregistry.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QSqlDriver>
+#include <cmath>
+
+#ifdef BD_SQLITE_NATIVE_CANCEL
+#include <sqlite3.h>
+#endif
+
+namespace {
+
+// Вид расчета, созданный без единицы, получает единицу первого файла с ней, пока
+// результатов этого вида нет. Дальше единица не меняется: файлы с другой отклоняются
+const char *const UpsertCalculationTypeSql =
+    "INSERT INTO calculation_types (name, unit, display_unit) VALUES (?, ?, ?) "
+    "ON CONFLICT(name) DO UPDATE SET unit = excluded.unit, display_unit = excluded.display_unit "
+    "WHERE calculation_types.unit = '' AND NOT EXISTS "
+    "(SELECT 1 FROM calculation_results WHERE calculation_type_name = excluded.name)";
+
+// Зависимости свойств от параметра: отсортированные массивы точек в BLOB.
+// Параметр (температура и т.п.) - из того же словаря, что и свойства
+const char *const CurveTableSql =
+    "CREATE TABLE IF NOT EXISTS material_property_curves ("
+    "material_id INTEGER NOT NULL,"
+    "property_id INTEGER NOT NULL,"
+    "parameter_id INTEGER NOT NULL,"
+    "parameter_unit_id INTEGER NOT NULL,"
+    "abscissa BLOB NOT NULL,"
+    "ordinate BLOB NOT NULL,"
+    "FOREIGN KEY (material_id) REFERENCES materials(id) ON DELETE CASCADE,"
+    "FOREIGN KEY (property_id) REFERENCES properties(id),"
+    "FOREIGN KEY (parameter_id) REFERENCES properties(id),"
+    "FOREIGN KEY (parameter_unit_id) REFERENCES units(id),"
+    "PRIMARY KEY (material_id, property_id)) WITHOUT ROWID";
+
+#ifdef BD_SQLITE_NATIVE_CANCEL
+// Указатель на соединение SQLite под QSqlDatabase (nullptr - другой драйвер)
+sqlite3 *sqliteHandle(const QSqlDatabase &db)
+{
+    const QVariant handleVariant = db.driver()->handle();
+    if (handleVariant.isValid() && qstrcmp(handleVariant.typeName(), "sqlite3*") == 0) {
+        return *static_cast<sqlite3 *const *>(handleVariant.constData());
+    }
+    return nullptr;
+}
+#endif
+
+// Пока объект жив, SQLite каждые 1000 инструкций виртуальной машины проверяет токен
+// и прерывает запрос (SQLITE_INTERRUPT). Требует Qt, собранного с системным SQLite
+// (-system-sqlite), и той же libsqlite3 при компоновке; иначе отмена - только между строками.
+class QueryCancellationScope
+{
+public:
+    QueryCancellationScope(const QSqlDatabase &db, const CancellationToken &token)
+        : token(token)
+    {
+#ifdef BD_SQLITE_NATIVE_CANCEL
+        handle = sqliteHandle(db);
+        if (handle) {
+            sqlite3_progress_handler(handle, 1000, &QueryCancellationScope::check, token.flag());
+        }
+#else
+        Q_UNUSED(db);
+#endif
+    }
+
+    ~QueryCancellationScope()
+    {
+#ifdef BD_SQLITE_NATIVE_CANCEL
+        if (handle) {
+            sqlite3_progress_handler(handle, 0, nullptr, nullptr);
+        }
+#endif
+    }
+
+private:
+#ifdef BD_SQLITE_NATIVE_CANCEL
+    static int check(void *flag)
+    {
+        return static_cast<std::atomic<bool> *>(flag)->load(std::memory_order_relaxed) ? 1 : 0;
+    }
+
+    sqlite3 *handle = nullptr;
+#endif
+    CancellationToken token;    // держит флаг, пока установлен обработчик
+};
+
+}
+
+Database::Database(QObject *parent)
+    : Database(QString(), parent)
+{
+}
 
-Database::Database(QObject *parent) : QObject(parent)
+Database::Database(const QString &connectionName, QObject *parent)
+    : QObject(parent)
+    , connection(connectionName)
+    , propertyMatrix(this)
 {
-    db = QSqlDatabase::addDatabase("QSQLITE");
+    db = connection.isEmpty() ? QSqlDatabase::addDatabase("QSQLITE")
+                              : QSqlDatabase::addDatabase("QSQLITE", connection);
 }
 
 Database::~Database()
@@ -10,49 +113,443 @@ Database::~Database()
     if (db.isOpen()) {
         db.close();
     }
+
+    if (!connection.isEmpty()) {
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connection);
+    }
 }
 
 bool Database::initDatabase(const QString &databaseName)
 {
     db.setDatabaseName(databaseName);
 
+    // Фоновая загрузка пишет через свое соединение - ждем блокировку, а не падаем
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+    if (!db.open()) {
+        qDebug() << "Error opening database:" << db.lastError().text();
+        return false;
+    }
+
+    if (!migrateLegacyMaterialSchema() || !createTables()) {
+        return false;
+    }
+
+    // Каскадное удаление свойств вместе с материалом
+    QSqlQuery query(db);
+    if (!exec(query, "PRAGMA foreign_keys = ON")) {
+        qDebug() << "Failed to enable foreign keys:" << query.lastError().text();
+    }
+
+    // WAL: чтение в GUI не блокируется записью фоновой загрузки
+    if (!exec(query, "PRAGMA journal_mode = WAL")) {
+        qDebug() << "Failed to enable WAL journal:" << query.lastError().text();
+    }
+
+    return loadDictionaries() && normalizeLegacyUnits();
+}
+
+bool Database::openConnection(const QString &databaseName)
+{
+    db.setDatabaseName(databaseName);
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
     if (!db.open()) {
         qDebug() << "Error opening database:" << db.lastError().text();
         return false;
     }
 
-    return createTables();
+    // Режим WAL хранится в файле базы, включать его повторно не нужно
+    QSqlQuery query(db);
+    if (!exec(query, "PRAGMA foreign_keys = ON")) {
+        qDebug() << "Failed to enable foreign keys:" << query.lastError().text();
+    }
+    return true;
+}
+
+bool Database::migrateLegacyMaterialSchema()
+{
+    // Старая схема хранила property_name и unit строками в каждой строке
+    QSqlQuery query(db);
+    if (!exec(query, "PRAGMA table_info(material_properties)")) {
+        return true;
+    }
+
+    bool legacy = false;
+    while (query.next()) {
+        if (query.value(1).toString() == "property_name") {
+            legacy = true;
+        }
+    }
+    query.finish();
+
+    if (!legacy) {
+        return true;
+    }
+
+    qDebug() << "Migrating material_properties to dictionary schema";
+
+    db.transaction();
+
+    const QStringList statements = {
+        "ALTER TABLE material_properties RENAME TO material_properties_legacy",
+        "ALTER TABLE materials RENAME TO materials_legacy",
+        "CREATE TABLE materials ("
+        "id INTEGER PRIMARY KEY,"
+        "name TEXT UNIQUE NOT NULL)",
+        "CREATE TABLE properties ("
+        "id INTEGER PRIMARY KEY,"
+        "name TEXT UNIQUE NOT NULL)",
+        "CREATE TABLE units ("
+        "id INTEGER PRIMARY KEY,"
+        "name TEXT UNIQUE NOT NULL)",
+        "INSERT INTO materials (name) SELECT name FROM materials_legacy",
+        "INSERT OR IGNORE INTO properties (name) "
+        "SELECT DISTINCT property_name FROM material_properties_legacy",
+        "INSERT OR IGNORE INTO units (name) "
+        "SELECT DISTINCT unit FROM material_properties_legacy",
+        "CREATE TABLE material_properties ("
+        "material_id INTEGER NOT NULL,"
+        "property_id INTEGER NOT NULL,"
+        "unit_id INTEGER NOT NULL,"
+        "value REAL NOT NULL,"
+        "FOREIGN KEY (material_id) REFERENCES materials(id) ON DELETE CASCADE,"
+        "FOREIGN KEY (property_id) REFERENCES properties(id),"
+        "FOREIGN KEY (unit_id) REFERENCES units(id),"
+        "PRIMARY KEY (material_id, property_id)) WITHOUT ROWID",
+        "INSERT OR REPLACE INTO material_properties (material_id, property_id, unit_id, value) "
+        "SELECT m.id, p.id, u.id, l.value "
+        "FROM material_properties_legacy l "
+        "JOIN materials m ON m.name = l.material_name "
+        "JOIN properties p ON p.name = l.property_name "
+        "JOIN units u ON u.name = l.unit"
+    };
+
+    for (const QString &statement : statements) {
+        if (!exec(query, statement)) {
+            qDebug() << "Error migrating material schema:" << query.lastError().text();
+            rollbackTransaction();
+            return false;
+        }
+    }
+
+    // Строки без материала (или с пустым свойством/единицей) JOIN не переносит - сообщаем о них
+    if (exec(query, "SELECT COUNT(*), GROUP_CONCAT(DISTINCT l.material_name) "
+                    "FROM material_properties_legacy l "
+                    "LEFT JOIN materials m ON m.name = l.material_name "
+                    "LEFT JOIN properties p ON p.name = l.property_name "
+                    "LEFT JOIN units u ON u.name = l.unit "
+                    "WHERE m.id IS NULL OR p.id IS NULL OR u.id IS NULL")
+        && query.next() && query.value(0).toLongLong() > 0) {
+        qDebug() << "Material schema migration skipped" << query.value(0).toLongLong()
+                 << "orphan property rows, materials:" << query.value(1).toString();
+    }
+    query.finish();
+
+    for (const QString &statement : {QString("DROP TABLE material_properties_legacy"),
+                                     QString("DROP TABLE materials_legacy")}) {
+        if (!exec(query, statement)) {
+            qDebug() << "Error migrating material schema:" << query.lastError().text();
+            rollbackTransaction();
+            return false;
+        }
+    }
+
+    return db.commit();
+}
+
+void Database::rollbackTransaction()
+{
+    db.rollback();
+    // Словари могли получить id строк, которых после отката нет
+    loadDictionaries();
+}
+
+bool Database::loadDictionaries()
+{
+    propertyIds.clear();
+    propertyNames.clear();
+    unitIds.clear();
+    unitNames.clear();
+
+    StringInterner &interner = StringInterner::instance();
+    QSqlQuery query(db);
+
+    if (!exec(query, "SELECT id, name FROM properties")) {
+        qDebug() << "Error loading properties:" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        int id = query.value(0).toInt();
+        QString name = interner.intern(query.value(1).toString());
+        propertyIds.insert(name, id);
+        propertyNames.insert(id, name);
+    }
+
+    if (!exec(query, "SELECT id, name FROM units")) {
+        qDebug() << "Error loading units:" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        int id = query.value(0).toInt();
+        QString name = interner.intern(query.value(1).toString());
+        unitIds.insert(name, id);
+        unitNames.insert(id, name);
+    }
+
+    return true;
+}
+
+bool Database::ensureColumn(const QString &table, const QString &column,
+                            const QString &definition)
+{
+    QSqlQuery query(db);
+    if (!exec(query, QString("PRAGMA table_info(%1)").arg(table))) {
+        return false;
+    }
+    while (query.next()) {
+        if (query.value(1).toString() == column) {
+            return true;
+        }
+    }
+    query.finish();
+
+    if (!exec(query, QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, definition))) {
+        qDebug() << "Error adding column" << column << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool Database::ensureCurveForeignKeys()
+{
+    // В первых версиях таблицы не было внешних ключей на параметр и его единицу;
+    // добавить их в SQLite можно только пересозданием таблицы
+    QSqlQuery query(db);
+    if (!exec(query, "PRAGMA foreign_key_list(material_property_curves)")) {
+        return false;
+    }
+    int keys = 0;
+    while (query.next()) {
+        keys++;
+    }
+    query.finish();
+    if (keys >= 4) {
+        return true;
+    }
+
+    qDebug() << "Adding foreign keys to material_property_curves";
+    db.transaction();
+
+    const QStringList statements = {
+        "ALTER TABLE material_property_curves RENAME TO material_property_curves_legacy",
+        CurveTableSql,
+        "INSERT INTO material_property_curves SELECT * FROM material_property_curves_legacy "
+        "WHERE parameter_id IN (SELECT id FROM properties) "
+        "AND parameter_unit_id IN (SELECT id FROM units)",
+        "DROP TABLE material_property_curves_legacy"
+    };
+
+    for (const QString &statement : statements) {
+        if (!exec(query, statement)) {
+            qDebug() << "Error migrating material_property_curves:" << query.lastError().text();
+            rollbackTransaction();
+            return false;
+        }
+    }
+
+    return db.commit();
+}
+
+bool Database::normalizeLegacyUnits()
+{
+    // Строки, записанные до приведения к СИ, не имеют единицы отображения
+    QSqlQuery query(db);
+    QList<int> legacyUnitIds;
+    if (exec(query, "SELECT DISTINCT unit_id FROM material_properties WHERE display_unit_id IS NULL")) {
+        while (query.next()) {
+            legacyUnitIds.append(query.value(0).toInt());
+        }
+    }
+
+    QList<QPair<QString, QString>> legacyTypes;
+    if (exec(query, "SELECT name, unit FROM calculation_types WHERE display_unit IS NULL")) {
+        while (query.next()) {
+            legacyTypes.append(qMakePair(query.value(0).toString(), query.value(1).toString()));
+        }
+    }
+    query.finish();
+
+    if (legacyUnitIds.isEmpty() && legacyTypes.isEmpty()) {
+        return true;
+    }
+
+    qDebug() << "Normalizing legacy values to SI units";
+
+    const UnitRegistry &registry = UnitRegistry::instance();
+    db.transaction();
+
+    for (int unitId : legacyUnitIds) {
+        UnitConversion conversion = registry.lookup(unitNames.value(unitId));
+        int siUnitId = conversion.known ? ensureUnitId(conversion.siUnit) : unitId;
+
+        query.prepare("UPDATE material_properties "
+                      "SET value = value * :factor + :offset, unit_id = :si_unit_id, "
+                      "display_unit_id = :display_unit_id "
+                      "WHERE unit_id = :unit_id AND display_unit_id IS NULL");
+        query.bindValue(":factor", conversion.factor);
+        query.bindValue(":offset", conversion.offset);
+        query.bindValue(":si_unit_id", siUnitId);
+        query.bindValue(":display_unit_id", unitId);
+        query.bindValue(":unit_id", unitId);
+
+        if (siUnitId < 0 || !exec(query)) {
+            qDebug() << "Error normalizing material units:" << query.lastError().text();
+            rollbackTransaction();
+            return false;
+        }
+    }
+
+    for (const auto &type : legacyTypes) {
+        UnitConversion conversion = registry.lookup(type.second);
+
+        if (conversion.known && !conversion.isIdentity()) {
+            query.prepare("UPDATE calculation_results SET value = value * :factor + :offset "
+                          "WHERE calculation_type_name = :name");
+            query.bindValue(":factor", conversion.factor);
+            query.bindValue(":offset", conversion.offset);
+            query.bindValue(":name", type.first);
+            if (!exec(query)) {
+                qDebug() << "Error normalizing result units:" << query.lastError().text();
+                rollbackTransaction();
+                return false;
+            }
+        }
+
+        query.prepare("UPDATE calculation_types SET unit = :unit, display_unit = :display_unit "
+                      "WHERE name = :name");
+        query.bindValue(":unit", conversion.known ? conversion.siUnit : type.second);
+        query.bindValue(":display_unit", type.second);
+        query.bindValue(":name", type.first);
+        if (!exec(query)) {
+            qDebug() << "Error normalizing result units:" << query.lastError().text();
+            rollbackTransaction();
+            return false;
+        }
+    }
+
+    return db.commit();
+}
+
+int Database::ensureDictionaryId(const QString &table, const QString &name,
+                                 QHash<QString, int> &ids, QHash<int, QString> &names)
+{
+    auto it = ids.constFind(name);
+    if (it != ids.constEnd()) {
+        return it.value();
+    }
+
+    QSqlQuery query(db);
+    query.prepare(QString("INSERT OR IGNORE INTO %1 (name) VALUES (:name)").arg(table));
+    query.bindValue(":name", name);
+    if (!exec(query)) {
+        qDebug() << "Error adding to" << table << ":" << query.lastError().text();
+        return -1;
+    }
+
+    query.prepare(QString("SELECT id FROM %1 WHERE name = :name").arg(table));
+    query.bindValue(":name", name);
+    if (!exec(query) || !query.next()) {
+        return -1;
+    }
+
+    int id = query.value(0).toInt();
+    QString interned = StringInterner::instance().intern(name);
+    ids.insert(interned, id);
+    names.insert(id, interned);
+    return id;
+}
+
+int Database::ensurePropertyId(const QString &propertyName)
+{
+    return ensureDictionaryId("properties", propertyName, propertyIds, propertyNames);
+}
+
+int Database::ensureUnitId(const QString &unit)
+{
+    return ensureDictionaryId("units", unit.isEmpty() ? QString("dimensionless") : unit,
+                              unitIds, unitNames);
 }
 
 bool Database::createTables()
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
 
     // 1. Материалы
-    bool success = query.exec("CREATE TABLE IF NOT EXISTS materials ("
-                              "name TEXT PRIMARY KEY NOT NULL)");
+    bool success = exec(query, "CREATE TABLE IF NOT EXISTS materials ("
+                              "id INTEGER PRIMARY KEY,"
+                              "name TEXT UNIQUE NOT NULL)");
 
     if (!success) {
         qDebug() << "Error creating materials table:" << query.lastError().text();
         return false;
     }
 
-    // 2. Свойства материалов (обновленная структура)
-    success = query.exec("CREATE TABLE IF NOT EXISTS material_properties ("
-                         "property_name TEXT NOT NULL,"
-                         "material_name TEXT NOT NULL,"
-                         "unit TEXT NOT NULL,"
+    // 2. Словари свойств и единиц измерения
+    success = exec(query, "CREATE TABLE IF NOT EXISTS properties ("
+                         "id INTEGER PRIMARY KEY,"
+                         "name TEXT UNIQUE NOT NULL)");
+
+    if (!success) {
+        qDebug() << "Error creating properties table:" << query.lastError().text();
+        return false;
+    }
+
+    success = exec(query, "CREATE TABLE IF NOT EXISTS units ("
+                         "id INTEGER PRIMARY KEY,"
+                         "name TEXT UNIQUE NOT NULL)");
+
+    if (!success) {
+        qDebug() << "Error creating units table:" << query.lastError().text();
+        return false;
+    }
+
+    // Свойства материалов: целочисленные ключи вместо строк
+    success = exec(query, "CREATE TABLE IF NOT EXISTS material_properties ("
+                         "material_id INTEGER NOT NULL,"
+                         "property_id INTEGER NOT NULL,"
+                         "unit_id INTEGER NOT NULL,"
                          "value REAL NOT NULL,"
-                         "FOREIGN KEY (material_name) REFERENCES materials(name) ON DELETE CASCADE,"
-                         "PRIMARY KEY (property_name, material_name))");
+                         "display_unit_id INTEGER,"
+                         "FOREIGN KEY (material_id) REFERENCES materials(id) ON DELETE CASCADE,"
+                         "FOREIGN KEY (property_id) REFERENCES properties(id),"
+                         "FOREIGN KEY (unit_id) REFERENCES units(id),"
+                         "PRIMARY KEY (material_id, property_id)) WITHOUT ROWID");
 
     if (!success) {
         qDebug() << "Error creating material_properties table:" << query.lastError().text();
         return false;
     }
 
+    // Значения хранятся в СИ, единица из исходного файла - для отображения
+    if (!ensureColumn("material_properties", "display_unit_id", "INTEGER")) {
+        return false;
+    }
+
+    // Зависимости свойств от параметра
+    success = exec(query, CurveTableSql);
+
+    if (!success) {
+        qDebug() << "Error creating material_property_curves table:" << query.lastError().text();
+        return false;
+    }
+    if (!ensureCurveForeignKeys()) {
+        return false;
+    }
+
     // 3. Модели
-    success = query.exec("CREATE TABLE IF NOT EXISTS models ("
+    success = exec(query, "CREATE TABLE IF NOT EXISTS models ("
                          "name TEXT PRIMARY KEY NOT NULL)");
 
     if (!success) {
@@ -61,17 +558,22 @@ bool Database::createTables()
     }
 
     // 4. Виды расчетов
-    success = query.exec("CREATE TABLE IF NOT EXISTS calculation_types ("
+    success = exec(query, "CREATE TABLE IF NOT EXISTS calculation_types ("
                          "name TEXT PRIMARY KEY NOT NULL,"
-                         "unit TEXT NOT NULL)");
+                         "unit TEXT NOT NULL,"
+                         "display_unit TEXT)");
 
     if (!success) {
         qDebug() << "Error creating calculation_types table:" << query.lastError().text();
         return false;
     }
 
+    if (!ensureColumn("calculation_types", "display_unit", "TEXT")) {
+        return false;
+    }
+
     // 5. Результаты расчетов
-    success = query.exec("CREATE TABLE IF NOT EXISTS calculation_results ("
+    success = exec(query, "CREATE TABLE IF NOT EXISTS calculation_results ("
                          "model_name TEXT NOT NULL,"
                          "node_number TEXT NOT NULL,"
                          "calculation_type_name TEXT NOT NULL,"
@@ -85,42 +587,75 @@ bool Database::createTables()
         return false;
     }
 
-    // Создание индексов
-    query.exec("CREATE INDEX IF NOT EXISTS idx_results_model_node ON calculation_results(model_name, node_number)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_results_calc_type ON calculation_results(calculation_type_name)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_results_material ON calculation_results(material_name)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_prop_values_mat ON material_properties(material_name)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_prop_values_prop ON material_properties(property_name)");
+    // Создание индексов. (model_name, node_number, ...) уже покрыт первичным ключом;
+    // выборка по виду расчета идет в порядке (модель, узел) - индекс дает его без сортировки
+    const QStringList indexes = {
+        "DROP INDEX IF EXISTS idx_results_model_node",
+        "DROP INDEX IF EXISTS idx_results_calc_type",
+        "CREATE INDEX IF NOT EXISTS idx_results_type_model_node "
+        "ON calculation_results(calculation_type_name, model_name, node_number)",
+        "CREATE INDEX IF NOT EXISTS idx_prop_values_prop ON material_properties(property_id)"
+    };
+    for (const QString &statement : indexes) {
+        if (!exec(query, statement)) {
+            qDebug() << "Error creating index:" << statement << query.lastError().text();
+            return false;
+        }
+    }
 
     // Добавление предопределенных типов расчетов
-    query.exec("INSERT OR IGNORE INTO calculation_types (name, unit) VALUES ('Normal Stress', 'Pa')");
-    query.exec("INSERT OR IGNORE INTO calculation_types (name, unit) VALUES ('Directional Deformation', 'm')");
-    query.exec("INSERT OR IGNORE INTO calculation_types (name, unit) VALUES ('Shear Stress', 'Pa')");
-    query.exec("INSERT OR IGNORE INTO calculation_types (name, unit) VALUES ('Total Deformation', 'm')");
+    exec(query, "INSERT OR IGNORE INTO calculation_types (name, unit, display_unit) VALUES ('Normal Stress', 'Pa', 'Pa')");
+    exec(query, "INSERT OR IGNORE INTO calculation_types (name, unit, display_unit) VALUES ('Directional Deformation', 'm', 'm')");
+    exec(query, "INSERT OR IGNORE INTO calculation_types (name, unit, display_unit) VALUES ('Shear Stress', 'Pa', 'Pa')");
+    exec(query, "INSERT OR IGNORE INTO calculation_types (name, unit, display_unit) VALUES ('Total Deformation', 'm', 'm')");
 
     return true;
 }
 
+MaterialPropertyMatrix &Database::materialMatrix()
+{
+    propertyMatrix.ensureBuilt();
+    return propertyMatrix;
+}
+
 bool Database::addMaterial(const QString &name)
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("INSERT OR IGNORE INTO materials (name) VALUES (:name)");
     query.bindValue(":name", name);
-    return query.exec();
+
+    if (!exec(query)) {
+        return false;
+    }
+
+    if (query.numRowsAffected() > 0) {
+        propertyMatrix.invalidateMaterial(name);
+        emit materialAdded(name);
+    }
+    return true;
 }
 
 bool Database::removeMaterial(const QString &name)
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("DELETE FROM materials WHERE name = :name");
     query.bindValue(":name", name);
-    return query.exec();
+
+    if (!exec(query)) {
+        return false;
+    }
+
+    if (query.numRowsAffected() > 0) {
+        propertyMatrix.removeMaterial(name);
+        emit materialRemoved(name);
+    }
+    return true;
 }
 
 QList<QString> Database::getAllMaterials()
 {
     QList<QString> materials;
-    QSqlQuery query("SELECT name FROM materials ORDER BY name");
+    QSqlQuery query("SELECT name FROM materials ORDER BY name", db);
     while (query.next()) {
         materials.append(query.value(0).toString());
     }
@@ -132,54 +667,87 @@ bool Database::addMaterialProperty(const QString &materialName,
                                    const QString &unit,
                                    double value)
 {
-    QSqlQuery query;
+    UnitConversion conversion = UnitRegistry::instance().lookup(unit);
+    int propertyId = ensurePropertyId(propertyName);
+    int displayUnitId = ensureUnitId(unit);
+    int unitId = conversion.known ? ensureUnitId(conversion.siUnit) : displayUnitId;
+    if (propertyId < 0 || unitId < 0 || displayUnitId < 0) {
+        return false;
+    }
+
+    double siValue = conversion.known ? conversion.toSI(value) : value;
+
+    QSqlQuery query(db);
     query.prepare("INSERT OR REPLACE INTO material_properties "
-                  "(property_name, material_name, unit, value) "
-                  "VALUES (:property_name, :material_name, :unit, :value)");
-    query.bindValue(":property_name", propertyName);
+                  "(material_id, property_id, unit_id, value, display_unit_id) "
+                  "SELECT id, :property_id, :unit_id, :value, :display_unit_id "
+                  "FROM materials WHERE name = :material_name");
+    query.bindValue(":property_id", propertyId);
+    query.bindValue(":unit_id", unitId);
+    query.bindValue(":value", siValue);
+    query.bindValue(":display_unit_id", displayUnitId);
     query.bindValue(":material_name", materialName);
-    query.bindValue(":unit", unit.isEmpty() ? "dimensionless" : unit);
-    query.bindValue(":value", value);
 
-    return query.exec();
+    if (!exec(query)) {
+        return false;
+    }
+
+    propertyMatrix.setValue(materialName, propertyId, unitId, displayUnitId, siValue);
+    return true;
 }
 
 bool Database::updateMaterialProperty(const QString &materialName,
                                       const QString &propertyName,
                                       double value)
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("UPDATE material_properties SET value = :value "
-                  "WHERE material_name = :material_name AND property_name = :property_name");
+                  "WHERE material_id = (SELECT id FROM materials WHERE name = :material_name) "
+                  "AND property_id = :property_id");
     query.bindValue(":value", value);
     query.bindValue(":material_name", materialName);
-    query.bindValue(":property_name", propertyName);
+    query.bindValue(":property_id", propertyIds.value(propertyName, -1));
+
+    if (!exec(query)) {
+        return false;
+    }
 
-    return query.exec();
+    if (query.numRowsAffected() > 0) {
+        propertyMatrix.setValue(materialName, propertyIds.value(propertyName), -1, -1, value);
+    }
+    return true;
 }
 
 bool Database::removeMaterialProperty(const QString &materialName,
                                       const QString &propertyName)
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("DELETE FROM material_properties "
-                  "WHERE material_name = :material_name AND property_name = :property_name");
+                  "WHERE material_id = (SELECT id FROM materials WHERE name = :material_name) "
+                  "AND property_id = :property_id");
     query.bindValue(":material_name", materialName);
-    query.bindValue(":property_name", propertyName);
+    query.bindValue(":property_id", propertyIds.value(propertyName, -1));
 
-    return query.exec();
+    if (!exec(query)) {
+        return false;
+    }
+
+    propertyMatrix.removeValue(materialName, propertyIds.value(propertyName, -1));
+    return true;
 }
 
 QList<QPair<QString, double>> Database::getMaterialProperties(const QString &materialName)
 {
     QList<QPair<QString, double>> properties;
-    QSqlQuery query;
+    QSqlQuery query(db);
 
-    query.prepare("SELECT property_name, value FROM material_properties "
-                  "WHERE material_name = :material_name ORDER BY property_name");
+    query.prepare("SELECT p.name, mp.value FROM material_properties mp "
+                  "JOIN properties p ON p.id = mp.property_id "
+                  "WHERE mp.material_id = (SELECT id FROM materials WHERE name = :material_name) "
+                  "ORDER BY p.name");
     query.bindValue(":material_name", materialName);
 
-    if (query.exec()) {
+    if (exec(query)) {
         while (query.next()) {
             properties.append(qMakePair(query.value(0).toString(),
                                         query.value(1).toDouble()));
@@ -194,16 +762,16 @@ QList<QPair<QString, double>> Database::getMaterialProperties(const QString &mat
 QMap<QString, QPair<QString, double>> Database::getMaterialPropertiesWithUnits(const QString &materialName)
 {
     QMap<QString, QPair<QString, double>> properties;
-    QSqlQuery query;
+    QSqlQuery query(db);
 
-    query.prepare("SELECT property_name, unit, value FROM material_properties "
-                  "WHERE material_name = :material_name ORDER BY property_name");
+    query.prepare("SELECT property_id, unit_id, value FROM material_properties "
+                  "WHERE material_id = (SELECT id FROM materials WHERE name = :material_name)");
     query.bindValue(":material_name", materialName);
 
-    if (query.exec()) {
+    if (exec(query)) {
         while (query.next()) {
-            QString propertyName = query.value(0).toString();
-            QString unit = query.value(1).toString();
+            QString propertyName = propertyNames.value(query.value(0).toInt());
+            QString unit = unitNames.value(query.value(1).toInt());
             double value = query.value(2).toDouble();
             properties[propertyName] = qMakePair(unit, value);
         }
@@ -212,22 +780,131 @@ QMap<QString, QPair<QString, double>> Database::getMaterialPropertiesWithUnits(c
     return properties;
 }
 
+bool Database::addMaterialPropertyCurve(const QString &materialName,
+                                        const QString &propertyName,
+                                        const QString &unit,
+                                        const PropertyCurve &curve)
+{
+    if (curve.isEmpty()) {
+        return false;
+    }
+
+    // Точки кривой, как и скалярные значения, хранятся в СИ
+    const UnitRegistry &registry = UnitRegistry::instance();
+    UnitConversion parameterConversion = registry.lookup(curve.parameterUnit);
+    UnitConversion valueConversion = registry.lookup(unit);
+
+    QVector<double> abscissa = curve.abscissa();
+    QVector<double> ordinate = curve.ordinate();
+    if (parameterConversion.known && !parameterConversion.isIdentity()) {
+        for (double &x : abscissa) {
+            x = parameterConversion.toSI(x);
+        }
+    }
+    if (valueConversion.known && !valueConversion.isIdentity()) {
+        for (double &y : ordinate) {
+            y = valueConversion.toSI(y);
+        }
+    }
+
+    int propertyId = ensurePropertyId(propertyName);
+    int parameterId = ensurePropertyId(curve.parameterName.isEmpty() ? QString("Temperature")
+                                                                      : curve.parameterName);
+    int parameterUnitId = ensureUnitId(parameterConversion.known ? parameterConversion.siUnit
+                                                                 : curve.parameterUnit);
+    if (propertyId < 0 || parameterId < 0 || parameterUnitId < 0) {
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR REPLACE INTO material_property_curves "
+                  "(material_id, property_id, parameter_id, parameter_unit_id, abscissa, ordinate) "
+                  "SELECT id, :property_id, :parameter_id, :parameter_unit_id, :abscissa, :ordinate "
+                  "FROM materials WHERE name = :material_name");
+    query.bindValue(":property_id", propertyId);
+    query.bindValue(":parameter_id", parameterId);
+    query.bindValue(":parameter_unit_id", parameterUnitId);
+    query.bindValue(":abscissa", PropertyCurve::toBlob(abscissa));
+    query.bindValue(":ordinate", PropertyCurve::toBlob(ordinate));
+    query.bindValue(":material_name", materialName);
+
+    if (!exec(query)) {
+        qDebug() << "Error adding property curve:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+PropertyCurve Database::getMaterialPropertyCurve(const QString &materialName,
+                                                 const QString &propertyName)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT parameter_id, parameter_unit_id, abscissa, ordinate "
+                  "FROM material_property_curves "
+                  "WHERE material_id = (SELECT id FROM materials WHERE name = :material_name) "
+                  "AND property_id = :property_id");
+    query.bindValue(":material_name", materialName);
+    query.bindValue(":property_id", propertyIds.value(propertyName, -1));
+
+    if (!exec(query) || !query.next()) {
+        return PropertyCurve();
+    }
+
+    PropertyCurve curve(PropertyCurve::fromBlob(query.value(2).toByteArray()),
+                        PropertyCurve::fromBlob(query.value(3).toByteArray()));
+    curve.parameterName = propertyNames.value(query.value(0).toInt());
+    curve.parameterUnit = unitNames.value(query.value(1).toInt());
+    return curve;
+}
+
+QStringList Database::getMaterialCurveProperties(const QString &materialName)
+{
+    QStringList properties;
+    QSqlQuery query(db);
+
+    query.prepare("SELECT property_id FROM material_property_curves "
+                  "WHERE material_id = (SELECT id FROM materials WHERE name = :material_name)");
+    query.bindValue(":material_name", materialName);
+
+    if (exec(query)) {
+        while (query.next()) {
+            properties.append(propertyNames.value(query.value(0).toInt()));
+        }
+    }
+
+    properties.sort();
+    return properties;
+}
+
 QMap<QString, QMap<QString, QPair<QString, double>>> Database::getAllMaterialsWithProperties()
 {
     QMap<QString, QMap<QString, QPair<QString, double>>> allMaterials;
 
-    QSqlQuery query("SELECT m.name, mp.property_name, mp.unit, mp.value "
-                    "FROM materials m "
-                    "LEFT JOIN material_properties mp ON m.name = mp.material_name "
-                    "ORDER BY m.name, mp.property_name");
+    // Имена материалов читаем один раз, строки свойств - только целые ключи
+    QHash<int, QString> materialNames;
+    QSqlQuery query(db);
+
+    if (!exec(query, "SELECT id, name FROM materials")) {
+        qDebug() << "Error getting materials:" << query.lastError().text();
+        return allMaterials;
+    }
+    while (query.next()) {
+        materialNames.insert(query.value(0).toInt(), query.value(1).toString());
+    }
+
+    query.setForwardOnly(true);
+    if (!exec(query, "SELECT material_id, property_id, unit_id, value FROM material_properties")) {
+        qDebug() << "Error getting material properties:" << query.lastError().text();
+        return allMaterials;
+    }
 
     while (query.next()) {
-        QString materialName = query.value(0).toString();
-        QString propertyName = query.value(1).toString();
-        QString unit = query.value(2).toString();
+        const QString materialName = materialNames.value(query.value(0).toInt());
+        const QString propertyName = propertyNames.value(query.value(1).toInt());
+        const QString unit = unitNames.value(query.value(2).toInt());
         double value = query.value(3).toDouble();
 
-        if (!propertyName.isEmpty()) {
+        if (!materialName.isEmpty() && !propertyName.isEmpty()) {
             allMaterials[materialName][propertyName] = qMakePair(unit, value);
         }
     }
@@ -237,55 +914,73 @@ QMap<QString, QMap<QString, QPair<QString, double>>> Database::getAllMaterialsWi
 
 bool Database::addModel(const QString &name)
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("INSERT OR IGNORE INTO models (name) VALUES (:name)");
     query.bindValue(":name", name);
-    return query.exec();
+    return exec(query);
 }
 
 bool Database::removeModel(const QString &name)
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("DELETE FROM models WHERE name = :name");
     query.bindValue(":name", name);
-    return query.exec();
+    if (!exec(query)) {
+        return false;
+    }
+
+    // Результаты модели удалены каскадно
+    emit resultsChanged(name, QString());
+    return true;
 }
 
 QList<QString> Database::getAllModels()
 {
     QList<QString> models;
-    QSqlQuery query("SELECT name FROM models ORDER BY name");
+    QSqlQuery query("SELECT name FROM models ORDER BY name", db);
     while (query.next()) {
         models.append(query.value(0).toString());
     }
     return models;
 }
 
-bool Database::addCalculationType(const QString &name, const QString &unit)
+bool Database::addCalculationType(const QString &name, const QString &unit,
+                                  const QString &displayUnit)
 {
-    QSqlQuery query;
-    query.prepare("INSERT OR IGNORE INTO calculation_types (name, unit) VALUES (:name, :unit)");
-    query.bindValue(":name", name);
-    query.bindValue(":unit", unit);
-    return query.exec();
+    QSqlQuery query(db);
+    query.prepare(UpsertCalculationTypeSql);
+    query.bindValue(0, name);
+    query.bindValue(1, unit);
+    query.bindValue(2, displayUnit.isEmpty() ? unit : displayUnit);
+    return exec(query);
 }
 
 QList<QPair<QString, QString>> Database::getAllCalculationTypes()
 {
     QList<QPair<QString, QString>> types;
-    QSqlQuery query("SELECT name, unit FROM calculation_types ORDER BY name");
+    QSqlQuery query("SELECT name, unit FROM calculation_types ORDER BY name", db);
     while (query.next()) {
         types.append(qMakePair(query.value(0).toString(), query.value(1).toString()));
     }
     return types;
 }
 
+QHash<QString, QString> Database::getCalculationTypeDisplayUnits()
+{
+    QHash<QString, QString> units;
+    QSqlQuery query("SELECT name, COALESCE(display_unit, unit) FROM calculation_types", db);
+    while (query.next()) {
+        units.insert(query.value(0).toString(), query.value(1).toString());
+    }
+    return units;
+}
+
 bool Database::addCalculationResult(const QString &modelName,
                                     const QString &nodeNumber,
                                     const QString &calculationTypeName,
                                     double value)
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("INSERT OR REPLACE INTO calculation_results "
                   "(model_name, node_number, calculation_type_name, value) "
                   "VALUES (:model_name, :node_number, :calculation_type_name, :value)");
@@ -293,100 +988,718 @@ bool Database::addCalculationResult(const QString &modelName,
     query.bindValue(":node_number", nodeNumber);
     query.bindValue(":calculation_type_name", calculationTypeName);
     query.bindValue(":value", value);
-    return query.exec();
+    if (!exec(query)) {
+        return false;
+    }
+
+    emit resultsChanged(modelName, calculationTypeName);
+    return true;
+}
+
+QList<QPair<QString, QString>> Database::getResultSets()
+{
+    BD_METRIC_LATENCY("Database::getResultSets");
+    QList<QPair<QString, QString>> resultSets;
+    QSqlQuery query(db);
+    if (!exec(query, "SELECT DISTINCT model_name, calculation_type_name FROM calculation_results "
+                    "ORDER BY model_name, calculation_type_name")) {
+        qDebug() << "Error reading result sets:" << query.lastError().text();
+        return resultSets;
+    }
+
+    while (query.next()) {
+        resultSets.append(qMakePair(query.value(0).toString(), query.value(1).toString()));
+    }
+    return resultSets;
+}
+
+int Database::removeCalculationResults(const QString &modelName, const QString &calculationType)
+{
+    BD_METRIC_LATENCY("Database::removeCalculationResults");
+    QStringList conditions;
+    if (!modelName.isEmpty()) {
+        conditions << "model_name = :model_name";
+    }
+    if (!calculationType.isEmpty()) {
+        conditions << "calculation_type_name = :calculation_type";
+    }
+
+    QString sql = "DELETE FROM calculation_results";
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+
+    QSqlQuery query(db);
+    query.prepare(sql);
+    if (!modelName.isEmpty()) {
+        query.bindValue(":model_name", modelName);
+    }
+    if (!calculationType.isEmpty()) {
+        query.bindValue(":calculation_type", calculationType);
+    }
+
+    if (!exec(query)) {
+        qDebug() << "Error removing calculation results:" << query.lastError().text();
+        return -1;
+    }
+
+    emit resultsChanged(modelName, calculationType);
+    return query.numRowsAffected();
 }
 
 QList<QVector<QVariant>> Database::getCalculationResults(const QString &modelName)
 {
+    ResultFilter filter;
+    filter.modelName = modelName;
+
     QList<QVector<QVariant>> results;
-    QSqlQuery query;
+    queryCalculationResults(filter, results);
+    return results;
+}
 
-    if (modelName.isEmpty()) {
-        query.exec("SELECT model_name, node_number, calculation_type_name, value "
-                   "FROM calculation_results "
-                   "ORDER BY model_name, node_number, calculation_type_name");
-    } else {
-        query.prepare("SELECT model_name, node_number, calculation_type_name, value "
-                      "FROM calculation_results "
-                      "ORDER BY node_number, calculation_type_name");
-        query.bindValue(":model_name", modelName);
-        query.exec();
+bool Database::prepareResultQuery(QSqlQuery &query, const QString &columns,
+                                  const ResultFilter &filter, const QString &tail)
+{
+    QStringList conditions;
+    if (!filter.modelName.isEmpty()) {
+        conditions << "model_name = :model_name";
+    }
+    if (!filter.calculationType.isEmpty()) {
+        conditions << "calculation_type_name = :calculation_type";
+    }
+    if (std::isfinite(filter.minimum)) {
+        conditions << "value >= :minimum";
+    }
+    if (std::isfinite(filter.maximum)) {
+        conditions << "value <= :maximum";
+    }
+
+    QString sql = "SELECT " + columns + " FROM calculation_results";
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+    sql += " " + tail;
+
+    // Строки читаются по одной, без кэша прокрутки назад
+    query.setForwardOnly(true);
+    if (!query.prepare(sql)) {
+        qDebug() << "Error preparing results query:" << query.lastError().text();
+        return false;
+    }
+
+    if (!filter.modelName.isEmpty()) {
+        query.bindValue(":model_name", filter.modelName);
+    }
+    if (!filter.calculationType.isEmpty()) {
+        query.bindValue(":calculation_type", filter.calculationType);
+    }
+    if (std::isfinite(filter.minimum)) {
+        query.bindValue(":minimum", filter.minimum);
+    }
+    if (std::isfinite(filter.maximum)) {
+        query.bindValue(":maximum", filter.maximum);
+    }
+    return true;
+}
+
+QueryOutcome Database::finishQuery(const QSqlQuery &query, const CancellationToken &token, qint64 rows)
+{
+    QueryOutcome outcome;
+    outcome.rows = rows;
+
+    // Прерванный SQLite запрос выглядит как ошибка - отличаем его по токену
+    if (token.isCancelled()) {
+        outcome.status = QueryStatus::Cancelled;
+    } else if (query.lastError().isValid()) {
+        outcome.status = QueryStatus::Failed;
+        outcome.error = query.lastError().text();
+        qDebug() << "Error reading calculation results:" << outcome.error;
+    }
+    return outcome;
+}
+
+QueryOutcome Database::forEachCalculationResult(const ResultFilter &filter,
+                                                const std::function<bool(const QString &, const QString &,
+                                                                         const QString &, double)> &visit,
+                                                const CancellationToken &token)
+{
+    BD_TRACE_SCOPE("sql", "Database::forEachCalculationResult");
+    BD_METRIC_LATENCY("Database::forEachCalculationResult");
+    QueryOutcome outcome;
+    if (token.isCancelled()) {
+        outcome.status = QueryStatus::Cancelled;
+        return outcome;
+    }
+
+    QueryCancellationScope cancellation(db, token);
+
+    // Лишняя строка сверх limit показывает, что результат неполон
+    QString tail = "ORDER BY model_name, node_number, calculation_type_name";
+    if (filter.limit >= 0) {
+        tail += QString(" LIMIT %1").arg(filter.limit + 1);
+    }
+
+    QSqlQuery query(db);
+    if (!prepareResultQuery(query, "model_name, node_number, calculation_type_name, value", filter, tail)) {
+        outcome.status = QueryStatus::Failed;
+        outcome.error = query.lastError().text();
+        return outcome;
+    }
+
+    // Время самого запроса: exec() и next(), без обработчика строк
+    qint64 statementNs = 0;
+    QElapsedTimer timer;
+    timer.start();
+    if (!query.exec()) {
+        return finishQuery(query, token, 0);
+    }
+    statementNs += timer.nsecsElapsed();
+
+    qint64 rows = 0;
+    bool partial = false;
+    forever {
+        timer.restart();
+        const bool hasRow = query.next();
+        statementNs += timer.nsecsElapsed();
+        if (!hasRow) {
+            break;
+        }
+
+        if (filter.limit >= 0 && rows >= filter.limit) {
+            partial = true;
+            break;
+        }
+
+        // Без обработчика SQLite отмена срабатывает здесь, между строками
+        if ((rows & 255) == 0 && token.isCancelled()) {
+            break;
+        }
+
+        rows++;
+        if (!visit(query.value(0).toString(), query.value(1).toString(),
+                   query.value(2).toString(), query.value(3).toDouble())) {
+            partial = true;
+            break;
+        }
+    }
+
+    // У перебора без сортировки время запроса почти все в next()
+    checkSlowStatement(query, statementNs / 1000);
+
+    if (partial) {
+        outcome.status = QueryStatus::Partial;
+        outcome.rows = rows;
+        return outcome;
+    }
+    return finishQuery(query, token, rows);
+}
+
+QueryOutcome Database::queryCalculationResults(const ResultFilter &filter,
+                                               QList<QVector<QVariant>> &rows,
+                                               const CancellationToken &token)
+{
+    rows.clear();
+    return forEachCalculationResult(filter,
+        [&rows](const QString &modelName, const QString &nodeNumber,
+                const QString &calculationType, double value) {
+            rows.append({modelName, nodeNumber, calculationType, value});
+            return true;
+        }, token);
+}
+
+QueryOutcome Database::queryResultBlock(const ResultFilter &filter, ResultBlock &block,
+                                        const CancellationToken &token)
+{
+    block = ResultBlock();
+    QueryOutcome outcome = forEachCalculationResult(filter,
+        [&block](const QString &modelName, const QString &nodeNumber,
+                 const QString &calculationType, double value) {
+            block.append(modelName, nodeNumber, calculationType, value);
+            return true;
+        }, token);
+    block.squeeze();
+    return outcome;
+}
+
+QueryOutcome Database::summarizeCalculationResults(const ResultFilter &filter,
+                                                   QList<ResultSummary> &summaries,
+                                                   const CancellationToken &token)
+{
+    BD_TRACE_SCOPE("sql", "Database::summarizeCalculationResults");
+    BD_METRIC_LATENCY("Database::summarizeCalculationResults");
+    summaries.clear();
+
+    QueryOutcome outcome;
+    if (token.isCancelled()) {
+        outcome.status = QueryStatus::Cancelled;
+        return outcome;
+    }
+
+    // Агрегат считается внутри SQLite до первой строки - прервать его может только обработчик
+    QueryCancellationScope cancellation(db, token);
+
+    QSqlQuery query(db);
+    if (!prepareResultQuery(query,
+                            "calculation_type_name, COUNT(*), MIN(value), MAX(value), AVG(value)",
+                            filter, "GROUP BY calculation_type_name ORDER BY calculation_type_name")) {
+        outcome.status = QueryStatus::Failed;
+        outcome.error = query.lastError().text();
+        return outcome;
+    }
+
+    if (!exec(query)) {
+        return finishQuery(query, token, 0);
     }
 
     while (query.next()) {
-        QVector<QVariant> row;
-        for (int i = 0; i < 5; ++i) {
-            row.append(query.value(i));
+        ResultSummary summary;
+        summary.calculationType = query.value(0).toString();
+        summary.count = query.value(1).toLongLong();
+        summary.minimum = query.value(2).toDouble();
+        summary.maximum = query.value(3).toDouble();
+        summary.mean = query.value(4).toDouble();
+        summaries.append(summary);
+    }
+
+    outcome = finishQuery(query, token, summaries.size());
+    if (outcome.isCancelled()) {
+        summaries.clear();
+    }
+    return outcome;
+}
+
+int Database::addCalculationResults(const QList<QPair<QString, ParsedData>> &batch)
+{
+    if (!beginResultsBatch()) {
+        return -1;
+    }
+
+    int count = appendCalculationResults(batch);
+    if (count < 0) {
+        rollbackResultsBatch();
+        return -1;
+    }
+
+    return commitResultsBatch() ? count : -1;
+}
+
+bool Database::beginResultsBatch()
+{
+    pendingResultSets.clear();
+    if (!db.transaction()) {
+        qDebug() << "Error starting results transaction:" << db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+int Database::appendCalculationResults(const QList<QPair<QString, ParsedData>> &batch)
+{
+    BD_TRACE_SCOPE("sql", "Database::appendCalculationResults");
+    BD_METRIC_LATENCY("Database::appendCalculationResults");
+    QSqlQuery modelQuery(db);
+    modelQuery.prepare("INSERT OR IGNORE INTO models (name) VALUES (?)");
+
+    QSqlQuery typeQuery(db);
+    typeQuery.prepare(UpsertCalculationTypeSql);
+
+    QSqlQuery unitQuery(db);
+    unitQuery.prepare("SELECT unit FROM calculation_types WHERE name = ?");
+    QHash<QString, QString> storedUnits;
+
+    QSqlQuery resultQuery(db);
+    resultQuery.prepare("INSERT OR REPLACE INTO calculation_results "
+                        "(model_name, node_number, calculation_type_name, value) "
+                        "VALUES (?, ?, ?, ?)");
+
+    int count = 0;
+    for (const auto &entry : batch) {
+        const QString &modelName = entry.first;
+        const ParsedData &data = entry.second;
+
+        typeQuery.bindValue(0, data.calculationType);
+        typeQuery.bindValue(1, data.unit);
+        typeQuery.bindValue(2, data.sourceUnit.isEmpty() ? data.unit : data.sourceUnit);
+        if (!exec(typeQuery)) {
+            qDebug() << "Error adding calculation type:" << typeQuery.lastError().text();
+            return -1;
+        }
+
+        // Значения вида расчета хранятся в одной единице - файл с другой не смешиваем
+        auto stored = storedUnits.constFind(data.calculationType);
+        if (stored == storedUnits.constEnd() || stored.value() != data.unit) {
+            unitQuery.bindValue(0, data.calculationType);
+            if (!exec(unitQuery) || !unitQuery.next()) {
+                qDebug() << "Error reading calculation type unit:" << unitQuery.lastError().text();
+                return -1;
+            }
+            stored = storedUnits.insert(data.calculationType, unitQuery.value(0).toString());
+            unitQuery.finish();
+        }
+        if (stored.value() != data.unit) {
+            qDebug() << "Unit mismatch, file skipped:" << modelName << data.calculationType
+                     << "stored in" << stored.value() << "file in" << data.unit;
+            continue;
+        }
+
+        modelQuery.bindValue(0, modelName);
+        if (!exec(modelQuery)) {
+            qDebug() << "Error adding model:" << modelQuery.lastError().text();
+            return -1;
+        }
+
+        pendingResultSets.insert(qMakePair(modelName, data.calculationType));
+
+        BD_TRACE_DETAIL("sql", "Database::bindResultFile");
+        for (auto it = data.nodeValues.constBegin(); it != data.nodeValues.constEnd(); ++it) {
+            resultQuery.bindValue(0, modelName);
+            resultQuery.bindValue(1, it.key());
+            resultQuery.bindValue(2, data.calculationType);
+            resultQuery.bindValue(3, it.value());
+
+            if (!exec(resultQuery)) {
+                qDebug() << "Error adding calculation result:" << resultQuery.lastError().text();
+                return -1;
+            }
+            count++;
         }
-        results.append(row);
     }
 
-    return results;
+    Metrics::instance().addWrittenRows(count);
+    return count;
 }
 
-bool Database::importMaterialsFromMatML(const QList<QMap<QString, QVariant>> &materials)
+bool Database::commitResultsBatch()
+{
+    BD_TRACE_SCOPE("sql", "Database::commitResultsBatch");
+    BD_METRIC_LATENCY("Database::commitResultsBatch");
+    if (!db.commit()) {
+        qDebug() << "Error committing results:" << db.lastError().text();
+        db.rollback();
+        pendingResultSets.clear();
+        return false;
+    }
+
+    // Об изменениях сообщаем только после фиксации - до нее их не видят другие соединения
+    const QSet<QPair<QString, QString>> changed = pendingResultSets;
+    pendingResultSets.clear();
+    for (const auto &resultSet : changed) {
+        emit resultsChanged(resultSet.first, resultSet.second);
+    }
+    return true;
+}
+
+void Database::rollbackResultsBatch()
+{
+    db.rollback();
+    pendingResultSets.clear();
+}
+
+bool Database::exec(QSqlQuery &query)
+{
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = query.exec();
+    checkSlowStatement(query, timer.nsecsElapsed() / 1000);
+    return ok;
+}
+
+bool Database::exec(QSqlQuery &query, const QString &sql)
+{
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = query.exec(sql);
+    checkSlowStatement(query, timer.nsecsElapsed() / 1000);
+    return ok;
+}
+
+void Database::checkSlowStatement(const QSqlQuery &query, qint64 elapsedUs)
+{
+    SlowQueryLog &log = SlowQueryLog::instance();
+    if (!log.isSlow(elapsedUs)) {
+        return;
+    }
+
+    SlowQuery slow;
+    slow.time = QDateTime::currentDateTime();
+    slow.connection = connection;
+    slow.sql = query.lastQuery().simplified();
+    slow.elapsedUs = elapsedUs;
+
+    const QVariantList values = query.boundValues();
+    for (const QVariant &value : values) {
+        slow.parameters.append(value.typeId() == QMetaType::QString ? "'" + value.toString() + "'"
+                                                                   : value.toString());
+    }
+
+    slow.plan = explainQueryPlan(query.lastQuery(), values);
+    for (const QString &step : slow.plan) {
+        // "SCAN calculation_results" - полный проход; "SCAN ... USING INDEX" - по индексу
+        const QString trimmed = step.trimmed();
+        if (trimmed.startsWith("SCAN") && !trimmed.contains("INDEX")) {
+            slow.fullScan = true;
+        }
+    }
+
+    qDebug() << "Slow query" << elapsedUs / 1000 << "ms" << (slow.fullScan ? "(full scan):" : ":")
+             << slow.sql << slow.parameters;
+    log.add(slow);
+}
+
+QStringList Database::explainQueryPlan(const QString &sql, const QVariantList &values)
+{
+    // План есть только у DML; PRAGMA, CREATE, транзакции пропускаем
+    static const QRegularExpression dml("^\\s*(SELECT|INSERT|UPDATE|DELETE|REPLACE|WITH)\\b",
+                                        QRegularExpression::CaseInsensitiveOption);
+    QStringList plan;
+    if (!dml.match(sql).hasMatch()) {
+        return plan;
+    }
+
+    QSqlQuery explain(db);
+    if (!explain.prepare("EXPLAIN QUERY PLAN " + sql)) {
+        return plan;
+    }
+    for (int i = 0; i < values.size(); ++i) {
+        explain.bindValue(i, values[i]);
+    }
+    if (!explain.exec()) {
+        return plan;
+    }
+
+    // Столбцы: id, parent, notused, detail; отступ - по глубине вложенности
+    QHash<int, int> depth;
+    while (explain.next()) {
+        int id = explain.value(0).toInt();
+        int level = depth.value(explain.value(1).toInt(), -1) + 1;
+        depth.insert(id, level);
+        plan.append(QString(level * 2, ' ') + explain.value(3).toString());
+    }
+    return plan;
+}
+
+SqliteStats Database::sqliteStats()
 {
-    QSqlDatabase::database().transaction();
+    SqliteStats stats;
 
-    try {
+    // Мимо журнала медленных запросов: вкладка диагностики опрашивает это каждую секунду
+    auto pragma = [this](const QString &name) -> qint64 {
         QSqlQuery query(db);
+        if (!query.exec("PRAGMA " + name) || !query.next()) {
+            return -1;
+        }
+        return query.value(0).toLongLong();
+    };
+
+    stats.pageSize = pragma("page_size");
+    stats.pageCount = pragma("page_count");
+    stats.freePages = pragma("freelist_count");
+
+    // cache_size > 0 - в страницах, < 0 - в КиБ
+    qint64 cacheSize = pragma("cache_size");
+    if (cacheSize > 0 && stats.pageSize > 0) {
+        stats.cacheCapacityBytes = cacheSize * stats.pageSize;
+    } else if (cacheSize < 0) {
+        stats.cacheCapacityBytes = -cacheSize * 1024;
+    }
 
-        for (const QMap<QString, QVariant> &materialData : materials) {
-            QString materialName = materialData["name"].toString();
+#ifdef BD_SQLITE_NATIVE_CANCEL
+    if (sqlite3 *handle = sqliteHandle(db)) {
+        auto status = [handle](int op) -> qint64 {
+            int current = 0;
+            int highwater = 0;
+            return sqlite3_db_status(handle, op, &current, &highwater, 0) == SQLITE_OK ? current : -1;
+        };
+        stats.cacheUsedBytes = status(SQLITE_DBSTATUS_CACHE_USED);
+        stats.cacheHits = status(SQLITE_DBSTATUS_CACHE_HIT);
+        stats.cacheMisses = status(SQLITE_DBSTATUS_CACHE_MISS);
+        stats.cacheWrites = status(SQLITE_DBSTATUS_CACHE_WRITE);
+    }
+#endif
 
-            if (materialName.isEmpty()) {
-                continue;
-            }
+    return stats;
+}
+
+bool Database::addParsedMaterial(const ParsedMaterial &material)
+{
+    if (material.name.isEmpty()) {
+        return false;
+    }
 
-            // Добавляем материал
-            query.prepare("INSERT OR IGNORE INTO materials (name) VALUES (?)");
-            query.bindValue(0, materialName);
-            query.exec();
-
-            // Добавляем свойства
-            QMap<QString, QVariant> properties = materialData["properties"].toMap();
-
-            for (auto it = properties.begin(); it != properties.end(); ++it) {
-                QString propertyName = it.key();
-                QVariant propertyData = it.value();
-
-                if (propertyData.typeId() == QMetaType::QVariantMap) {
-                    QMap<QString, QVariant> propMap = propertyData.toMap();
-                    QString unit = propMap["unit"].toString();
-                    double value = propMap["value"].toDouble();
-
-                    query.prepare("INSERT OR REPLACE INTO material_properties "
-                                  "(property_name, material_name, unit, value) "
-                                  "VALUES (?, ?, ?, ?)");
-                    query.bindValue(0, propertyName);
-                    query.bindValue(1, materialName);
-                    query.bindValue(2, unit.isEmpty() ? "dimensionless" : unit);
-                    query.bindValue(3, value);
-                    query.exec();
-                } else {
-                    // Если свойство - просто значение
-                    double value = propertyData.toDouble();
-
-                    query.prepare("INSERT OR REPLACE INTO material_properties "
-                                  "(property_name, material_name, unit, value) "
-                                  "VALUES (?, ?, ?, ?)");
-                    query.bindValue(0, propertyName);
-                    query.bindValue(1, materialName);
-                    query.bindValue(2, "dimensionless");
-                    query.bindValue(3, value);
-                    query.exec();
+    // Добавляем материал
+    if (!addMaterial(material.name)) {
+        return false;
+    }
+
+    // Добавляем свойства
+    for (auto it = material.meta.begin(); it != material.meta.end(); ++it) {
+        QString propertyId = it.key();
+        PropertyMeta meta = it.value();
+
+        if (meta.name.isEmpty()) {
+            continue;
+        }
+
+        // Получаем значение
+        double value = 0.0;
+        if (material.values.contains(propertyId)) {
+            value = material.values[propertyId];
+        } else {
+            // Пробуем найти значение по имени
+            for (auto valueIt = material.values.begin(); valueIt != material.values.end(); ++valueIt) {
+                QString valueKey = valueIt.key();
+                if (valueKey.contains(meta.name) || meta.name.contains(valueKey)) {
+                    value = valueIt.value();
+                    break;
                 }
             }
         }
 
-        QSqlDatabase::database().commit();
-        return true;
+        // Добавляем свойство с значением
+        if (!addMaterialProperty(material.name, meta.name, meta.unit, value)) {
+            qDebug() << "Failed to add property:" << meta.name << "for material:" << material.name;
+            return false;
+        }
 
-    } catch (...) {
-        QSqlDatabase::database().rollback();
-        qDebug() << "Error importing materials, transaction rolled back";
+        // Зависимость от температуры (или другого параметра), если она есть
+        auto curveIt = material.curves.constFind(propertyId);
+        if (curveIt != material.curves.constEnd()
+            && curveIt->ordinate.size() > 1
+            && curveIt->ordinate.size() == curveIt->abscissa.size()) {
+            PropertyCurve curve(curveIt->abscissa, curveIt->ordinate);
+            PropertyMeta parameter = material.parameters.value(curveIt->parameterId);
+            curve.parameterName = parameter.name;
+            curve.parameterUnit = parameter.unit;
+
+            if (!addMaterialPropertyCurve(material.name, meta.name, meta.unit, curve)) {
+                qDebug() << "Failed to add curve:" << meta.name << "for material:" << material.name;
+                return false;
+            }
+        }
+    }
+
+    // Добавляем свойство Isotropic
+    if (material.isotropic && !addMaterialProperty(material.name, "Isotropic", "dimensionless", 1.0)) {
+        qDebug() << "Failed to add property: Isotropic for material:" << material.name;
+        return false;
+    }
+
+    return true;
+}
+
+bool Database::importParsedMaterials(const QList<ParsedMaterial> &materials)
+{
+    BD_TRACE_SCOPE("sql", "Database::importParsedMaterials");
+    BD_METRIC_LATENCY("Database::importParsedMaterials");
+    if (!db.transaction()) {
+        qDebug() << "Error starting materials transaction:" << db.lastError().text();
         return false;
     }
+
+    for (const ParsedMaterial &material : materials) {
+        if (!material.isEmpty() && !addParsedMaterial(material)) {
+            qDebug() << "Error importing material:" << material.name;
+            rollbackTransaction();
+            propertyMatrix.invalidateAll();
+            emit materialsReset();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Error committing materials:" << db.lastError().text();
+        rollbackTransaction();
+        propertyMatrix.invalidateAll();
+        emit materialsReset();
+        return false;
+    }
+    return true;
+}
+
+bool Database::importMaterialsFromMatML(const QList<QMap<QString, QVariant>> &materials)
+{
+    if (!db.transaction()) {
+        qDebug() << "Error starting materials transaction:" << db.lastError().text();
+        return false;
+    }
+
+    QStringList importedNames;
+    QStringList addedNames;
+    QSqlQuery materialQuery(db);
+    materialQuery.prepare("INSERT OR IGNORE INTO materials (name) VALUES (?)");
+
+    QSqlQuery propertyQuery(db);
+    propertyQuery.prepare("INSERT OR REPLACE INTO material_properties "
+                          "(material_id, property_id, unit_id, value, display_unit_id) "
+                          "SELECT id, ?, ?, ?, ? FROM materials WHERE name = ?");
+    const UnitRegistry &registry = UnitRegistry::instance();
+
+    for (const QMap<QString, QVariant> &materialData : materials) {
+        QString materialName = materialData["name"].toString();
+
+        if (materialName.isEmpty()) {
+            continue;
+        }
+
+        // Добавляем материал
+        importedNames.append(materialName);
+        materialQuery.bindValue(0, materialName);
+        if (!exec(materialQuery)) {
+            qDebug() << "Error importing material:" << materialQuery.lastError().text();
+            rollbackTransaction();
+            return false;
+        }
+        if (materialQuery.numRowsAffected() > 0) {
+            addedNames.append(materialName);
+        }
+
+        // Добавляем свойства
+        QMap<QString, QVariant> properties = materialData["properties"].toMap();
+
+        for (auto it = properties.begin(); it != properties.end(); ++it) {
+            QVariant propertyData = it.value();
+            QString unit;
+            double value = 0.0;
+
+            if (propertyData.typeId() == QMetaType::QVariantMap) {
+                QMap<QString, QVariant> propMap = propertyData.toMap();
+                unit = propMap["unit"].toString();
+                value = propMap["value"].toDouble();
+            } else {
+                // Если свойство - просто значение
+                value = propertyData.toDouble();
+            }
+
+            UnitConversion conversion = registry.lookup(unit);
+            int displayUnitId = ensureUnitId(unit);
+
+            propertyQuery.bindValue(0, ensurePropertyId(it.key()));
+            propertyQuery.bindValue(1, conversion.known ? ensureUnitId(conversion.siUnit) : displayUnitId);
+            propertyQuery.bindValue(2, conversion.known ? conversion.toSI(value) : value);
+            propertyQuery.bindValue(3, displayUnitId);
+            propertyQuery.bindValue(4, materialName);
+
+            if (!exec(propertyQuery)) {
+                qDebug() << "Error importing property:" << propertyQuery.lastError().text();
+                rollbackTransaction();
+                return false;
+            }
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Error committing materials:" << db.lastError().text();
+        rollbackTransaction();
+        return false;
+    }
+
+    for (const QString &name : importedNames) {
+        propertyMatrix.invalidateMaterial(name);
+    }
+    for (const QString &name : addedNames) {
+        emit materialAdded(name);
+    }
+    return true;
 }
 
 bool Database::clearAllMaterials()
@@ -394,16 +1707,18 @@ bool Database::clearAllMaterials()
     QSqlQuery query(db);
 
     // Включаем каскадное удаление
-    if (!query.exec("PRAGMA foreign_keys = ON")) {
+    if (!exec(query, "PRAGMA foreign_keys = ON")) {
         qDebug() << "Failed to enable foreign keys:" << query.lastError().text();
         return false;
     }
 
     // Удаляем все материалы (каскадно удалятся их свойства)
-    if (!query.exec("DELETE FROM materials")) {
+    if (!exec(query, "DELETE FROM materials")) {
         qDebug() << "Failed to clear materials:" << query.lastError().text();
         return false;
     }
 
+    propertyMatrix.invalidateAll();
+    emit materialsReset();
     return true;
 }
@@ -8,6 +8,64 @@
 #include <QFile>
 #include <QDebug>
 #include <QMap>
+#include <QHash>
+#include <QSet>
+#include <functional>
+#include <limits>
+#include "cancellationtoken.h"
+#include "materialpropertymatrix.h"
+#include "propertycurve.h"
+#include "resultblock.h"
+#include "fileparser.h"
+#include "materialparser.h"
+
+// Фильтр запроса результатов; пустые строки и бесконечные границы - без ограничения
+struct ResultFilter {
+    QString modelName;
+    QString calculationType;
+    double minimum = -std::numeric_limits<double>::infinity();
+    double maximum = std::numeric_limits<double>::infinity();
+    qint64 limit = -1;
+};
+
+// Итог долгого запроса
+enum class QueryStatus {
+    Complete,       // прочитаны все строки
+    Partial,        // остановлен по limit или по требованию обработчика строк
+    Cancelled,      // отменен токеном, прочитанные строки неполны
+    Failed          // ошибка SQL
+};
+
+struct QueryOutcome {
+    QueryStatus status = QueryStatus::Complete;
+    qint64 rows = 0;            // строк передано обработчику
+    QString error;
+
+    bool isComplete() const { return status == QueryStatus::Complete; }
+    bool isCancelled() const { return status == QueryStatus::Cancelled; }
+};
+
+// Сводка по одному виду расчета (значения в СИ)
+struct ResultSummary {
+    QString calculationType;
+    qint64 count = 0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    double mean = 0.0;
+};
+
+// Файл и кэш страниц SQLite (для диагностики); -1 - недоступно.
+// Попадания и промахи кэша - только при сборке с системным SQLite (sqlite_native_cancel)
+struct SqliteStats {
+    qint64 pageSize = -1;
+    qint64 pageCount = -1;
+    qint64 freePages = -1;
+    qint64 cacheCapacityBytes = -1;
+    qint64 cacheUsedBytes = -1;
+    qint64 cacheHits = -1;
+    qint64 cacheMisses = -1;
+    qint64 cacheWrites = -1;
+};
 
 class Database : public QObject
 {
@@ -15,9 +73,13 @@ class Database : public QObject
 
 public:
     explicit Database(QObject *parent = nullptr);
+    // Отдельное именованное соединение - для работы с базой из другого потока
+    explicit Database(const QString &connectionName, QObject *parent = nullptr);
     ~Database();
 
     bool initDatabase(const QString &databaseName = "materials.db");
+    // Дополнительное соединение к уже созданной базе: без создания схемы и словарей
+    bool openConnection(const QString &databaseName);
     bool createTables();
     QSqlDatabase getDatabase() const { return db; }
 
@@ -26,11 +88,13 @@ public:
     bool removeMaterial(const QString &name);
     QList<QString> getAllMaterials();
 
-    // Методы для работы со свойствами материалов (новая структура)
+    // Методы для работы со свойствами материалов (новая структура).
+    // Значение приводится к СИ, исходная единица сохраняется для отображения.
     bool addMaterialProperty(const QString &materialName,
                              const QString &propertyName,
                              const QString &unit,
                              double value);
+    // value - в единицах СИ
     bool updateMaterialProperty(const QString &materialName,
                                 const QString &propertyName,
                                 double value);
@@ -39,17 +103,37 @@ public:
     QList<QPair<QString, double>> getMaterialProperties(const QString &materialName);
     QMap<QString, QPair<QString, double>> getMaterialPropertiesWithUnits(const QString &materialName);
 
+    // Табличные зависимости свойств (например, от температуры)
+    bool addMaterialPropertyCurve(const QString &materialName,
+                                  const QString &propertyName,
+                                  const QString &unit,
+                                  const PropertyCurve &curve);
+    PropertyCurve getMaterialPropertyCurve(const QString &materialName,
+                                           const QString &propertyName);
+    QStringList getMaterialCurveProperties(const QString &materialName);
+
     // Получение всех свойств всех материалов
     QMap<QString, QMap<QString, QPair<QString, double>>> getAllMaterialsWithProperties();
 
+    // Словари свойств и единиц измерения
+    QString propertyName(int propertyId) const { return propertyNames.value(propertyId); }
+    QString unitName(int unitId) const { return unitNames.value(unitId); }
+
+    // Колоночная матрица свойств в памяти (строится при первом обращении)
+    MaterialPropertyMatrix &materialMatrix();
+
     // Методы для моделей
     bool addModel(const QString &name);
     bool removeModel(const QString &name);
     QList<QString> getAllModels();
 
     // Методы для типов расчетов
-    bool addCalculationType(const QString &name, const QString &unit);
+    // unit - единица хранения (СИ), displayUnit - единица исходного файла.
+    // Единица существующего вида меняется, только если она пустая и результатов еще нет
+    bool addCalculationType(const QString &name, const QString &unit,
+                            const QString &displayUnit = QString());
     QList<QPair<QString, QString>> getAllCalculationTypes();
+    QHash<QString, QString> getCalculationTypeDisplayUnits();
 
     // Методы для результатов расчетов
     bool addCalculationResult(const QString &modelName,
@@ -57,13 +141,99 @@ public:
                               const QString &calculationTypeName,
                               double value);
     QList<QVector<QVariant>> getCalculationResults(const QString &modelName = "");
+    // Пары (модель, вид расчета), для которых есть результаты
+    QList<QPair<QString, QString>> getResultSets();
+    // Пустая строка - все модели (все виды расчетов). Возвращает число удаленных строк или -1
+    int removeCalculationResults(const QString &modelName, const QString &calculationType = QString());
+
+    // Отменяемые запросы результатов. Токен проверяется между строками, а при сборке
+    // с BD_SQLITE_NATIVE_CANCEL - и внутри SQLite (сортировка, агрегаты до первой строки).
+    // visit возвращает false, чтобы остановить чтение (статус Partial).
+    QueryOutcome forEachCalculationResult(const ResultFilter &filter,
+                                          const std::function<bool(const QString &modelName,
+                                                                   const QString &nodeNumber,
+                                                                   const QString &calculationType,
+                                                                   double value)> &visit,
+                                          const CancellationToken &token = CancellationToken());
+    QueryOutcome queryCalculationResults(const ResultFilter &filter,
+                                         QList<QVector<QVariant>> &rows,
+                                         const CancellationToken &token = CancellationToken());
+    // То же в колоночном виде - для кэша и таблицы результатов
+    QueryOutcome queryResultBlock(const ResultFilter &filter, ResultBlock &block,
+                                  const CancellationToken &token = CancellationToken());
+    QueryOutcome summarizeCalculationResults(const ResultFilter &filter,
+                                             QList<ResultSummary> &summaries,
+                                             const CancellationToken &token = CancellationToken());
+
+    // Пакетная запись результатов (модель, разобранный файл) одной транзакцией.
+    // Возвращает число записанных узлов или -1 при ошибке.
+    // Файлы, единица которых не совпадает с единицей вида расчета, пропускаются
+    int addCalculationResults(const QList<QPair<QString, ParsedData>> &batch);
+
+    // Загрузка большого набора порциями в одной транзакции:
+    // beginResultsBatch -> appendCalculationResults... -> commitResultsBatch / rollbackResultsBatch
+    bool beginResultsBatch();
+    int appendCalculationResults(const QList<QPair<QString, ParsedData>> &batch);
+    bool commitResultsBatch();
+    void rollbackResultsBatch();
+
+    SqliteStats sqliteStats();
+
+    // Шаги EXPLAIN QUERY PLAN для запроса с привязанными значениями (по порядку)
+    QStringList explainQueryPlan(const QString &sql, const QVariantList &values = QVariantList());
+
+    // Материалы, разобранные из MatML (свойства, зависимости, изотропность)
+    bool addParsedMaterial(const ParsedMaterial &material);
+    bool importParsedMaterials(const QList<ParsedMaterial> &materials);
 
     // Импорт материалов из MatML
     bool importMaterialsFromMatML(const QList<QMap<QString, QVariant>> &materials);
     bool clearAllMaterials();
 
+signals:
+    // Изменения списка материалов (для индексов и представлений)
+    void materialAdded(const QString &name);
+    void materialRemoved(const QString &name);
+    void materialsReset();
+
+    // Результаты пары (модель, вид расчета) записаны или удалены через это соединение.
+    // Пустая строка - все модели (все виды расчетов). Для пакетов - после фиксации транзакции
+    void resultsChanged(const QString &modelName, const QString &calculationType);
+
 private:
+    // Выполнение с замером: дольше порога SlowQueryLog - запрос с параметрами и планом в журнал
+    bool exec(QSqlQuery &query);
+    bool exec(QSqlQuery &query, const QString &sql);
+    void checkSlowStatement(const QSqlQuery &query, qint64 elapsedUs);
+
+    bool migrateLegacyMaterialSchema();
+    bool loadDictionaries();
+    // Откат транзакции, в которой могли появиться новые id словарей
+    void rollbackTransaction();
+    bool prepareResultQuery(QSqlQuery &query, const QString &columns, const ResultFilter &filter,
+                            const QString &tail);
+    QueryOutcome finishQuery(const QSqlQuery &query, const CancellationToken &token, qint64 rows);
+    bool ensureColumn(const QString &table, const QString &column, const QString &definition);
+    bool normalizeLegacyUnits();
+    bool ensureCurveForeignKeys();
+    int ensureDictionaryId(const QString &table, const QString &name,
+                           QHash<QString, int> &ids, QHash<int, QString> &names);
+    int ensurePropertyId(const QString &propertyName);
+    int ensureUnitId(const QString &unit);
+
     QSqlDatabase db;
+    QString connection;
+
+    // Словари свойств и единиц измерения (name <-> id)
+    QHash<QString, int> propertyIds;
+    QHash<int, QString> propertyNames;
+    QHash<QString, int> unitIds;
+    QHash<int, QString> unitNames;
+
+    MaterialPropertyMatrix propertyMatrix;
+
+    // Пары (модель, вид расчета), записанные в открытую транзакцию пакета
+    QSet<QPair<QString, QString>> pendingResultSets;
 };
 
 #endif // DATABASE_H
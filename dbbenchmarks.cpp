@@ -0,0 +1,514 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <atomic>
+#include "benchmarkrunner.h"
+#include "database.h"
+#include "materialsearchindex.h"
+#include "materialselector.h"
+#include "resultexporter.h"
+#include "resultstore.h"
+#include "syntheticdata.h"
+
+// Нагрузка на базу: массовая запись результатов и материалов, выборки с фильтром,
+// сортировка, top-K, поиск и подбор материалов, экспорт и удаление модели.
+// Каждая конфигурация хранения получает свою временную базу с одними и теми же данными,
+// результаты называются "конфигурация/операция" - их удобно сравнивать рядом.
+
+namespace {
+
+std::atomic<double> sink{0.0};
+
+const QStringList calculationTypes = {"Normal Stress", "Shear Stress", "Total Deformation",
+                                      "Directional Deformation X"};
+
+// Настройки хранения и соединения. page_size задается до создания таблиц,
+// остальное - после Database::initDatabase (она включает WAL)
+struct StorageConfig {
+    QString name;
+    QString journalMode = "WAL";
+    QString synchronous = "FULL";
+    int cacheSizeKiB = 2000;        // как у SQLite по умолчанию
+    qint64 mmapBytes = 0;
+    int pageSize = 4096;
+
+    QVariantMap toMap() const
+    {
+        return {{"journal_mode", journalMode}, {"synchronous", synchronous},
+                {"cache_size_kib", cacheSizeKiB}, {"mmap_bytes", mmapBytes}, {"page_size", pageSize}};
+    }
+};
+
+QList<StorageConfig> storageConfigs()
+{
+    StorageConfig standard;
+    standard.name = "default";
+
+    StorageConfig cached;
+    cached.name = "wal_normal_cache256m";
+    cached.synchronous = "NORMAL";
+    cached.cacheSizeKiB = 256 * 1024;
+
+    StorageConfig mapped;
+    mapped.name = "wal_normal_mmap";
+    mapped.synchronous = "NORMAL";
+    mapped.mmapBytes = qint64(4) << 30;
+    mapped.pageSize = 16384;
+
+    StorageConfig rollback;
+    rollback.name = "rollback_full";
+    rollback.journalMode = "DELETE";
+
+    return {standard, cached, mapped, rollback};
+}
+
+bool execPragma(QSqlDatabase db, const QString &sql)
+{
+    QSqlQuery query(db);
+    if (!query.exec(sql)) {
+        QTextStream(stderr) << sql << ": " << query.lastError().text() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Новая база с заданным page_size: размер страницы фиксируется при первой записи
+bool createDatabaseFile(const QString &path, const StorageConfig &config)
+{
+    const QString connectionName = "bench_db_create";
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(path);
+        ok = db.open() && execPragma(db, QString("PRAGMA page_size = %1").arg(config.pageSize))
+             && execPragma(db, "VACUUM");
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return ok;
+}
+
+bool applyConnectionConfig(Database &database, const StorageConfig &config)
+{
+    QSqlDatabase db = database.getDatabase();
+    return execPragma(db, QString("PRAGMA journal_mode = %1").arg(config.journalMode))
+           && execPragma(db, QString("PRAGMA synchronous = %1").arg(config.synchronous))
+           && execPragma(db, QString("PRAGMA cache_size = -%1").arg(config.cacheSizeKiB))
+           && execPragma(db, QString("PRAGMA mmap_size = %1").arg(config.mmapBytes));
+}
+
+// Однократный замер долгой операции. Подготовка данных выполняется всегда,
+// а в отчет попадает только то, что проходит --filter
+void addOnce(BenchmarkRunner &runner, const QString &name, double elapsedMs, qint64 items,
+             const QString &itemName, const QVariantMap &parameters)
+{
+    if (!runner.isSelected(name)) {
+        return;
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.iterations = 1;
+    result.minMs = result.medianMs = result.meanMs = result.maxMs = elapsedMs;
+    result.items = items;
+    result.itemName = itemName;
+    runner.add(result);
+}
+
+QString modelName(int index)
+{
+    return QString("Model %1").arg(index, 3, 10, QChar('0'));
+}
+
+struct Workload {
+    qint64 rows = 0;
+    int models = 10;
+    int materials = 10000;
+    quint64 seed = 1;
+};
+
+// Результаты пишутся порциями по chunkNodes узлов, каждая порция - своя транзакция,
+// как при загрузке пакета файлов. Замеряется только запись, генерация - вне замера
+bool loadResults(BenchmarkRunner &runner, Database &database, const QString &path,
+                 const StorageConfig &config, const Workload &workload)
+{
+    const int sets = workload.models * calculationTypes.size();
+    const int nodesPerSet = int(qMax<qint64>(1, workload.rows / sets));
+    const int chunkNodes = qMin(nodesPerSet, 250000);
+
+    double elapsedMs = 0.0;
+    qint64 written = 0;
+    for (int model = 0; model < workload.models; ++model) {
+        for (int type = 0; type < calculationTypes.size(); ++type) {
+            const QString &calculationType = calculationTypes[type];
+            const QString unit = calculationType.contains("Stress") ? "Pa" : "m";
+            for (int first = 1; first <= nodesPerSet; first += chunkNodes) {
+                const int nodes = qMin(chunkNodes, nodesPerSet - first + 1);
+                const QList<QPair<QString, ParsedData>> batch = {
+                    {modelName(model),
+                     generateParsedData(calculationType, unit, first, nodes,
+                                        workload.seed + quint64(model * 16 + type))}};
+
+                QElapsedTimer timer;
+                timer.start();
+                const int rows = database.beginResultsBatch()
+                                     ? database.appendCalculationResults(batch) : -1;
+                if (rows < 0 || !database.commitResultsBatch()) {
+                    database.rollbackResultsBatch();
+                    QTextStream(stderr) << config.name << ": bulk insert failed\n";
+                    return false;
+                }
+                elapsedMs += timer.nsecsElapsed() / 1e6;
+                written += rows;
+            }
+        }
+    }
+
+    const qint64 fileBytes = QFileInfo(path).size();
+    QVariantMap parameters = config.toMap();
+    parameters.insert("models", workload.models);
+    parameters.insert("nodes_per_set", nodesPerSet);
+    parameters.insert("chunk_nodes", chunkNodes);
+    parameters.insert("database_bytes", fileBytes);
+    addOnce(runner, config.name + "/bulkInsertResults", elapsedMs, written, "rows", parameters);
+    return true;
+}
+
+bool loadMaterials(BenchmarkRunner &runner, Database &database, const StorageConfig &config,
+                   const Workload &workload)
+{
+    const int chunk = 1000;
+    double elapsedMs = 0.0;
+    for (int first = 0; first < workload.materials; first += chunk) {
+        QList<ParsedMaterial> materials;
+        for (int i = first; i < qMin(workload.materials, first + chunk); ++i) {
+            materials.append(generateParsedMaterial(i, 12, workload.seed));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!database.importParsedMaterials(materials)) {
+            QTextStream(stderr) << config.name << ": material import failed\n";
+            return false;
+        }
+        elapsedMs += timer.nsecsElapsed() / 1e6;
+    }
+
+    addOnce(runner, config.name + "/importMaterials", elapsedMs, workload.materials, "materials",
+            config.toMap());
+    return true;
+}
+
+void benchmarkResultQueries(BenchmarkRunner &runner, Database &database, const QString &path,
+                            const StorageConfig &config, const Workload &workload)
+{
+    const QString prefix = config.name + "/";
+    const QVariantMap parameters = config.toMap();
+    const qint64 setRows = qMax<qint64>(1, workload.rows / (workload.models * calculationTypes.size()));
+
+    // Один набор целиком: открытие таблицы результатов в GUI
+    ResultFilter set;
+    set.modelName = modelName(0);
+    set.calculationType = calculationTypes[0];
+    runner.run(prefix + "queryResultBlock/set", 0, setRows, "rows", [&]() {
+        ResultBlock block;
+        sink = sink + database.queryResultBlock(set, block).rows;
+    }, parameters);
+
+    // Первая страница таблицы
+    ResultFilter page = set;
+    page.limit = 1000;
+    runner.run(prefix + "queryResultBlock/firstPage", 0, page.limit, "rows", [&]() {
+        ResultBlock block;
+        sink = sink + database.queryResultBlock(page, block).rows;
+    }, parameters);
+
+    // Диапазон значений по всем моделям: около 10% строк вида расчета
+    ResultFilter range;
+    range.calculationType = calculationTypes[0];
+    range.minimum = 10.0;
+    range.maximum = 100.0;
+    runner.run(prefix + "queryResultBlock/valueRange", 0, setRows * workload.models, "rows scanned",
+               [&]() {
+                   ResultBlock block;
+                   sink = sink + database.queryResultBlock(range, block).rows;
+               }, parameters);
+
+    // Сортированный проход по всей модели: (узел, вид расчета)
+    ResultFilter model;
+    model.modelName = modelName(0);
+    runner.run(prefix + "forEachCalculationResult/modelSorted", 0, setRows * calculationTypes.size(),
+               "rows", [&]() {
+                   double sum = 0.0;
+                   const QueryOutcome outcome = database.forEachCalculationResult(
+                       model, [&sum](const QString &, const QString &, const QString &, double value) {
+                           sum += value;
+                           return true;
+                       });
+                   sink = sink + sum + outcome.rows;
+               }, parameters);
+
+    runner.run(prefix + "summarizeCalculationResults/all", 0, workload.rows, "rows", [&]() {
+        QList<ResultSummary> summaries;
+        database.summarizeCalculationResults(ResultFilter(), summaries);
+        sink = sink + summaries.size();
+    }, parameters);
+
+    // top-K в SQL: сортировка по значению без подходящего индекса
+    ResultFilter topFilter;
+    topFilter.calculationType = calculationTypes[0];
+    runner.run(prefix + "sqlTop100", 0, setRows * workload.models, "rows scanned", [&]() {
+        QSqlQuery query(database.getDatabase());
+        query.prepare("SELECT model_name, node_number, value FROM calculation_results "
+                      "WHERE calculation_type_name = ? ORDER BY value DESC LIMIT 100");
+        query.addBindValue(topFilter.calculationType);
+        qint64 rows = 0;
+        if (query.exec()) {
+            while (query.next()) {
+                rows++;
+            }
+        }
+        sink = sink + rows;
+    }, parameters);
+
+    // То же в памяти: первый вызов загружает наборы из базы (отдельные соединения).
+    // Загрузка нужна и теплому замеру, поэтому пропускается, только если не выбран ни один
+    if (!runner.isSelected(prefix + "ResultStore::top100/cold")
+        && !runner.isSelected(prefix + "ResultStore::top100/warm")) {
+        return;
+    }
+    ResultStore store(path);
+    QElapsedTimer cold;
+    cold.start();
+    {
+        ResultBlock block;
+        store.top(topFilter, 100, true, block);
+        sink = sink + block.size();
+    }
+    QVariantMap storeParameters = parameters;
+    storeParameters.insert("loaded_sets", store.loadedSetCount());
+    storeParameters.insert("memory_bytes", store.memoryBytes());
+    addOnce(runner, prefix + "ResultStore::top100/cold", cold.nsecsElapsed() / 1e6,
+            setRows * workload.models, "rows scanned", storeParameters);
+
+    runner.run(prefix + "ResultStore::top100/warm", 0, setRows * workload.models, "rows scanned", [&]() {
+        ResultBlock block;
+        store.top(topFilter, 100, true, block);
+        sink = sink + block.size();
+    }, storeParameters);
+}
+
+void benchmarkMaterials(BenchmarkRunner &runner, Database &database, const StorageConfig &config,
+                        const Workload &workload)
+{
+    const QString prefix = config.name + "/";
+    const QVariantMap parameters = config.toMap();
+
+    runner.run(prefix + "getAllMaterials", 0, workload.materials, "materials", [&]() {
+        sink = sink + database.getAllMaterials().size();
+    }, parameters);
+
+    runner.run(prefix + "getAllMaterialsWithProperties", 0, workload.materials, "materials", [&]() {
+        sink = sink + database.getAllMaterialsWithProperties().size();
+    }, parameters);
+
+    const QStringList names = database.getAllMaterials();
+    MaterialSearchIndex index;
+    runner.run(prefix + "MaterialSearchIndex::rebuild", 0, names.size(), "materials", [&]() {
+        index.rebuild(names);
+        sink = sink + index.size();
+    }, parameters);
+
+    // Точное название, опечатка и часть названия
+    const QStringList queries = {"Structural Steel 42", "Aluminium Aloy 7", "titan"};
+    runner.run(prefix + "MaterialSearchIndex::search", 0, queries.size(), "queries", [&]() {
+        for (const QString &text : queries) {
+            sink = sink + index.search(text, 50).size();
+        }
+    }, parameters);
+
+    // Подбор: плотность и предел текучести в диапазоне, ранжирование по модулю Юнга
+    MaterialSelector selector(&database);
+    SelectionQuery query;
+    query.predicates = {{"Density", 5000.0, 9000.0}, {"Tensile Yield Strength", 2.0e8, 3.0e8}};
+    query.rankBy = "Young's Modulus";
+    query.descending = true;
+    runner.run(prefix + "MaterialSelector::select", 0, workload.materials, "materials", [&]() {
+        sink = sink + selector.select(query).totalMatches;
+    }, parameters);
+}
+
+void benchmarkExport(BenchmarkRunner &runner, Database &database, const QDir &dir,
+                     const StorageConfig &config, const Workload &workload)
+{
+    ResultFilter filter;
+    filter.modelName = modelName(0);
+    const qint64 rows = qMax<qint64>(1, workload.rows / workload.models);
+
+    const QList<QPair<QString, ResultExportFormat>> formats = {
+        {"csv", ResultExportFormat::Csv}, {"bdr", ResultExportFormat::Binary}};
+    for (const auto &format : formats) {
+        const QString fileName = dir.filePath(QString("%1_export.%2").arg(config.name, format.first));
+        qint64 bytes = 0;
+        runner.run(QString("%1/ResultExporter::run/%2").arg(config.name, format.first), 0, rows, "rows",
+                   [&]() {
+                       ResultExporter exporter(&database);
+                       const ResultExportStats stats = exporter.run(filter, fileName, format.second);
+                       bytes = stats.bytes;
+                       sink = sink + stats.rows;
+                   },
+                   config.toMap());
+        QFile::remove(fileName);
+        sink = sink + bytes;
+    }
+}
+
+// Последним: удаление модели меняет данные для остальных операций
+void benchmarkRemoveModel(BenchmarkRunner &runner, Database &database, const StorageConfig &config,
+                          const Workload &workload)
+{
+    const QString name = config.name + "/removeModel";
+    if (!runner.isSelected(name)) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool removed = database.removeModel(modelName(workload.models - 1));
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+    if (!removed) {
+        QTextStream(stderr) << name << ": failed\n";
+        return;
+    }
+    addOnce(runner, name, elapsedMs, qMax<qint64>(1, workload.rows / workload.models), "rows",
+            config.toMap());
+}
+
+bool runConfig(BenchmarkRunner &runner, const QDir &dir, const StorageConfig &config,
+               const Workload &workload)
+{
+    const QString path = dir.filePath(config.name + ".db");
+    if (!createDatabaseFile(path, config)) {
+        QTextStream(stderr) << config.name << ": cannot create database\n";
+        return false;
+    }
+
+    bool ok = false;
+    {
+        Database database("bench_db_" + config.name);
+        ok = database.initDatabase(path) && applyConnectionConfig(database, config)
+             && loadResults(runner, database, path, config, workload)
+             && loadMaterials(runner, database, config, workload);
+        if (ok) {
+            benchmarkResultQueries(runner, database, path, config, workload);
+            benchmarkMaterials(runner, database, config, workload);
+            benchmarkExport(runner, database, dir, config, workload);
+            benchmarkRemoveModel(runner, database, config, workload);
+        }
+    }
+
+    // Базы на десятки миллионов строк не копятся на диске
+    QFile::remove(path);
+    QFile::remove(path + "-wal");
+    QFile::remove(path + "-shm");
+    return ok;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bd_lab3_dbbench");
+
+    QStringList configNames;
+    for (const StorageConfig &config : storageConfigs()) {
+        configNames.append(config.name);
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Database workload benchmarks on deterministic synthetic data.\n"
+        "Every storage configuration gets its own temporary database with the same data.\n"
+        "Table goes to stderr, JSON report to --out.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {{"o", "out"}, "JSON report file, '-' for stdout (default: bench_database.json).", "file",
+         "bench_database.json"},
+        {"filter", "Run only benchmarks whose name matches the regular expression.", "regex"},
+        {"rows", "Result rows (default: 1000000).", "count", "1000000"},
+        {"models", "Models the rows are spread over (default: 10).", "count", "10"},
+        {"materials", "Materials (default: 10000).", "count", "10000"},
+        {"configs", "Comma-separated storage configurations: " + configNames.join(", ")
+                        + " (default: all).", "names"},
+        {"dir", "Directory for the temporary databases (default: system temp).", "path"},
+        {"seed", "Generator seed (default: 1).", "seed", "1"},
+        {"quick", "One measured iteration per benchmark (smoke run)."}
+    });
+    parser.process(app);
+
+    Workload workload;
+    workload.rows = qMax<qint64>(1, parser.value("rows").toLongLong());
+    workload.models = qMax(1, parser.value("models").toInt());
+    workload.materials = qMax(1, parser.value("materials").toInt());
+    workload.seed = parser.value("seed").toULongLong();
+
+    QList<StorageConfig> configs;
+    const QStringList selected = parser.value("configs").split(',', Qt::SkipEmptyParts);
+    for (const QString &name : selected) {
+        if (!configNames.contains(name)) {
+            QTextStream(stderr) << "Unknown configuration '" << name << "'; available: "
+                                << configNames.join(", ") << "\n";
+            return 2;
+        }
+    }
+    for (const StorageConfig &config : storageConfigs()) {
+        if (selected.isEmpty() || selected.contains(config.name)) {
+            configs.append(config);
+        }
+    }
+
+    // Большие базы лучше держать на том же диске, что и рабочая база пользователей
+    QTemporaryDir temporaryDir(parser.isSet("dir")
+                                   ? QDir(parser.value("dir")).filePath("bd_lab3_dbbench-XXXXXX")
+                                   : QDir::tempPath() + "/bd_lab3_dbbench-XXXXXX");
+    if (!temporaryDir.isValid()) {
+        QTextStream(stderr) << "Cannot create temporary directory\n";
+        return 2;
+    }
+    const QDir dir(temporaryDir.path());
+
+    BenchmarkRunner runner("database");
+    runner.setFilter(parser.value("filter"));
+    if (parser.isSet("quick")) {
+        runner.setIterations(1, 1);
+        runner.setMinTimeMs(0);
+    } else {
+        // Запросы по миллионам строк: хватает нескольких повторов
+        runner.setIterations(3, 10);
+    }
+    runner.setContext("rows", workload.rows);
+    runner.setContext("models", workload.models);
+    runner.setContext("materials", workload.materials);
+    runner.setContext("seed", QString::number(workload.seed));
+
+    int failed = 0;
+    for (const StorageConfig &config : configs) {
+        if (!runConfig(runner, dir, config, workload)) {
+            failed++;
+        }
+    }
+
+    QString error;
+    if (!runner.writeReport(parser.value("out"), &error)) {
+        QTextStream(stderr) << error << "\n";
+        return 2;
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+#ifndef DENSEBITMAP_H
+#define DENSEBITMAP_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+// Плотная битовая карта по индексам строк (материалов)
+class DenseBitmap
+{
+public:
+    DenseBitmap() = default;
+    explicit DenseBitmap(int size, bool value = false)
+    {
+        resize(size);
+        fill(value);
+    }
+
+    int size() const { return bitCount; }
+    bool isEmpty() const { return bitCount == 0; }
+
+    void resize(int size)
+    {
+        bitCount = size;
+        words.resize((size + 63) / 64);
+        clearTail();
+    }
+
+    void fill(bool value)
+    {
+        words.fill(value ? ~quint64(0) : quint64(0));
+        clearTail();
+    }
+
+    bool test(int index) const
+    {
+        return (words[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void set(int index) { words[index >> 6] |= quint64(1) << (index & 63); }
+    void reset(int index) { words[index >> 6] &= ~(quint64(1) << (index & 63)); }
+    void assign(int index, bool value) { value ? set(index) : reset(index); }
+
+    DenseBitmap &operator&=(const DenseBitmap &other)
+    {
+        const int n = qMin(words.size(), other.words.size());
+        for (int i = 0; i < n; ++i) {
+            words[i] &= other.words[i];
+        }
+        for (int i = n; i < words.size(); ++i) {
+            words[i] = 0;
+        }
+        return *this;
+    }
+
+    DenseBitmap &operator|=(const DenseBitmap &other)
+    {
+        const int n = qMin(words.size(), other.words.size());
+        for (int i = 0; i < n; ++i) {
+            words[i] |= other.words[i];
+        }
+        return *this;
+    }
+
+    int count() const
+    {
+        int total = 0;
+        for (quint64 word : words) {
+            total += qPopulationCount(word);
+        }
+        return total;
+    }
+
+    // Индекс следующего установленного бита начиная с from, либо -1
+    int nextSetBit(int from) const
+    {
+        if (from >= bitCount) {
+            return -1;
+        }
+
+        int wordIndex = from >> 6;
+        quint64 word = words[wordIndex] & (~quint64(0) << (from & 63));
+
+        while (true) {
+            if (word != 0) {
+                return wordIndex * 64 + int(qCountTrailingZeroBits(word));
+            }
+            if (++wordIndex >= words.size()) {
+                return -1;
+            }
+            word = words[wordIndex];
+        }
+    }
+
+    const QVector<quint64> &data() const { return words; }
+
+private:
+    void clearTail()
+    {
+        if (bitCount & 63) {
+            words.last() &= (quint64(1) << (bitCount & 63)) - 1;
+        }
+    }
+
+    int bitCount = 0;
+    QVector<quint64> words;
+};
+
+#endif // DENSEBITMAP_H
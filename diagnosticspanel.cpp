@@ -0,0 +1,329 @@
+#include "diagnosticspanel.h"
+#include "database.h"
+#include "memorybudget.h"
+#include "metrics.h"
+#include "resultcache.h"
+#include "resultstore.h"
+#include "slowquerylog.h"
+#include "stallwatchdog.h"
+#include <QColor>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSplitter>
+#include <QThreadPool>
+#include <QVBoxLayout>
+
+namespace {
+
+QString megabytes(qint64 bytes)
+{
+    return bytes < 0 ? QString("-") : QString::number(bytes / 1048576.0, 'f', 1) + " MB";
+}
+
+QString milliseconds(qint64 microseconds)
+{
+    return QString::number(microseconds / 1000.0, 'f', microseconds < 10000 ? 2 : 0);
+}
+
+QString optional(qint64 value)
+{
+    return value < 0 ? QString("-") : QString::number(value);
+}
+
+}
+
+DiagnosticsPanel::DiagnosticsPanel(Database *db, const ResultCache *cache, const ResultStore *store,
+                                   QWidget *parent)
+    : QWidget(parent)
+    , db(db)
+    , cache(cache)
+    , store(store)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+    QLabel *hint = new QLabel("Обновляется раз в секунду. Задержки - с запуска или со сброса, мс", this);
+    hint->setStyleSheet("color: gray;");
+    controlLayout->addWidget(hint, 1);
+    controlLayout->addWidget(new QLabel("Бюджет памяти", this));
+    memoryLimitSpin = new QSpinBox(this);
+    memoryLimitSpin->setRange(0, 1024 * 1024);
+    memoryLimitSpin->setSuffix(" MB");
+    memoryLimitSpin->setSpecialValueText("без ограничения");
+    memoryLimitSpin->setValue(int(MemoryBudget::instance().limitBytes() / 1048576));
+    controlLayout->addWidget(memoryLimitSpin);
+    QPushButton *resetButton = new QPushButton("Сбросить задержки", this);
+    controlLayout->addWidget(resetButton);
+    layout->addLayout(controlLayout);
+
+    QSplitter *splitter = new QSplitter(Qt::Vertical, this);
+
+    countersTree = new QTreeWidget(splitter);
+    countersTree->setColumnCount(2);
+    countersTree->setHeaderLabels({"Показатель", "Значение"});
+    countersTree->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+
+    ingestGroup = addGroup("Загрузка результатов");
+    jobsGroup = addGroup("Фоновые задания");
+    cacheGroup = addGroup("Кэши результатов");
+    sqliteGroup = addGroup("SQLite");
+    processGroup = addGroup("Процесс");
+    memoryGroup = addGroup("Память");
+    interfaceGroup = addGroup("Интерфейс");
+    countersTree->expandAll();
+
+    latencyTable = new QTableWidget(splitter);
+    latencyTable->setColumnCount(7);
+    latencyTable->setHorizontalHeaderLabels({"Операция", "Вызовов", "Среднее", "p50", "p95", "p99", "Макс"});
+    latencyTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    latencyTable->verticalHeader()->setVisible(false);
+    latencyTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    QWidget *slowWidget = new QWidget(splitter);
+    QVBoxLayout *slowLayout = new QVBoxLayout(slowWidget);
+    slowLayout->setContentsMargins(0, 0, 0, 0);
+
+    QHBoxLayout *slowControlLayout = new QHBoxLayout();
+    slowControlLayout->addWidget(new QLabel("Медленные запросы, дольше", slowWidget));
+    slowThresholdSpin = new QSpinBox(slowWidget);
+    slowThresholdSpin->setRange(-1, 600000);
+    slowThresholdSpin->setSuffix(" мс");
+    slowThresholdSpin->setSpecialValueText("выключено");
+    slowThresholdSpin->setValue(SlowQueryLog::instance().thresholdMs());
+    slowControlLayout->addWidget(slowThresholdSpin);
+    slowControlLayout->addStretch();
+    QPushButton *clearSlowButton = new QPushButton("Очистить", slowWidget);
+    slowControlLayout->addWidget(clearSlowButton);
+    slowLayout->addLayout(slowControlLayout);
+
+    // Запрос - строка, параметры и план - вложенные строки
+    slowQueryTree = new QTreeWidget(slowWidget);
+    slowQueryTree->setColumnCount(4);
+    slowQueryTree->setHeaderLabels({"Время", "мс", "Соединение", "Запрос"});
+    slowQueryTree->header()->setStretchLastSection(true);
+    slowLayout->addWidget(slowQueryTree);
+
+    layout->addWidget(splitter);
+
+    timer.setInterval(1000);
+    connect(&timer, &QTimer::timeout, this, &DiagnosticsPanel::refresh);
+    connect(resetButton, &QPushButton::clicked, this, &DiagnosticsPanel::resetLatencies);
+    connect(clearSlowButton, &QPushButton::clicked, this, &DiagnosticsPanel::clearSlowQueries);
+    connect(slowThresholdSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [](int milliseconds) {
+        SlowQueryLog::instance().setThresholdMs(milliseconds);
+    });
+    connect(memoryLimitSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [](int megabytes) {
+        MemoryBudget::instance().setLimitBytes(qint64(megabytes) * 1048576);
+    });
+}
+
+void DiagnosticsPanel::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    timer.start();
+}
+
+void DiagnosticsPanel::hideEvent(QHideEvent *event)
+{
+    // Скрытая вкладка не тратит время на опрос
+    timer.stop();
+    QWidget::hideEvent(event);
+}
+
+QTreeWidgetItem *DiagnosticsPanel::addGroup(const QString &title)
+{
+    QTreeWidgetItem *group = new QTreeWidgetItem(countersTree, {title});
+    QFont font = group->font(0);
+    font.setBold(true);
+    group->setFont(0, font);
+    return group;
+}
+
+void DiagnosticsPanel::setValue(QTreeWidgetItem *group, const QString &name, const QString &value)
+{
+    const QString key = group->text(0) + '/' + name;
+    QTreeWidgetItem *item = items.value(key);
+    if (!item) {
+        item = new QTreeWidgetItem(group, {name});
+        items.insert(key, item);
+    }
+    item->setText(1, value);
+}
+
+void DiagnosticsPanel::refresh()
+{
+    const Metrics &metrics = Metrics::instance();
+
+    // Скорости - по разнице со значениями прошлого опроса
+    const qint64 rows = metrics.writtenRowCount();
+    const qint64 bytes = metrics.parsedByteCount();
+    double seconds = sampleTimer.isValid() ? sampleTimer.restart() / 1000.0 : 0.0;
+    if (!sampleTimer.isValid()) {
+        sampleTimer.start();
+    }
+    double rowsPerSecond = seconds > 0.0 ? (rows - lastRows) / seconds : 0.0;
+    double bytesPerSecond = seconds > 0.0 ? (bytes - lastBytes) / seconds : 0.0;
+    lastRows = rows;
+    lastBytes = bytes;
+
+    setValue(ingestGroup, "Файлов разобрано", QString::number(metrics.parsedFileCount()));
+    setValue(ingestGroup, "Прочитано", megabytes(bytes));
+    setValue(ingestGroup, "Строк записано", QString::number(rows));
+    setValue(ingestGroup, "Строк/с", QString::number(rowsPerSecond, 'f', 0));
+    setValue(ingestGroup, "MB/с разбора", QString::number(bytesPerSecond / 1048576.0, 'f', 1));
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    setValue(jobsGroup, "В очереди", QString::number(metrics.queuedJobCount()));
+    setValue(jobsGroup, "Выполняются", QString::number(metrics.runningJobCount()));
+    setValue(jobsGroup, "Общий пул потоков", QString("%1 / %2").arg(pool->activeThreadCount())
+                                                   .arg(pool->maxThreadCount()));
+
+    const quint64 lookups = cache->hits() + cache->misses();
+    setValue(cacheGroup, "Выборки: попадания",
+             lookups == 0 ? QString("-")
+                          : QString("%1 из %2 (%3%)").arg(cache->hits()).arg(lookups)
+                                .arg(100.0 * cache->hits() / lookups, 0, 'f', 1));
+    setValue(cacheGroup, "Выборки: записей / вытеснено",
+             QString("%1 / %2").arg(cache->count()).arg(cache->evictions()));
+    setValue(cacheGroup, "Выборки: память",
+             megabytes(cache->memoryBytes()) + " из " + megabytes(cache->capacityBytes()));
+    setValue(cacheGroup, "Наборы в памяти", QString::number(store->loadedSetCount()));
+    setValue(cacheGroup, "Наборы: память", megabytes(store->memoryBytes()));
+
+    const SqliteStats sqlite = db->sqliteStats();
+    setValue(sqliteGroup, "Размер базы",
+             sqlite.pageSize > 0 && sqlite.pageCount >= 0 ? megabytes(sqlite.pageSize * sqlite.pageCount)
+                                                          : QString("-"));
+    setValue(sqliteGroup, "Страниц / свободных",
+             QString("%1 / %2").arg(optional(sqlite.pageCount), optional(sqlite.freePages)));
+    setValue(sqliteGroup, "Кэш страниц",
+             megabytes(sqlite.cacheUsedBytes) + " из " + megabytes(sqlite.cacheCapacityBytes));
+    const qint64 pageLookups = sqlite.cacheHits + sqlite.cacheMisses;
+    setValue(sqliteGroup, "Кэш страниц: попадания",
+             sqlite.cacheHits < 0 || pageLookups <= 0
+                 ? optional(sqlite.cacheHits)
+                 : QString("%1 из %2 (%3%)").arg(sqlite.cacheHits).arg(pageLookups)
+                       .arg(100.0 * sqlite.cacheHits / pageLookups, 0, 'f', 1));
+
+    const qint64 resident = Metrics::residentBytes();
+    setValue(processGroup, "Резидентная память", megabytes(resident));
+
+    // Подсистемы: резервы и источники; пик - только по резервам
+    const MemoryBudget &budget = MemoryBudget::instance();
+    for (int i = 0; i < MemoryBudget::SubsystemCount; ++i) {
+        const MemorySubsystem subsystem = MemorySubsystem(i);
+        const qint64 peak = budget.peakBytes(subsystem);
+        setValue(memoryGroup, MemoryBudget::subsystemName(subsystem),
+                 megabytes(budget.usedBytes(subsystem))
+                     + (peak > 0 ? " (пик " + megabytes(peak) + ")" : QString()));
+    }
+    for (const MemorySourceUsage &source : budget.sources()) {
+        setValue(memoryGroup, MemoryBudget::subsystemName(source.subsystem) + ": " + source.name,
+                 megabytes(source.bytes));
+    }
+    const qint64 total = budget.totalBytes();
+    setValue(memoryGroup, "Учтено всего",
+             megabytes(total) + (budget.limitBytes() > 0 ? " из " + megabytes(budget.limitBytes())
+                                                         : QString(", без ограничения")));
+    setValue(memoryGroup, "Не учтено (резидентная - учтено)",
+             resident < 0 ? QString("-") : megabytes(qMax<qint64>(0, resident - total)));
+    setValue(memoryGroup, "Ожиданий загрузки / мс",
+             QString("%1 / %2").arg(budget.backpressureWaits()).arg(budget.backpressureMs()));
+    setValue(memoryGroup, "Вытеснено по бюджету", megabytes(budget.evictedBytes()));
+
+    // Задержки цикла событий - в таблице ниже ("GUI event loop")
+    const StallWatchdog &watchdog = StallWatchdog::instance();
+    const QList<EventLoopStall> stalls = watchdog.stalls();
+    setValue(interfaceGroup, "Сторож цикла событий",
+             watchdog.isRunning() ? QString("порог %1 мс").arg(watchdog.thresholdMs()) : QString("выключен"));
+    setValue(interfaceGroup, "Зависаний", QString::number(watchdog.stallCount()));
+    setValue(interfaceGroup, "Последнее", stalls.isEmpty() ? QString("-")
+                                                          : stalls.last().time.toString("HH:mm:ss ")
+                                                                + stalls.last().toString());
+
+    refreshLatencies();
+    refreshSlowQueries();
+}
+
+void DiagnosticsPanel::refreshSlowQueries()
+{
+    // Журнал перестраивается, только если в нем появились записи
+    const SlowQueryLog &log = SlowQueryLog::instance();
+    if (log.recordedCount() == shownSlowQueries) {
+        return;
+    }
+    shownSlowQueries = log.recordedCount();
+
+    slowQueryTree->clear();
+    const QList<SlowQuery> queries = log.entries();
+    for (auto it = queries.crbegin(); it != queries.crend(); ++it) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(slowQueryTree, {
+            it->time.toString("HH:mm:ss"),
+            QString::number(it->elapsedUs / 1000.0, 'f', 1),
+            it->connection,
+            it->sql
+        });
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+        item->setToolTip(3, it->sql);
+        if (it->fullScan) {
+            item->setForeground(3, QColor(200, 0, 0));
+            item->setText(1, item->text(1) + " SCAN");
+        }
+
+        if (!it->parameters.isEmpty()) {
+            QTreeWidgetItem *parameters = new QTreeWidgetItem(item);
+            parameters->setText(3, "Параметры: " + it->parameters.join(", "));
+        }
+        for (const QString &step : it->plan) {
+            QTreeWidgetItem *planStep = new QTreeWidgetItem(item);
+            planStep->setText(3, step);
+        }
+    }
+}
+
+void DiagnosticsPanel::clearSlowQueries()
+{
+    SlowQueryLog::instance().clear();
+    shownSlowQueries = 0;
+    slowQueryTree->clear();
+}
+
+void DiagnosticsPanel::refreshLatencies()
+{
+    const auto latencies = Metrics::instance().latencies();
+    latencyTable->setRowCount(latencies.size());
+
+    for (int row = 0; row < latencies.size(); ++row) {
+        const LatencyHistogram &histogram = *latencies[row].second;
+        const QStringList cells = {
+            latencies[row].first,
+            QString::number(histogram.count()),
+            milliseconds(qint64(histogram.meanUs())),
+            milliseconds(histogram.percentileUs(50)),
+            milliseconds(histogram.percentileUs(95)),
+            milliseconds(histogram.percentileUs(99)),
+            milliseconds(histogram.maxUs())
+        };
+
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem *item = latencyTable->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem();
+                if (column > 0) {
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                }
+                latencyTable->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+}
+
+void DiagnosticsPanel::resetLatencies()
+{
+    Metrics::instance().resetLatencies();
+    refreshLatencies();
+}
@@ -0,0 +1,68 @@
+#ifndef DIAGNOSTICSPANEL_H
+#define DIAGNOSTICSPANEL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QWidget>
+
+class Database;
+class ResultCache;
+class ResultStore;
+
+// Вкладка "Диагностика": счетчики Metrics, кэши, SQLite, память по подсистемам и ее бюджет.
+// Обновляется раз в секунду, пока вкладка видна
+class DiagnosticsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    DiagnosticsPanel(Database *db, const ResultCache *cache, const ResultStore *store,
+                     QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void resetLatencies();
+    void clearSlowQueries();
+
+private:
+    QTreeWidgetItem *addGroup(const QString &title);
+    void setValue(QTreeWidgetItem *group, const QString &name, const QString &value);
+    void refreshLatencies();
+    void refreshSlowQueries();
+
+    Database *db;
+    const ResultCache *cache;
+    const ResultStore *store;
+
+    QTreeWidget *countersTree;
+    QTableWidget *latencyTable;
+    QSpinBox *memoryLimitSpin;
+    QSpinBox *slowThresholdSpin;
+    QTreeWidget *slowQueryTree;
+    quint64 shownSlowQueries = 0;
+    QTimer timer;
+
+    QTreeWidgetItem *ingestGroup;
+    QTreeWidgetItem *jobsGroup;
+    QTreeWidgetItem *cacheGroup;
+    QTreeWidgetItem *sqliteGroup;
+    QTreeWidgetItem *processGroup;
+    QTreeWidgetItem *memoryGroup;
+    QTreeWidgetItem *interfaceGroup;
+    QHash<QString, QTreeWidgetItem *> items;
+
+    // Предыдущие значения - для скоростей
+    QElapsedTimer sampleTimer;
+    qint64 lastRows = 0;
+    qint64 lastBytes = 0;
+};
+
+#endif // DIAGNOSTICSPANEL_H
@@ -1,4 +1,19 @@
 #include "fileparser.h"
+#include "metrics.h"
+#include "stringinterner.h"
+#include "tracer.h"
+#include "unitregistry.h"
+
+qint64 ParsedData::memoryBytes() const
+{
+    // Узел QMap: указатели и цвет (~32 байта) + ключ и значение; у строки - заголовок данных
+    const qint64 nodeBytes = 32 + sizeof(QString) + sizeof(double) + 24;
+    qint64 bytes = sizeof(ParsedData) + nodeValues.size() * nodeBytes;
+    for (auto it = nodeValues.constBegin(); it != nodeValues.constEnd(); ++it) {
+        bytes += it.key().capacity() * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
 
 FileParser::FileParser(QObject *parent) : QObject(parent)
 {
@@ -6,6 +21,7 @@ FileParser::FileParser(QObject *parent) : QObject(parent)
 
 ParsedData FileParser::parseFile(const QString &filePath, QString &error)
 {
+    BD_TRACE_SCOPE("parse", "FileParser::parseFile");
     ParsedData data;
     QFile file(filePath);
 
@@ -21,7 +37,7 @@ ParsedData FileParser::parseFile(const QString &filePath, QString &error)
 
     // Определяем тип расчета из имени файла
     QString fileName = QFileInfo(filePath).fileName();
-    data.calculationType = detectCalculationType(fileName);
+    data.calculationType = StringInterner::instance().intern(detectCalculationType(fileName));
 
     while (!in.atEnd()) {
         lineNumber++;
@@ -33,7 +49,7 @@ ParsedData FileParser::parseFile(const QString &filePath, QString &error)
 
         if (!headerProcessed) {
             // Парсим заголовок для получения единиц измерения
-            data.unit = extractUnitFromHeader(line);
+            data.unit = StringInterner::instance().intern(extractUnitFromHeader(line));
             headerProcessed = true;
             continue;
         }
@@ -69,12 +85,30 @@ ParsedData FileParser::parseFile(const QString &filePath, QString &error)
         }
     }
 
+    Metrics::instance().addParsedFile(file.size());
     file.close();
 
     if (data.nodeValues.isEmpty()) {
         error = "Недопустимые данные";
     }
 
+    // Приводим значения к СИ один раз при загрузке, исходную единицу сохраняем
+    BD_TRACE_SCOPE("parse", "FileParser::convertUnits");
+    data.sourceUnit = data.unit;
+    UnitConversion conversion = UnitRegistry::instance().lookup(data.unit);
+
+    if (conversion.known) {
+        data.unit = StringInterner::instance().intern(conversion.siUnit);
+
+        if (!conversion.isIdentity()) {
+            for (auto it = data.nodeValues.begin(); it != data.nodeValues.end(); ++it) {
+                it.value() = conversion.toSI(it.value());
+            }
+        }
+    } else if (!data.unit.isEmpty()) {
+        qDebug() << "Unknown unit, values stored as is:" << data.unit;
+    }
+
     return data;
 }
 
@@ -118,27 +152,39 @@ QString FileParser::detectCalculationType(const QString &fileName)
 
 QString FileParser::extractUnitFromHeader(const QString &header)
 {
-    // Ищем единицы измерения в скобках
-    QRegularExpression re("\\(([^)]+)\\)");
-    QRegularExpressionMatch match = re.match(header);
+    // Ищем единицы измерения в скобках: "Total Deformation (mm)" или "[MPa]"
+    static const QRegularExpression bracketRe("[\\(\\[]([^\\)\\]]+)[\\)\\]]");
+    QRegularExpressionMatchIterator matches = bracketRe.globalMatch(header);
+
+    QString firstBracketed;
+    while (matches.hasNext()) {
+        QString candidate = matches.next().captured(1).trimmed();
+        if (UnitRegistry::instance().isKnown(candidate)) {
+            return candidate;
+        }
+        if (firstBracketed.isEmpty()) {
+            firstBracketed = candidate;
+        }
+    }
 
-    if (match.hasMatch()) {
-        return match.captured(1);
+    if (!firstBracketed.isEmpty()) {
+        return firstBracketed;
     }
 
-    // Если не нашли в скобках, пробуем определить по содержимому
-    QString headerLower = header.toLower();
-
-    if (headerLower.contains("pa") || headerLower.contains("pascal")) {
-        return "Pa";
-    } else if (headerLower.contains("m") || headerLower.contains("meter")) {
-        return "m";
-    } else if (headerLower.contains("n") || headerLower.contains("newton")) {
-        return "N";
-    } else if (headerLower.contains("m/m")) {
-        return "m/m";
-    } else if (headerLower.contains("mm")) {
-        return "mm";
+    // Иначе - отдельное слово заголовка, точно совпадающее с известной единицей.
+    // Однобуквенные слова и совпадающие с обычными словами ("in", "min") не учитываем:
+    // раньше любая "m" в заголовке давала метры
+    static const QRegularExpression separatorRe("[\\s,;:]+");
+    static const QStringList ambiguous = {"in", "min", "sec", "hr", "bar"};
+    const QStringList tokens = header.split(separatorRe, Qt::SkipEmptyParts);
+
+    for (const QString &token : tokens) {
+        if (token.size() < 2 || ambiguous.contains(token, Qt::CaseInsensitive)) {
+            continue;
+        }
+        if (UnitRegistry::instance().isKnown(token)) {
+            return token;
+        }
     }
 
     return "";
@@ -146,6 +192,7 @@ QString FileParser::extractUnitFromHeader(const QString &header)
 
 double FileParser::parseNumber(const QString &numberStr)
 {
+    BD_TRACE_DETAIL("parse", "FileParser::parseNumber");
     QString str = numberStr.trimmed();
 
     // Удаляем возможные пробелы вокруг 'e'
@@ -11,8 +11,12 @@
 
 struct ParsedData {
     QString calculationType;
-    QString unit;
+    QString unit;                     // единица СИ, в которой хранятся значения
+    QString sourceUnit;               // единица из файла (для отображения)
     QMap<QString, double> nodeValues; // Key: node number, Value: calculation value
+
+    // Оценка занятой памяти (узлы QMap и строки ключей)
+    qint64 memoryBytes() const;
 };
 
 class FileParser : public QObject
@@ -25,9 +29,11 @@ public:
     ParsedData parseFile(const QString &filePath, QString &error);
     QString detectCalculationType(const QString &fileName);
 
+    // Число из файла результатов: запятая или точка, "1.2E+05", "1.2 e-3"
+    static double parseNumber(const QString &numberStr);
+
 private:
     QString extractUnitFromHeader(const QString &header);
-    double parseNumber(const QString &numberStr);
 };
 
 #endif // FILEPARSER_H
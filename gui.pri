@@ -0,0 +1,25 @@
+# Окна и модели GUI (без main.cpp). Подключается в bd_lab3.pro и в сценарий bd_lab3_guibench.pro
+# вместе с core.pri.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/diagnosticspanel.cpp \
+    $$PWD/mainwindow.cpp \
+    $$PWD/materialimportdialog.cpp \
+    $$PWD/materiallistmodel.cpp \
+    $$PWD/materialpropertiesmodel.cpp \
+    $$PWD/refreshscheduler.cpp \
+    $$PWD/snapshotviewer.cpp \
+    $$PWD/substitutedialog.cpp
+
+HEADERS += \
+    $$PWD/diagnosticspanel.h \
+    $$PWD/mainwindow.h \
+    $$PWD/materialimportdialog.h \
+    $$PWD/materiallistmodel.h \
+    $$PWD/materialpropertiesmodel.h \
+    $$PWD/modeldiff.h \
+    $$PWD/refreshscheduler.h \
+    $$PWD/snapshotviewer.h \
+    $$PWD/substitutedialog.h
@@ -0,0 +1,425 @@
+#include <QAbstractItemModel>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QComboBox>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QListView>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <functional>
+#include "benchmarkrunner.h"
+#include "database.h"
+#include "mainwindow.h"
+#include "metrics.h"
+#include "stallwatchdog.h"
+#include "syntheticdata.h"
+
+// Сценарий отзывчивости GUI: MainWindow на большой синтетической базе проходит запуск,
+// загрузку папки результатов, смену фильтров, сортировку, поиск и подбор материалов.
+// Для каждого шага StallWatchdog меряет задержку цикла событий (ответ на опрос каждые
+// --interval мс): худший случай, p99 и зависания дольше --stall-ms с занятием GUI-потока.
+// Диалоги закрывает ModalResponder, как это сделал бы пользователь.
+
+namespace {
+
+const QStringList calculationTypes = {"Normal Stress", "Shear Stress", "Total Deformation",
+                                      "Directional Deformation X"};
+
+QString modelName(int index)
+{
+    return QString("Model %1").arg(index, 3, 10, QChar('0'));
+}
+
+// Отвечает на модальные диалоги: папка для загрузки, правило имени модели, сообщения
+class ModalResponder : public QObject
+{
+public:
+    explicit ModalResponder(const QString &directory)
+        : directory(directory)
+    {
+        timer.setInterval(10);
+        connect(&timer, &QTimer::timeout, this, &ModalResponder::respond);
+        timer.start();
+    }
+
+    int messageCount() const { return messages; }
+    QString lastMessage() const { return message; }
+
+private:
+    void respond()
+    {
+        QWidget *widget = QApplication::activeModalWidget();
+        if (!widget || qobject_cast<QProgressDialog *>(widget)) {
+            return;
+        }
+
+        if (QFileDialog *fileDialog = qobject_cast<QFileDialog *>(widget)) {
+            fileDialog->selectFile(directory);
+            fileDialog->accept();
+        } else if (QInputDialog *inputDialog = qobject_cast<QInputDialog *>(widget)) {
+            // Значения по умолчанию: модель по имени папки с файлами
+            inputDialog->accept();
+        } else if (QMessageBox *messageBox = qobject_cast<QMessageBox *>(widget)) {
+            message = messageBox->text();
+            messages++;
+            messageBox->accept();
+        } else if (QDialog *dialog = qobject_cast<QDialog *>(widget)) {
+            dialog->reject();
+        }
+    }
+
+    QString directory;
+    QTimer timer;
+    int messages = 0;
+    QString message;
+};
+
+void spin(int milliseconds)
+{
+    QEventLoop loop;
+    QTimer::singleShot(milliseconds, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+bool waitFor(const std::function<bool()> &done, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        spin(10);
+    }
+    return true;
+}
+
+// Один шаг сценария: действие, ожидание результата на экране и хвост settleMs,
+// за который досчитываются отложенные обновления
+class Scenario
+{
+public:
+    Scenario(BenchmarkRunner &runner, int settleMs, int timeoutMs)
+        : runner(runner), settleMs(settleMs), timeoutMs(timeoutMs) {}
+
+    bool step(const QString &name, const std::function<void()> &action, const std::function<bool()> &done)
+    {
+        // Общую гистограмму не сбрасываем - в нее пишет сторож, ее читает диагностика.
+        // Шаг - разница снимков до и после
+        StallWatchdog &watchdog = StallWatchdog::instance();
+        const quint64 stallsBefore = watchdog.stallCount();
+        LatencyHistogram before;
+        before.merge(watchdog.latency());
+
+        QElapsedTimer timer;
+        timer.start();
+        action();
+        const bool completed = waitFor(done, timeoutMs);
+        const double elapsedMs = timer.nsecsElapsed() / 1e6;
+        spin(settleMs);
+
+        LatencyHistogram loop;
+        loop.merge(watchdog.latency());
+        loop.subtract(before);
+
+        // Журнал - кольцо: новые записи шага в его конце
+        QStringList stalls;
+        const QList<EventLoopStall> entries = watchdog.stalls();
+        const int added = int(qMin<quint64>(watchdog.stallCount() - stallsBefore, entries.size()));
+        for (int i = entries.size() - added; i < entries.size(); ++i) {
+            stalls.append(entries[i].toString());
+        }
+
+        BenchmarkResult result;
+        result.name = "gui/" + name;
+        result.iterations = 1;
+        result.minMs = result.medianMs = result.meanMs = result.maxMs = elapsedMs;
+        result.parameters = {
+            {"completed", completed},
+            {"worst_stall_ms", loop.maxUs() / 1000.0},
+            {"p99_stall_ms", loop.percentileUs(99) / 1000.0},
+            {"pings", qint64(loop.count())},
+            {"stalls", stalls}
+        };
+        runner.add(result);
+        QTextStream(stderr) << QString("    worst %1 ms, p99 %2 ms").arg(loop.maxUs() / 1000.0, 0, 'f', 1)
+                                   .arg(loop.percentileUs(99) / 1000.0, 0, 'f', 1)
+                            << (stalls.isEmpty() ? QString() : "; " + stalls.join(", "))
+                            << (completed ? "" : " (timeout)") << "\n";
+
+        total.merge(loop);
+        return completed;
+    }
+
+    const LatencyHistogram &totalLatency() const { return total; }
+
+private:
+    BenchmarkRunner &runner;
+    int settleMs;
+    int timeoutMs;
+    LatencyHistogram total;
+};
+
+// База, которую видит окно при запуске: результаты и библиотека материалов
+bool prepareDatabase(const QString &path, qint64 rows, int models, int materials, quint64 seed)
+{
+    Database database("guibench_setup");
+    if (!database.initDatabase(path)) {
+        return false;
+    }
+
+    const int nodesPerSet = int(qMax<qint64>(1, rows / (models * calculationTypes.size())));
+    for (int model = 0; model < models; ++model) {
+        QList<QPair<QString, ParsedData>> batch;
+        for (int type = 0; type < calculationTypes.size(); ++type) {
+            const QString unit = calculationTypes[type].contains("Stress") ? "Pa" : "m";
+            batch.append({modelName(model), generateParsedData(calculationTypes[type], unit, 1, nodesPerSet,
+                                                               seed + quint64(model * 16 + type))});
+        }
+        if (database.addCalculationResults(batch) < 0) {
+            return false;
+        }
+    }
+
+    QList<ParsedMaterial> library;
+    for (int i = 0; i < materials; ++i) {
+        library.append(generateParsedMaterial(i, 12, seed));
+    }
+    return database.importParsedMaterials(library);
+}
+
+bool prepareImportFolder(const QString &path, int files, int nodes, quint64 seed)
+{
+    if (!QDir().mkpath(path)) {
+        return false;
+    }
+    for (int i = 0; i < files; ++i) {
+        ResultFileOptions options;
+        options.nodes = nodes;
+        options.calculationType = calculationTypes[i % calculationTypes.size()];
+        options.unit = options.calculationType.contains("Stress") ? "MPa" : "mm";
+        options.seed = seed + 100 + i;
+
+        QFile file(QDir(path).filePath(resultFileName(options.calculationType, i)));
+        const QByteArray data = generateResultFile(options);
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool firstRowMatches(QTableWidget *table, const QString &model, const QString &type)
+{
+    if (table->rowCount() == 0 || !table->item(0, 0) || !table->item(0, 2)) {
+        return false;
+    }
+    return (model.isEmpty() || table->item(0, 0)->text() == model)
+           && (type.isEmpty() || table->item(0, 2)->text() == type);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    // Диалоги Qt, а не системные: их закрывает ModalResponder
+    QCoreApplication::setAttribute(Qt::AA_DontUseNativeDialogs);
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("bd_lab3_guibench");
+    app.setStyle("Fusion");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Scripted GUI responsiveness benchmark: drives MainWindow on a large synthetic database\n"
+        "and reports event-loop stalls per step. Headless: QT_QPA_PLATFORM=offscreen.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {{"o", "out"}, "JSON report file, '-' for stdout (default: bench_gui.json).", "file",
+         "bench_gui.json"},
+        {"rows", "Result rows in the database at startup (default: 1000000).", "count", "1000000"},
+        {"models", "Models the rows are spread over (default: 8).", "count", "8"},
+        {"materials", "Materials (default: 20000).", "count", "20000"},
+        {"files", "Result files loaded through the GUI (default: 8).", "count", "8"},
+        {"nodes", "Nodes per loaded file (default: 100000).", "count", "100000"},
+        {"interval", "Event-loop probe interval, ms (default: 5).", "ms", "5"},
+        {"stall-ms", "Stalls longer than this are listed with the GUI activity (BD_GUI_ACTIVITY) that "
+                     "blocked the event loop (default: 100).", "ms", "100"},
+        {"timeout", "Maximum time for one step, s (default: 600).", "s", "600"},
+        {"fail-over", "Exit with 1 if the worst stall exceeds this, ms.", "ms"},
+        {"dir", "Directory for the temporary database (default: system temp).", "path"},
+        {"seed", "Generator seed (default: 1).", "seed", "1"}
+    });
+    parser.process(app);
+
+    const qint64 rows = qMax<qint64>(1, parser.value("rows").toLongLong());
+    const int models = qMax(1, parser.value("models").toInt());
+    const int materials = qMax(1, parser.value("materials").toInt());
+    const int files = qMax(1, parser.value("files").toInt());
+    const int nodes = qMax(1, parser.value("nodes").toInt());
+    const quint64 seed = parser.value("seed").toULongLong();
+    // Путь отчета - до смены текущей папки
+    const QString out = parser.value("out") == "-" ? QString("-")
+                                                   : QFileInfo(parser.value("out")).absoluteFilePath();
+
+    QTemporaryDir temporaryDir(parser.isSet("dir")
+                                   ? QDir(parser.value("dir")).filePath("bd_lab3_guibench-XXXXXX")
+                                   : QDir::tempPath() + "/bd_lab3_guibench-XXXXXX");
+    if (!temporaryDir.isValid()) {
+        QTextStream(stderr) << "Cannot create temporary directory\n";
+        return 2;
+    }
+
+    // MainWindow открывает materials.db в текущей папке
+    const QDir dir(temporaryDir.path());
+    QDir::setCurrent(dir.path());
+    const QString importPath = dir.filePath("Bracket");
+
+    QTextStream(stderr) << "Preparing " << rows << " result rows and " << materials << " materials...\n";
+    if (!prepareDatabase(dir.filePath("materials.db"), rows, models, materials, seed)
+        || !prepareImportFolder(importPath, files, nodes, seed)) {
+        QTextStream(stderr) << "Cannot prepare synthetic data\n";
+        return 2;
+    }
+
+    BenchmarkRunner runner("gui");
+    runner.setContext("rows", rows);
+    runner.setContext("models", models);
+    runner.setContext("materials", materials);
+    runner.setContext("import_rows", qint64(files) * nodes);
+    runner.setContext("interval_ms", parser.value("interval").toInt());
+    runner.setContext("seed", QString::number(seed));
+
+    StallWatchdog &watchdog = StallWatchdog::instance();
+    watchdog.setThresholdMs(parser.value("stall-ms").toInt());
+    watchdog.start(parser.value("interval").toInt());
+
+    ModalResponder responder(importPath);
+    Scenario scenario(runner, 200, parser.value("timeout").toInt() * 1000);
+
+    std::unique_ptr<MainWindow> window;
+    QTableWidget *table = nullptr;
+
+    // Запуск: словари, списки моделей и материалов, первая выборка "все модели"
+    scenario.step("startup", [&]() {
+        window = std::make_unique<MainWindow>();
+        window->resize(1280, 800);
+        window->show();
+        table = window->findChild<QTableWidget *>("resultsTable");
+    }, [&]() { return table && table->rowCount() > 0; });
+
+    QComboBox *modelBox = window->findChild<QComboBox *>("modelComboBox");
+    QComboBox *typeBox = window->findChild<QComboBox *>("calcTypeComboBox");
+    QPushButton *loadDirectoryButton = window->findChild<QPushButton *>("loadDirectoryButton");
+    QLineEdit *searchEdit = window->findChild<QLineEdit *>("materialSearchEdit");
+    QListView *materialsView = window->findChild<QListView *>("materialsListView");
+    QTabWidget *tabs = window->findChild<QTabWidget *>("mainTabWidget");
+    if (!table || !modelBox || !typeBox || !loadDirectoryButton || !searchEdit || !materialsView || !tabs) {
+        QTextStream(stderr) << "MainWindow widgets not found\n";
+        return 2;
+    }
+
+    // Загрузка папки: диалоги, фоновая запись, слияние списков и перечитывание таблицы
+    const int messagesBefore = responder.messageCount();
+    scenario.step("importDirectory", [&]() { loadDirectoryButton->click(); }, [&]() {
+        return responder.messageCount() > messagesBefore && loadDirectoryButton->isEnabled()
+               && modelBox->findData("Bracket") >= 0;
+    });
+    QTextStream(stderr) << "    " << responder.lastMessage().section('\n', 0, 0) << "\n";
+
+    const QString model = modelName(qMin(1, models - 1));
+    scenario.step("filterModel", [&]() { modelBox->setCurrentIndex(modelBox->findData(model)); },
+                  [&]() { return firstRowMatches(table, model, QString()); });
+
+    scenario.step("filterType", [&]() { typeBox->setCurrentIndex(typeBox->findData(calculationTypes[0])); },
+                  [&]() { return firstRowMatches(table, model, calculationTypes[0]); });
+
+    // Второй раз та же выборка - из кэша
+    scenario.step("filterTypeAgain", [&]() {
+        typeBox->setCurrentIndex(0);
+        typeBox->setCurrentIndex(typeBox->findData(calculationTypes[0]));
+    }, [&]() { return firstRowMatches(table, model, calculationTypes[0]); });
+
+    int filteredRows = 0;
+    scenario.step("filterAllModels", [&]() {
+        filteredRows = table->rowCount();
+        typeBox->setCurrentIndex(0);
+        modelBox->setCurrentIndex(0);
+    }, [&]() { return table->rowCount() > filteredRows; });
+
+    // Сортировка QTableWidget синхронная - ее и меряем
+    scenario.step("sortByValue", [&]() {
+        BD_GUI_ACTIVITY("QTableWidget::sortItems");
+        table->sortItems(3, Qt::DescendingOrder);
+    }, []() { return true; });
+
+    scenario.step("sortByNode", [&]() {
+        BD_GUI_ACTIVITY("QTableWidget::sortItems");
+        table->sortItems(1, Qt::AscendingOrder);
+    }, []() { return true; });
+
+    // Поиск материала с набором по буквам (около 15 символов в секунду)
+    QAbstractItemModel *materialsModel = materialsView->model();
+    scenario.step("materialSearchTyping", [&]() {
+        tabs->setCurrentIndex(1);
+        for (const QChar ch : QString("aluminum 12")) {
+            searchEdit->setText(searchEdit->text() + ch);
+            spin(66);
+        }
+    }, [&]() { return materialsModel->rowCount() > 0 && materialsModel->rowCount() < materials; });
+
+    scenario.step("materialSearchClear", [&]() { searchEdit->clear(); },
+                  [&]() { return materialsModel->rowCount() >= materials; });
+
+    // Подбор по диапазону плотности
+    QComboBox *propertyBox = window->findChild<QComboBox *>("selectionPropertyComboBox");
+    QLineEdit *minEdit = window->findChild<QLineEdit *>("selectionMinEdit");
+    QLineEdit *maxEdit = window->findChild<QLineEdit *>("selectionMaxEdit");
+    QPushButton *addCriterionButton = window->findChild<QPushButton *>("addCriterionButton");
+    QPushButton *runSelectionButton = window->findChild<QPushButton *>("runSelectionButton");
+    if (propertyBox && minEdit && maxEdit && addCriterionButton && runSelectionButton) {
+        scenario.step("materialSelection", [&]() {
+            propertyBox->setCurrentIndex(qMax(0, propertyBox->findText("Density", Qt::MatchStartsWith)));
+            minEdit->setText("5000");
+            maxEdit->setText("9000");
+            addCriterionButton->click();
+            runSelectionButton->click();
+        }, []() { return true; });
+    }
+
+    tabs->setCurrentIndex(0);
+    window.reset();
+    watchdog.stop();
+
+    const LatencyHistogram &total = scenario.totalLatency();
+    runner.setContext("worst_stall_ms", total.maxUs() / 1000.0);
+    runner.setContext("p99_stall_ms", total.percentileUs(99) / 1000.0);
+    runner.setContext("stalls", qint64(watchdog.stallCount()));
+    QTextStream(stderr) << QString("Total: worst %1 ms, p99 %2 ms, %3 stalls over %4 ms\n")
+                               .arg(total.maxUs() / 1000.0, 0, 'f', 1)
+                               .arg(total.percentileUs(99) / 1000.0, 0, 'f', 1)
+                               .arg(watchdog.stallCount())
+                               .arg(watchdog.thresholdMs());
+
+    QString error;
+    if (!runner.writeReport(out, &error)) {
+        QTextStream(stderr) << error << "\n";
+        return 2;
+    }
+
+    if (parser.isSet("fail-over") && total.maxUs() > parser.value("fail-over").toLongLong() * 1000) {
+        return 1;
+    }
+    return 0;
+}
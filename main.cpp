@@ -1,6 +1,12 @@
 #include <QApplication>
+#include <QDebug>
+#include <QMessageBox>
 #include <QSqlDatabase>
 #include "mainwindow.h"
+#include "memorybudget.h"
+#include "snapshotviewer.h"
+#include "stallwatchdog.h"
+#include "tracer.h"
 
 int main(int argc, char *argv[])
 {
@@ -9,9 +15,50 @@ int main(int argc, char *argv[])
     // Устанавливаем стиль приложения
     app.setStyle("Fusion");
 
+    // bd_lab3 --snapshot study.bdsnap - только просмотр снимка, без базы данных
+    const QStringList arguments = app.arguments();
+    int snapshotArgument = arguments.indexOf("--snapshot");
+    if (snapshotArgument >= 0 && snapshotArgument + 1 < arguments.size()) {
+        SnapshotViewer viewer;
+        if (!viewer.openSnapshot(arguments[snapshotArgument + 1])) {
+            QMessageBox::critical(nullptr, "Snapshot Error", viewer.errorString());
+            return 1;
+        }
+        viewer.show();
+        return app.exec();
+    }
+
+    // BD_TRACE=trace.json - трасса сессии в формате Chrome (сборка с CONFIG+=tracing),
+    // BD_TRACE_DETAIL=1 - вместе с мелкими интервалами
+    const QString traceFile = qEnvironmentVariable("BD_TRACE");
+    if (!traceFile.isEmpty()) {
+        Tracer::setThreadName("GUI");
+        Tracer::start(qEnvironmentVariableIntValue("BD_TRACE_DETAIL") != 0);
+    }
+
+    // Сторож цикла событий: зависания дольше BD_STALL_MS (по умолчанию 250 мс) пишутся
+    // в лог с занятием GUI-потока. Запуск до окна - долгий старт тоже попадет в журнал
+    StallWatchdog &watchdog = StallWatchdog::instance();
+    if (qEnvironmentVariableIsSet("BD_STALL_MS")) {
+        watchdog.setThresholdMs(qEnvironmentVariableIntValue("BD_STALL_MS"));
+    }
+    watchdog.start();
+
+    // BD_MEMORY_LIMIT_MB - бюджет памяти (кэши вытесняются, загрузка ждет); меняется на вкладке "Диагностика"
+    if (qEnvironmentVariableIsSet("BD_MEMORY_LIMIT_MB")) {
+        MemoryBudget::instance().setLimitBytes(qint64(qEnvironmentVariableIntValue("BD_MEMORY_LIMIT_MB")) * 1048576);
+    }
+
     // Создаем и показываем главное окно
     MainWindow window;
     window.show();
 
-    return app.exec();
+    int status = app.exec();
+    watchdog.stop();
+
+    QString traceError;
+    if (!traceFile.isEmpty() && !Tracer::writeChromeTrace(traceFile, &traceError)) {
+        qDebug() << traceError;
+    }
+    return status;
 }
@@ -0,0 +1,12 @@
+#include <QCoreApplication>
+#include "commandlinetool.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bd_lab3_cli");
+
+    // Консольный режим без GUI: одна команда на запуск
+    CommandLineTool tool;
+    return tool.run(app.arguments());
+}
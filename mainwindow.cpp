@@ -1,18 +1,53 @@
 #include "mainwindow.h"
 #include "materialimportdialog.h"
+#include "substitutedialog.h"
+#include "unitregistry.h"
+#include "snapshotviewer.h"
+#include "diagnosticspanel.h"
+#include "metrics.h"
+#include "stallwatchdog.h"
+#include "tracer.h"
 #include <QApplication>
+#include <QScopeGuard>
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <cmath>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , db(new Database(this))
-    , parser(new FileParser(this))
+    , selector(db)
 {
+    BD_GUI_ACTIVITY("MainWindow::MainWindow");
     // Инициализация базы данных
     if (!db->initDatabase()) {
         QMessageBox::critical(this, "Database Error",
                               "Failed to initialize database!");
         exit(1);
     }
+    resultStore.setDatabaseName(db->getDatabase().databaseName());
+
+    MemoryBudget &budget = MemoryBudget::instance();
+    resultCacheSource = budget.addSource(MemorySubsystem::Caches, "Кэш выборок",
+                                         [this]() { return resultCache.memoryBytes(); },
+                                         [this](qint64 bytes) { return resultCache.trim(bytes); });
+    resultStoreSource = budget.addSource(MemorySubsystem::Caches, "Наборы результатов",
+                                         [this]() { return resultStore.memoryBytes(); },
+                                         [this](qint64 bytes) { return resultStore.trim(bytes); });
+
+    ingestWatcher = new QFutureWatcher<BatchIngestStats>(this);
+    exportWatcher = new QFutureWatcher<ResultExportStats>(this);
+    snapshotWatcher = new QFutureWatcher<QString>(this);
+
+    // Все поводы перечитать таблицу результатов сводятся в одно обновление
+    resultsRefresh = new RefreshScheduler(25, this);
+    resultsQueryWatcher = new QFutureWatcher<ResultsQueryResult>(this);
+    // Второй поток - чтобы новый запрос не ждал, пока отмененный дойдет до проверки токена
+    resultsQueryPool.setMaxThreadCount(2);
+    searchPool.setMaxThreadCount(2);
+
+    // Слежение за папкой пишет через отдельное соединение с тем же файлом
+    watchService = new WatchFolderService(db->getDatabase().databaseName(), this);
 
     setupUI();
     setupConnections();
@@ -20,12 +55,28 @@ MainWindow::MainWindow(QWidget *parent)
     // Загрузка начальных данных
     loadModels();
     loadCalculationTypes();
-    updateResultsTable();
+    resultsRefresh->request(RefreshScheduler::Startup);
     refreshMaterialsList();
 }
 
 MainWindow::~MainWindow()
 {
+    // Слежение за папкой останавливается первым: его пакеты не должны прийти в разрушаемое окно.
+    // Фоновая загрузка откатывается, поиск прерывается (он обращается к searchIndex)
+    watchService->stop();
+    ingestWatcher->cancel();
+    ingestWatcher->waitForFinished();
+    exportToken.cancel();
+    exportWatcher->cancel();
+    exportWatcher->waitForFinished();
+    snapshotWatcher->waitForFinished();
+    resultsQueryToken.cancel();
+    resultsQueryPool.waitForDone();
+    searchGeneration++;
+    searchPool.waitForDone();
+
+    MemoryBudget::instance().removeSource(resultCacheSource);
+    MemoryBudget::instance().removeSource(resultStoreSource);
 }
 
 void MainWindow::setupUI()
@@ -36,6 +87,8 @@ void MainWindow::setupUI()
 
     // Создаем вкладки
     mainTabWidget = new QTabWidget(this);
+    // Имена объектов ищет сценарий bd_lab3_guibench
+    mainTabWidget->setObjectName("mainTabWidget");
 
     // Вкладка 1: Результаты расчетов
     QWidget *resultsTab = new QWidget();
@@ -47,6 +100,10 @@ void MainWindow::setupUI()
     setupMaterialsTab(materialsTab);
     mainTabWidget->addTab(materialsTab, "Материалы");
 
+    // Вкладка 3: Диагностика
+    diagnosticsPanel = new DiagnosticsPanel(db, &resultCache, &resultStore);
+    mainTabWidget->addTab(diagnosticsPanel, "Диагностика");
+
     mainLayout->addWidget(mainTabWidget);
     setCentralWidget(centralWidget);
 
@@ -61,13 +118,46 @@ void MainWindow::setupResultsTab(QWidget *parent)
     // Панель управления
     QHBoxLayout *controlLayout = new QHBoxLayout();
 
-    loadFileButton = new QPushButton("📁 Загрузить файл результатов", parent);
+    loadFileButton = new QPushButton("📁 Загрузить файлы результатов", parent);
     loadFileButton->setIconSize(QSize(20, 20));
+    loadDirectoryButton = new QPushButton("📂 Загрузить папку", parent);
+    loadDirectoryButton->setObjectName("loadDirectoryButton");
+    loadDirectoryButton->setIconSize(QSize(20, 20));
+    watchFolderButton = new QPushButton("👁 Следить за папкой", parent);
+    watchFolderButton->setCheckable(true);
+    watchStatusLabel = new QLabel(parent);
+    watchStatusLabel->setStyleSheet("color: gray;");
+
+    ingestProgress = new QProgressDialog(this);
+    ingestProgress->setWindowTitle("Загрузка результатов");
+    ingestProgress->setCancelButtonText("Отмена");
+    ingestProgress->setAutoClose(false);
+    ingestProgress->setAutoReset(false);
+    ingestProgress->reset();
+    ingestProgress->hide();
     exportButton = new QPushButton("📤 Экспорт результатов", parent);
     exportButton->setIconSize(QSize(20, 20));
+    exportButton->setToolTip("Экспорт результатов, попадающих под текущий фильтр");
+
+    saveSnapshotButton = new QPushButton("💾 Сохранить снимок", parent);
+    saveSnapshotButton->setToolTip("Снимок всех результатов для просмотра без базы данных");
+    openSnapshotButton = new QPushButton("📖 Открыть снимок", parent);
+
+    exportProgress = new QProgressDialog(this);
+    exportProgress->setWindowTitle("Экспорт результатов");
+    exportProgress->setCancelButtonText("Отмена");
+    exportProgress->setAutoClose(false);
+    exportProgress->setAutoReset(false);
+    exportProgress->reset();
+    exportProgress->hide();
 
     controlLayout->addWidget(loadFileButton);
+    controlLayout->addWidget(loadDirectoryButton);
+    controlLayout->addWidget(watchFolderButton);
+    controlLayout->addWidget(watchStatusLabel);
     controlLayout->addWidget(exportButton);
+    controlLayout->addWidget(saveSnapshotButton);
+    controlLayout->addWidget(openSnapshotButton);
     controlLayout->addStretch();
 
     layout->addLayout(controlLayout);
@@ -78,22 +168,29 @@ void MainWindow::setupResultsTab(QWidget *parent)
 
     filterLayout->addWidget(new QLabel("Модель:", parent));
     modelComboBox = new QComboBox(parent);
+    modelComboBox->setObjectName("modelComboBox");
     modelComboBox->addItem("Все модели", "");
     modelComboBox->setMinimumWidth(200);
     filterLayout->addWidget(modelComboBox);
 
     filterLayout->addWidget(new QLabel("Вид расчета:", parent));
     calcTypeComboBox = new QComboBox(parent);
+    calcTypeComboBox->setObjectName("calcTypeComboBox");
     calcTypeComboBox->addItem("Все типы", "");
     calcTypeComboBox->setMinimumWidth(200);
     filterLayout->addWidget(calcTypeComboBox);
 
     filterLayout->addStretch();
 
+    deleteResultsButton = new QPushButton("🗑 Удалить выбранное", parent);
+    deleteResultsButton->setToolTip("Удалить результаты, попадающие под текущий фильтр");
+    filterLayout->addWidget(deleteResultsButton);
+
     layout->addWidget(filterGroup);
 
     // Таблица результатов
     resultsTable = new QTableWidget(parent);
+    resultsTable->setObjectName("resultsTable");
     resultsTable->setColumnCount(4);
     QStringList headers = {"Модель", "Номер узла", "Вид расчета", "Значение"};
     resultsTable->setHorizontalHeaderLabels(headers);
@@ -124,16 +221,86 @@ void MainWindow::setupMaterialsTab(QWidget *parent)
     QHBoxLayout *searchLayout = new QHBoxLayout();
     searchLayout->addWidget(new QLabel("Поиск:", parent));
     materialSearchEdit = new QLineEdit(parent);
+    materialSearchEdit->setObjectName("materialSearchEdit");
     materialSearchEdit->setPlaceholderText("Введите название материала...");
     searchLayout->addWidget(materialSearchEdit);
 
+    searchDebounceTimer = new QTimer(this);
+    searchDebounceTimer->setSingleShot(true);
+    searchDebounceTimer->setInterval(150);
+    searchWatcher = new QFutureWatcher<QStringList>(this);
+
     leftLayout->addLayout(searchLayout);
 
+    // Подбор по диапазонам свойств
+    QGroupBox *selectionGroup = new QGroupBox("Подбор по свойствам", parent);
+    QVBoxLayout *selectionLayout = new QVBoxLayout(selectionGroup);
+
+    QHBoxLayout *criterionLayout = new QHBoxLayout();
+    selectionPropertyComboBox = new QComboBox(parent);
+    selectionPropertyComboBox->setObjectName("selectionPropertyComboBox");
+    selectionPropertyComboBox->setMinimumWidth(150);
+    selectionMinEdit = new QLineEdit(parent);
+    selectionMinEdit->setObjectName("selectionMinEdit");
+    selectionMinEdit->setPlaceholderText("мин");
+    selectionMaxEdit = new QLineEdit(parent);
+    selectionMaxEdit->setObjectName("selectionMaxEdit");
+    selectionMaxEdit->setPlaceholderText("макс");
+    addCriterionButton = new QPushButton("➕", parent);
+    addCriterionButton->setObjectName("addCriterionButton");
+
+    criterionLayout->addWidget(selectionPropertyComboBox, 1);
+    criterionLayout->addWidget(selectionMinEdit);
+    criterionLayout->addWidget(selectionMaxEdit);
+    criterionLayout->addWidget(addCriterionButton);
+    selectionLayout->addLayout(criterionLayout);
+
+    selectionCriteriaList = new QListWidget(parent);
+    selectionCriteriaList->setMaximumHeight(80);
+    selectionLayout->addWidget(selectionCriteriaList);
+
+    QHBoxLayout *rankLayout = new QHBoxLayout();
+    rankLayout->addWidget(new QLabel("Сортировка:", parent));
+    selectionRankComboBox = new QComboBox(parent);
+    selectionDescendingCheckBox = new QCheckBox("по убыванию", parent);
+    rankLayout->addWidget(selectionRankComboBox, 1);
+    rankLayout->addWidget(selectionDescendingCheckBox);
+    selectionLayout->addLayout(rankLayout);
+
+    QHBoxLayout *selectionButtonsLayout = new QHBoxLayout();
+    runSelectionButton = new QPushButton("🔍 Подобрать", parent);
+    runSelectionButton->setObjectName("runSelectionButton");
+    removeCriterionButton = new QPushButton("Удалить условие", parent);
+    resetSelectionButton = new QPushButton("Сбросить", parent);
+    previousPageButton = new QPushButton("◀", parent);
+    nextPageButton = new QPushButton("▶", parent);
+    previousPageButton->setEnabled(false);
+    nextPageButton->setEnabled(false);
+
+    selectionButtonsLayout->addWidget(runSelectionButton);
+    selectionButtonsLayout->addWidget(removeCriterionButton);
+    selectionButtonsLayout->addWidget(resetSelectionButton);
+    selectionButtonsLayout->addStretch();
+    selectionButtonsLayout->addWidget(previousPageButton);
+    selectionButtonsLayout->addWidget(nextPageButton);
+    selectionLayout->addLayout(selectionButtonsLayout);
+
+    selectionStatusLabel = new QLabel(parent);
+    selectionStatusLabel->setStyleSheet("color: gray;");
+    selectionLayout->addWidget(selectionStatusLabel);
+
+    leftLayout->addWidget(selectionGroup);
+
     // Список материалов
-    materialsListWidget = new QListWidget(parent);
-    materialsListWidget->setContextMenuPolicy(Qt::CustomContextMenu);
-    materialsListWidget->setSelectionMode(QAbstractItemView::SingleSelection);
-    leftLayout->addWidget(materialsListWidget, 1);
+    materialListModel = new MaterialListModel(this);
+    materialsListView = new QListView(parent);
+    materialsListView->setObjectName("materialsListView");
+    materialsListView->setModel(materialListModel);
+    materialsListView->setUniformItemSizes(true);
+    materialsListView->setContextMenuPolicy(Qt::CustomContextMenu);
+    materialsListView->setSelectionMode(QAbstractItemView::SingleSelection);
+    materialsListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    leftLayout->addWidget(materialsListView, 1);
 
     // Панель кнопок для материалов
     QHBoxLayout *materialButtonsLayout = new QHBoxLayout();
@@ -172,19 +339,20 @@ void MainWindow::setupMaterialsTab(QWidget *parent)
     rightLayout->addWidget(materialTitleLabel);
 
     // Таблица свойств
-    materialPropertiesTable = new QTableWidget(parent);
-    materialPropertiesTable->setColumnCount(3);
-    QStringList propHeaders = {"Свойство", "Значение", "Единица измерения"};
-    materialPropertiesTable->setHorizontalHeaderLabels(propHeaders);
-    materialPropertiesTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    materialPropertiesTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-    materialPropertiesTable->setAlternatingRowColors(true);
+    materialPropertiesModel = new MaterialPropertiesModel(db, this);
+    materialPropertiesView = new QTableView(parent);
+    materialPropertiesView->setModel(materialPropertiesModel);
+    materialPropertiesView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    materialPropertiesView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    materialPropertiesView->setSelectionMode(QAbstractItemView::SingleSelection);
+    materialPropertiesView->setAlternatingRowColors(true);
+    materialPropertiesView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
 
-    materialPropertiesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
-    materialPropertiesTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
-    materialPropertiesTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+    materialPropertiesView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    materialPropertiesView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    materialPropertiesView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
 
-    rightLayout->addWidget(materialPropertiesTable, 1);
+    rightLayout->addWidget(materialPropertiesView, 1);
 
     // Описание/примечания
     QLabel *descLabel = new QLabel("Примечания:", parent);
@@ -204,8 +372,66 @@ void MainWindow::setupConnections()
 {
     // Вкладка "Результаты расчетов"
     connect(loadFileButton, &QPushButton::clicked, this, &MainWindow::loadResultsFile);
+    connect(resultsRefresh, &RefreshScheduler::refreshRequested,
+            this, &MainWindow::updateResultsTable);
+    connect(resultsQueryWatcher, &QFutureWatcher<ResultsQueryResult>::finished,
+            this, &MainWindow::onResultsQueryFinished);
+    connect(loadDirectoryButton, &QPushButton::clicked, this, &MainWindow::loadResultsDirectory);
+    connect(watchFolderButton, &QPushButton::toggled, this, &MainWindow::toggleWatchFolder);
+
+    // Фоновая загрузка: прогресс в килобайтах разобранных данных, отмена откатывает транзакцию
+    connect(ingestWatcher, &QFutureWatcher<BatchIngestStats>::progressRangeChanged,
+            ingestProgress, &QProgressDialog::setRange);
+    connect(ingestWatcher, &QFutureWatcher<BatchIngestStats>::progressValueChanged,
+            ingestProgress, &QProgressDialog::setValue);
+    connect(ingestWatcher, &QFutureWatcher<BatchIngestStats>::progressTextChanged,
+            ingestProgress, &QProgressDialog::setLabelText);
+    connect(ingestProgress, &QProgressDialog::canceled,
+            ingestWatcher, &QFutureWatcher<BatchIngestStats>::cancel);
+    connect(ingestWatcher, &QFutureWatcher<BatchIngestStats>::finished,
+            this, &MainWindow::onResultIngestFinished);
+
+    // Таблица обновляется только после записи очередного пакета
+    connect(watchService, &WatchFolderService::resultsCommitted,
+            this, [this](const QStringList &models, const QStringList &calculationTypes,
+                         const QList<QPair<QString, QString>> &resultSets, qint64 rows) {
+        mergeIngestedResults(models, calculationTypes, resultSets);
+        watchStatusLabel->setText(QString("Загружено %1 узлов (%2)").arg(rows).arg(models.join(", ")));
+    });
+    connect(watchService, &WatchFolderService::ingestFailed, this, [](const QStringList &errors) {
+        for (const QString &error : errors) {
+            qDebug() << "Watch folder:" << error;
+        }
+    });
+    connect(watchService, &WatchFolderService::queueChanged, this, [this](int queued, int inFlight) {
+        if (watchService->isRunning()) {
+            watchFolderButton->setToolTip(QString("%1\nВ очереди: %2, загружается: %3")
+                                              .arg(watchService->directory())
+                                              .arg(queued).arg(inFlight));
+        }
+    });
     connect(exportButton, &QPushButton::clicked, this, &MainWindow::exportResults);
 
+    // Экспорт в фоне: прогресс в строках, отмена оставляет прежний файл
+    connect(exportWatcher, &QFutureWatcher<ResultExportStats>::progressRangeChanged,
+            exportProgress, &QProgressDialog::setRange);
+    connect(exportWatcher, &QFutureWatcher<ResultExportStats>::progressValueChanged,
+            exportProgress, &QProgressDialog::setValue);
+    connect(exportWatcher, &QFutureWatcher<ResultExportStats>::progressTextChanged,
+            exportProgress, &QProgressDialog::setLabelText);
+    connect(exportProgress, &QProgressDialog::canceled, this, [this]() {
+        exportToken.cancel();
+        exportWatcher->cancel();
+    });
+    connect(exportWatcher, &QFutureWatcher<ResultExportStats>::finished,
+            this, &MainWindow::onExportFinished);
+    connect(deleteResultsButton, &QPushButton::clicked, this, &MainWindow::deleteFilteredResults);
+    connect(saveSnapshotButton, &QPushButton::clicked, this, &MainWindow::saveResultSnapshot);
+    connect(openSnapshotButton, &QPushButton::clicked, this, &MainWindow::openResultSnapshot);
+    connect(snapshotWatcher, &QFutureWatcher<QString>::finished,
+            this, &MainWindow::onResultSnapshotSaved);
+    connect(db, &Database::resultsChanged, this, &MainWindow::onResultsChanged);
+
     connect(modelComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::filterByModel);
     connect(calcTypeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -225,134 +451,430 @@ void MainWindow::setupConnections()
 
     connect(materialSearchEdit, &QLineEdit::textChanged,
             this, &MainWindow::searchMaterials);
+    connect(searchDebounceTimer, &QTimer::timeout,
+            this, &MainWindow::runMaterialSearch);
+    connect(searchWatcher, &QFutureWatcher<QStringList>::finished,
+            this, &MainWindow::showMaterialSearchResults);
+
+    // Индекс поиска обновляется инкрементально вслед за базой
+    connect(db, &Database::materialAdded, this, [this](const QString &name) {
+        searchIndex.addMaterial(name);
+
+        // В отфильтрованный список новый материал не добавляем
+        if (materialSearchEdit->text().isEmpty() && selectionPredicates.isEmpty()) {
+            materialListModel->insertMaterial(name);
+            updateMaterialStats();
+        }
+    });
+    connect(db, &Database::materialRemoved, this, [this](const QString &name) {
+        searchIndex.removeMaterial(name);
 
-    connect(materialsListWidget, &QListWidget::currentRowChanged,
-            this, &MainWindow::onMaterialSelected);
-    connect(materialsListWidget, &QListWidget::customContextMenuRequested,
+        if (materialPropertiesModel->materialName() == name) {
+            materialPropertiesModel->clear();
+        }
+        materialListModel->removeMaterial(name);
+        updateMaterialStats();
+    });
+    connect(db, &Database::materialsReset, this, [this]() {
+        searchIndex.rebuild(db->getAllMaterials());
+        materialPropertiesModel->clear();
+    });
+
+    connect(materialsListView->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, [this](const QModelIndex &current) {
+        onMaterialSelected(current.isValid() ? current.row() : -1);
+    });
+    connect(materialsListView, &QListView::customContextMenuRequested,
             this, &MainWindow::showMaterialContextMenu);
 
-    connect(materialPropertiesTable, &QTableWidget::cellDoubleClicked,
+    connect(materialPropertiesView, &QTableView::doubleClicked,
             this, &MainWindow::editMaterialProperty);
+
+    // Подбор по свойствам
+    connect(addCriterionButton, &QPushButton::clicked,
+            this, &MainWindow::addSelectionCriterion);
+    connect(removeCriterionButton, &QPushButton::clicked,
+            this, &MainWindow::removeSelectionCriterion);
+    connect(runSelectionButton, &QPushButton::clicked,
+            this, &MainWindow::runMaterialSelection);
+    connect(resetSelectionButton, &QPushButton::clicked,
+            this, &MainWindow::resetMaterialSelection);
+    connect(previousPageButton, &QPushButton::clicked,
+            this, &MainWindow::showPreviousSelectionPage);
+    connect(nextPageButton, &QPushButton::clicked,
+            this, &MainWindow::showNextSelectionPage);
+
+    // Границы задаются в единицах СИ - подсказываем единицу выбранного свойства
+    connect(selectionPropertyComboBox, &QComboBox::currentTextChanged,
+            this, [this](const QString &propertyName) {
+        MaterialPropertyMatrix &matrix = db->materialMatrix();
+        int column = matrix.columnOf(propertyName);
+        QString unit = column >= 0 ? matrix.columnUnit(column) : QString();
+        selectionMinEdit->setPlaceholderText(unit.isEmpty() ? "мин" : "мин, " + unit);
+        selectionMaxEdit->setPlaceholderText(unit.isEmpty() ? "макс" : "макс, " + unit);
+    });
 }
 
 void MainWindow::loadResultsFile()
 {
-    QString fileName = QFileDialog::getOpenFileName(this,
-                                                    "Open Results File",
-                                                    "",
-                                                    "Text Files (*.txt *.csv);;All Files (*)");
+    QStringList fileNames = QFileDialog::getOpenFileNames(this,
+                                                          "Open Results Files",
+                                                          "",
+                                                          "Text Files (*.txt *.csv);;All Files (*)");
 
-    if (fileName.isEmpty()) {
+    if (fileNames.isEmpty()) {
         return;
     }
 
-    // Запрос имени модели
-    QString modelName = QInputDialog::getText(this,
-                                              "Model Name",
-                                              "Enter model name:",
-                                              QLineEdit::Normal,
-                                              QFileInfo(fileName).baseName());
+    ingestResultFiles(fileNames);
+}
+
+void MainWindow::loadResultsDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, "Open Results Directory");
+    if (directory.isEmpty()) {
+        return;
+    }
 
-    if (modelName.isEmpty()) {
+    QStringList fileNames = BatchIngest::collectFiles({directory});
+    if (fileNames.isEmpty()) {
+        QMessageBox::warning(this, "Warning", "No result files (*.txt, *.csv) found in directory");
         return;
     }
 
-    // Добавляем модель в базу данных
-    db->addModel(modelName);
+    ingestResultFiles(fileNames);
+}
 
-    // Парсим файл
-    QString error;
-    ParsedData data = parser->parseFile(fileName, error);
+bool MainWindow::askModelNamingRule(int fileCount, const QString &samplePath,
+                                    ModelNamingRule &rule)
+{
+    bool ok = false;
+
+    // Один файл - как раньше, только имя модели
+    if (fileCount == 1) {
+        rule.mode = ModelNamingRule::FixedName;
+        rule.fixedName = QInputDialog::getText(this,
+                                               "Model Name",
+                                               "Enter model name:",
+                                               QLineEdit::Normal,
+                                               QFileInfo(samplePath).baseName(),
+                                               &ok);
+        return ok && !rule.fixedName.isEmpty();
+    }
 
-    if (!error.isEmpty()) {
-        QMessageBox::warning(this, "Parse Error", error);
+    const QStringList modes = {
+        "Одна модель для всех файлов",
+        "Имя папки с файлом",
+        "По шаблону имени файла"
+    };
+    QString mode = QInputDialog::getItem(this,
+                                         "Model Name",
+                                         fileCount > 0
+                                             ? QString("Files: %1\nHow to assign models:").arg(fileCount)
+                                             : QString("How to assign models:"),
+                                         modes, 1, false, &ok);
+    if (!ok) {
+        return false;
+    }
+
+    if (mode == modes[0]) {
+        rule.mode = ModelNamingRule::FixedName;
+        rule.fixedName = QInputDialog::getText(this, "Model Name", "Enter model name:",
+                                               QLineEdit::Normal,
+                                               QFileInfo(samplePath).dir().dirName(), &ok);
+        return ok && !rule.fixedName.isEmpty();
+    }
+
+    if (mode == modes[1]) {
+        rule.mode = ModelNamingRule::ParentDirectory;
+        return true;
+    }
+
+    rule.mode = ModelNamingRule::FileNamePattern;
+    rule.pattern = QInputDialog::getText(this, "Model Name",
+                                         "Regular expression, group 1 is the model name:",
+                                         QLineEdit::Normal, rule.pattern, &ok);
+    return ok && QRegularExpression(rule.pattern).isValid();
+}
+
+void MainWindow::ingestResultFiles(const QStringList &fileNames)
+{
+    if (ingestWatcher->isRunning()) {
+        QMessageBox::information(this, "Loading", "Another set of files is still loading");
+        return;
     }
 
-    if (data.nodeValues.isEmpty()) {
-        QMessageBox::warning(this, "Warning", "No valid data found in file or file is empty");
+    ModelNamingRule rule;
+    if (!askModelNamingRule(fileNames.size(), fileNames.first(), rule)) {
         return;
     }
 
-    // Добавляем тип расчета, если его нет
-    db->addCalculationType(data.calculationType, data.unit);
+    // Разбор и запись - в фоне через свое соединение, окно остается отзывчивым
+    ingestProgress->setLabelText("Загрузка результатов...");
+    ingestProgress->setRange(0, 0);
+    ingestProgress->setValue(0);
+    ingestProgress->show();
+    loadFileButton->setEnabled(false);
+    loadDirectoryButton->setEnabled(false);
 
-    // Сохраняем результаты в базу данных
-    int count = 0;
-    int errorCount = 0;
+    ingestWatcher->setFuture(BatchIngest::runInBackground(db->getDatabase().databaseName(),
+                                                          fileNames, rule));
+}
 
-    for (auto it = data.nodeValues.begin(); it != data.nodeValues.end(); ++it) {
-        if (db->addCalculationResult(modelName, it.key(), data.calculationType, it.value())) {
-            count++;
-        } else {
-            errorCount++;
-            qDebug() << "Failed to add node:" << it.key() << "value:" << it.value();
-        }
+void MainWindow::onResultIngestFinished()
+{
+    ingestProgress->hide();
+    loadFileButton->setEnabled(true);
+    loadDirectoryButton->setEnabled(true);
+
+    QFuture<BatchIngestStats> future = ingestWatcher->future();
+    if (future.isCanceled() || future.resultCount() == 0) {
+        QMessageBox::information(this, "Cancelled", "Loading cancelled, no results were saved");
+        return;
     }
 
-    // Обновляем UI
-    loadModels();
-    loadCalculationTypes();
-    updateResultsTable();
+    BatchIngestStats stats = future.result();
+    for (const QString &error : stats.errors) {
+        qDebug() << "Batch ingest:" << error;
+    }
+
+    if (!stats.committed) {
+        QMessageBox::warning(this, "Error",
+                             "Failed to save results:\n" + stats.errors.mid(0, 10).join("\n"));
+        return;
+    }
+
+    mergeIngestedResults(stats.models, stats.calculationTypes, stats.resultSets);
 
-    QString message = QString("Loaded %1 nodes from file").arg(count);
-    if (errorCount > 0) {
-        message += QString("\nFailed to load %1 nodes").arg(errorCount);
+    QString message = QString("Loaded %1 nodes from %2 files in %3 ms")
+                          .arg(stats.rows).arg(stats.loadedFiles).arg(stats.totalMs);
+    if (stats.loadedFiles < stats.files) {
+        message += QString("\nSkipped %1 files:\n").arg(stats.files - stats.loadedFiles)
+                   + stats.errors.mid(0, 10).join("\n");
     }
 
     QMessageBox::information(this, "Success", message);
 }
 
-void MainWindow::updateResultsTable()
+void MainWindow::mergeIngestedResults(const QStringList &models, const QStringList &calculationTypes,
+                                      const QList<QPair<QString, QString>> &resultSets)
 {
-    QString modelFilter = modelComboBox->currentData().toString();
-    QString calcTypeFilter = calcTypeComboBox->currentData().toString();
+    BD_GUI_ACTIVITY("MainWindow::mergeIngestedResults");
+    // Дописываем только новые модели и виды расчетов, выбранные фильтры не сбрасываются
+    {
+        QSignalBlocker blocker(modelComboBox);
+        for (const QString &model : models) {
+            if (modelComboBox->findData(model) >= 0) {
+                continue;
+            }
+            int position = 1;
+            while (position < modelComboBox->count()
+                   && modelComboBox->itemData(position).toString() < model) {
+                position++;
+            }
+            modelComboBox->insertItem(position, model, model);
+        }
+    }
 
-    // Получаем все результаты
-    auto allResults = db->getCalculationResults(modelFilter);
+    bool newTypes = calculationTypes.isEmpty();
+    for (const QString &type : calculationTypes) {
+        if (calcTypeComboBox->findData(type) < 0) {
+            newTypes = true;
+        }
+    }
+    if (newTypes) {
+        loadCalculationTypes();
+    }
 
-    // Фильтруем результаты
-    QList<QVector<QVariant>> filteredResults;
+    // Кэш и таблица обновляются только для затронутых пар (модель, вид расчета)
+    for (const auto &resultSet : resultSets) {
+        onResultsChanged(resultSet.first, resultSet.second);
+    }
+}
 
-    for (const auto &row : allResults) {
-        if (!calcTypeFilter.isEmpty() && row[2].toString() != calcTypeFilter) {
-            continue;
-        }
-        filteredResults.append(row);
+void MainWindow::onResultsChanged(const QString &modelName, const QString &calculationType)
+{
+    BD_GUI_ACTIVITY("MainWindow::onResultsChanged");
+    resultCache.invalidate(modelName, calculationType);
+    resultStore.invalidate(modelName, calculationType);
+
+    // Таблицу перечитываем, только если изменения попадают под текущий фильтр
+    const ResultFilter filter = currentResultFilter();
+    if ((filter.modelName.isEmpty() || modelName.isEmpty() || filter.modelName == modelName)
+        && (filter.calculationType.isEmpty() || calculationType.isEmpty()
+            || filter.calculationType == calculationType)) {
+        resultsRefresh->request(RefreshScheduler::DataChanged);
+    }
+}
+
+ResultFilter MainWindow::currentResultFilter() const
+{
+    ResultFilter filter;
+    filter.modelName = modelComboBox->currentData().toString();
+    filter.calculationType = calcTypeComboBox->currentData().toString();
+    return filter;
+}
+
+void MainWindow::toggleWatchFolder(bool enabled)
+{
+    if (!enabled) {
+        watchService->stop();
+        watchStatusLabel->clear();
+        watchFolderButton->setToolTip(QString());
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, "Watch Results Directory");
+    ModelNamingRule rule;
+    if (directory.isEmpty() || !askModelNamingRule(0, directory + "/", rule)) {
+        watchFolderButton->setChecked(false);
+        return;
+    }
+
+    int reply = QMessageBox::question(this, "Watch Folder",
+                                      "Load files that are already in the folder?",
+                                      QMessageBox::Yes | QMessageBox::No);
+
+    if (!watchService->start(directory, rule, reply == QMessageBox::Yes)) {
+        QMessageBox::warning(this, "Error", "Cannot watch directory: " + directory);
+        watchFolderButton->setChecked(false);
+        return;
+    }
+
+    watchStatusLabel->setText("Слежение: " + QDir(directory).dirName());
+}
+
+void MainWindow::updateResultsTable(RefreshScheduler::Reasons reasons, quint64 generation)
+{
+    BD_TRACE_SCOPE("ui", "MainWindow::updateResultsTable");
+    BD_GUI_ACTIVITY("MainWindow::updateResultsTable");
+    Q_UNUSED(reasons);
+
+    // Вызывается только из RefreshScheduler - один запрос на пачку поводов.
+    // Незавершенный предыдущий запрос больше не нужен - прерываем его
+    resultsQueryToken.cancel();
+    resultsQueryToken = CancellationToken();
+
+    const ResultFilter filter = currentResultFilter();
+
+    // Уже просмотренная выборка показывается из кэша без запроса к базе
+    if (std::shared_ptr<const ResultBlock> cached = resultCache.find(filter)) {
+        showResults(*cached);
+        return;
+    }
+
+    ResultStore *store = &resultStore;
+    const CancellationToken token = resultsQueryToken;
+    const quint64 cacheVersion = resultCache.version();
+
+    // Холодные наборы store читает из базы сам, дальше выборка идет по памяти
+    const std::shared_ptr<QueuedJob> queued = Metrics::instance().jobQueued();
+    resultsQueryWatcher->setFuture(QtConcurrent::run(&resultsQueryPool,
+                                                     [store, filter, token, generation, cacheVersion,
+                                                      queued]() {
+        RunningJob job(queued);
+        ResultsQueryResult result;
+        result.generation = generation;
+        result.cacheVersion = cacheVersion;
+        result.filter = filter;
+
+        BD_TRACE_SCOPE("ui", "MainWindow::resultsQuery");
+        BD_METRIC_LATENCY("MainWindow::resultsQuery");
+        auto block = std::make_shared<ResultBlock>();
+        result.outcome = store->select(filter, *block, token);
+        result.block = block;
+        result.memory = std::make_shared<MemoryReservation>(MemorySubsystem::QueryResults,
+                                                            block->memoryBytes());
+        return result;
+    }));
+}
+
+void MainWindow::onResultsQueryFinished()
+{
+    BD_TRACE_SCOPE("ui", "MainWindow::onResultsQueryFinished");
+    BD_GUI_ACTIVITY("MainWindow::onResultsQueryFinished");
+    const ResultsQueryResult result = resultsQueryWatcher->result();
+    // Копия результата остается в watcher до следующего запроса - резерв снимаем сами
+    auto releaseMemory = qScopeGuard([&result]() { result.memory->release(); });
+
+    if (result.outcome.status == QueryStatus::Failed) {
+        qDebug() << "Failed to load calculation results:" << result.outcome.error;
+        return;
     }
 
-    // Показываем отфильтрованные результаты
-    showResults(filteredResults);
+    // Полная выборка пригодится, даже если ее уже не показываем; устаревшую кэш отклонит сам
+    if (result.outcome.isComplete()
+        && resultCache.insert(result.filter, result.block, result.cacheVersion)) {
+        MemoryBudget::instance().enforce();
+    }
+
+    // Отмененный или устаревший запрос не показываем - за ним уже идет новый
+    if (result.outcome.isCancelled() || !resultsRefresh->isCurrent(result.generation)) {
+        return;
+    }
+
+    showResults(*result.block);
 }
 
-void MainWindow::showResults(const QList<QVector<QVariant>>& results)
+void MainWindow::showResults(const ResultBlock &results)
 {
+    BD_TRACE_SCOPE("ui", "MainWindow::showResults");
+    BD_METRIC_LATENCY("MainWindow::showResults");
+    BD_GUI_ACTIVITY("MainWindow::showResults");
+    // Без сортировки и перерисовки на каждую ячейку
+    resultsTable->setUpdatesEnabled(false);
+    resultsTable->setSortingEnabled(false);
     resultsTable->setRowCount(results.size());
 
-    for (int i = 0; i < results.size(); ++i) {
-        const QVector<QVariant>& row = results[i];
+    // Результаты хранятся в СИ - переводим в единицы исходных файлов.
+    // Перевод ищется один раз на вид расчета из словаря блока
+    QHash<QString, QString> siUnits;
+    for (const auto &type : db->getAllCalculationTypes()) {
+        siUnits.insert(type.first, type.second);
+    }
+    const QHash<QString, QString> displayUnits = db->getCalculationTypeDisplayUnits();
 
-        for (int j = 0; j < row.size(); ++j) {
-            QTableWidgetItem *item = new QTableWidgetItem(row[j].toString());
-            resultsTable->setItem(i, j, item);
-        }
+    QVector<UnitConversion> displayConversions;
+    for (const QString &type : results.calculationTypeNames()) {
+        const QString siUnit = siUnits.value(type);
+        displayConversions.append(UnitRegistry::instance().conversion(siUnit,
+                                                                      displayUnits.value(type, siUnit)));
     }
 
+    for (int i = 0; i < results.size(); ++i) {
+        const UnitConversion &conversion = displayConversions[results.calculationTypeIndex(i)];
+        QString valueText = conversion.known && !conversion.isIdentity()
+                                ? QString::number(conversion.toSI(results.value(i)), 'g', 10)
+                                : QString::number(results.value(i), 'g', 10);
+
+        resultsTable->setItem(i, 0, new QTableWidgetItem(results.modelName(i)));
+        resultsTable->setItem(i, 1, new QTableWidgetItem(results.nodeNumber(i)));
+        resultsTable->setItem(i, 2, new QTableWidgetItem(results.calculationType(i)));
+        resultsTable->setItem(i, 3, new QTableWidgetItem(valueText));
+    }
+
+    resultsTable->setSortingEnabled(true);
     resultsTable->resizeColumnsToContents();
+    resultsTable->setUpdatesEnabled(true);
+
+    // QTableWidgetItem с текстом и данными ролей - около 160 байт на ячейку
+    constexpr qint64 TableCellBytes = 160;
+    resultsTableMemory.resize(qint64(results.size()) * resultsTable->columnCount() * TableCellBytes);
 }
 
 void MainWindow::filterByModel()
 {
-    updateResultsTable();
+    resultsRefresh->request(RefreshScheduler::FilterChanged);
 }
 
 void MainWindow::filterByCalculationType()
 {
-    updateResultsTable();
+    resultsRefresh->request(RefreshScheduler::FilterChanged);
 }
 
 void MainWindow::filterByMaterial()
 {
-    updateResultsTable();
+    resultsRefresh->request(RefreshScheduler::FilterChanged);
 }
 
 void MainWindow::exportResults()
@@ -360,35 +882,141 @@ void MainWindow::exportResults()
     QString fileName = QFileDialog::getSaveFileName(this,
                                                     "Export Results",
                                                     "",
-                                                    "CSV Files (*.csv);;Text Files (*.txt)");
+                                                    "CSV Files (*.csv);;Text Files (*.txt);;"
+                                                    "Binary Results (*.bdr)");
 
     if (fileName.isEmpty()) {
         return;
     }
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "Error", "Cannot open file for writing");
+    // Экспортируется то, что выбрано в фильтрах; чтение, форматирование и запись - в фоне
+    exportProgress->setLabelText("Экспорт результатов...");
+    exportProgress->setRange(0, 0);
+    exportProgress->setValue(0);
+    exportProgress->show();
+    exportButton->setEnabled(false);
+
+    exportToken = CancellationToken();
+    exportWatcher->setFuture(ResultExporter::runInBackground(db->getDatabase().databaseName(),
+                                                             currentResultFilter(), fileName,
+                                                             ResultExporter::formatForFile(fileName),
+                                                             exportToken));
+}
+
+void MainWindow::onExportFinished()
+{
+    exportProgress->hide();
+    exportButton->setEnabled(true);
+
+    QFuture<ResultExportStats> future = exportWatcher->future();
+    if (future.isCanceled() || future.resultCount() == 0) {
+        QMessageBox::information(this, "Export", "Export cancelled, the file was not changed");
         return;
     }
 
-    QTextStream out(&file);
+    const ResultExportStats stats = future.result();
+    if (stats.outcome.isCancelled()) {
+        QMessageBox::information(this, "Export", "Export cancelled");
+        return;
+    }
+    if (!stats.ok()) {
+        QString error = stats.error.isEmpty() ? stats.outcome.error : stats.error;
+        QMessageBox::warning(this, "Error", "Export failed: " + error);
+        return;
+    }
 
-    // Заголовок
-    out << "Model,Node Number,Calculation Type,Value\n";
+    QMessageBox::information(this, "Success",
+                             QString("Results exported successfully (%1 rows, %2 MB in %3 ms)")
+                                 .arg(stats.rows)
+                                 .arg(stats.bytes / 1048576.0, 0, 'f', 1)
+                                 .arg(stats.elapsedMs));
+}
 
-    // Данные
-    auto results = db->getCalculationResults();
-    for (const auto &row : results) {
-        out << row[0].toString() << ","
-            << row[1].toString() << ","
-            << row[2].toString() << ","
-            << row[3].toString() << ","
-            << row[4].toString() << "\n";
+void MainWindow::saveResultSnapshot()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Results Snapshot", "",
+                                                    "Results Snapshot (*.bdsnap)");
+    if (fileName.isEmpty()) {
+        return;
     }
 
-    file.close();
-    QMessageBox::information(this, "Success", "Results exported successfully");
+    saveSnapshotButton->setEnabled(false);
+    saveSnapshotButton->setText("💾 Запись снимка...");
+
+    // Запись идет в фоне через свое соединение
+    const QString databaseName = db->getDatabase().databaseName();
+    const std::shared_ptr<QueuedJob> queued = Metrics::instance().jobQueued();
+    snapshotWatcher->setFuture(QtConcurrent::run([databaseName, fileName, queued]() {
+        RunningJob job(queued);
+        static std::atomic<int> connectionCounter{0};
+
+        Database reader(QString("result_snapshot_%1").arg(++connectionCounter));
+        if (!reader.openConnection(databaseName)) {
+            return QString("Cannot open database: " + databaseName);
+        }
+
+        QString error;
+        ResultSnapshot::write(&reader, fileName, &error);
+        return error;
+    }));
+}
+
+void MainWindow::onResultSnapshotSaved()
+{
+    saveSnapshotButton->setEnabled(true);
+    saveSnapshotButton->setText("💾 Сохранить снимок");
+
+    const QString error = snapshotWatcher->result();
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, "Error", "Failed to save snapshot: " + error);
+        return;
+    }
+    QMessageBox::information(this, "Success", "Snapshot saved");
+}
+
+void MainWindow::openResultSnapshot()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Open Results Snapshot", "",
+                                                    "Results Snapshot (*.bdsnap)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    SnapshotViewer *viewer = new SnapshotViewer(this);
+    viewer->setAttribute(Qt::WA_DeleteOnClose);
+    if (!viewer->openSnapshot(fileName)) {
+        QMessageBox::warning(this, "Error", viewer->errorString());
+        delete viewer;
+        return;
+    }
+    viewer->show();
+}
+
+void MainWindow::deleteFilteredResults()
+{
+    BD_GUI_ACTIVITY("MainWindow::deleteFilteredResults");
+    const ResultFilter filter = currentResultFilter();
+
+    QString scope = QString("модель: %1, вид расчета: %2")
+                        .arg(filter.modelName.isEmpty() ? "все" : filter.modelName,
+                             filter.calculationType.isEmpty() ? "все" : filter.calculationType);
+
+    QMessageBox::StandardButton reply = QMessageBox::question(this, "Удаление результатов",
+                                                              "Удалить результаты (" + scope + ")?",
+                                                              QMessageBox::Yes | QMessageBox::No);
+    if (reply != QMessageBox::Yes) {
+        return;
+    }
+
+    // Кэш сбрасывается и таблица перечитывается по сигналу resultsChanged
+    int removed = db->removeCalculationResults(filter.modelName, filter.calculationType);
+    if (removed < 0) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось удалить результаты");
+        return;
+    }
+
+    QMessageBox::information(this, "Удаление результатов",
+                             QString("Удалено значений: %1").arg(removed));
 }
 
 void MainWindow::importMatMLMaterials()
@@ -403,31 +1031,34 @@ void MainWindow::importMatMLMaterials()
 
 void MainWindow::refreshMaterialsList()
 {
-    materialsListWidget->clear();
-
+    BD_GUI_ACTIVITY("MainWindow::refreshMaterialsList");
     QStringList materials = db->getAllMaterials();
-    for (const QString &material : materials) {
-        QListWidgetItem *item = new QListWidgetItem(material);
-        materialsListWidget->addItem(item);
+    searchIndex.rebuild(materials);
+
+    // Введенный запрос остается в силе: список - его результат по новому индексу
+    if (!materialSearchEdit->text().trimmed().isEmpty()) {
+        runMaterialSearch();
+    } else {
+        searchGeneration++;
+        searchTruncated = false;
+        materialListModel->setMaterials(materials);
+        updateMaterialStats();
     }
-
-    updateMaterialStats();
+    updateSelectionProperties();
 }
 
 void MainWindow::onMaterialSelected(int row)
 {
-    if (row < 0) {
-        materialPropertiesTable->setRowCount(0);
+    QString materialName = materialListModel->materialAt(row);
+
+    if (materialName.isEmpty()) {
+        materialPropertiesModel->clear();
         materialDescriptionEdit->clear();
         deleteMaterialButton->setEnabled(false);
         exportMaterialButton->setEnabled(false);
         return;
     }
 
-    QListWidgetItem *item = materialsListWidget->item(row);
-    if (!item) return;
-
-    QString materialName = item->text();
     showMaterialDetails(materialName);
 
     deleteMaterialButton->setEnabled(true);
@@ -436,86 +1067,102 @@ void MainWindow::onMaterialSelected(int row)
 
 void MainWindow::showMaterialDetails(const QString &materialName)
 {
-    materialPropertiesTable->setRowCount(0);
-
-    // Получаем свойства материала с единицами измерения
-    auto properties = db->getMaterialPropertiesWithUnits(materialName);
-
-    int row = 0;
-    for (auto it = properties.begin(); it != properties.end(); ++it) {
-        QString propertyName = it.key();
-        QString unit = it.value().first;
-        double value = it.value().second;
-
-        materialPropertiesTable->insertRow(row);
-
-        QTableWidgetItem *nameItem = new QTableWidgetItem(propertyName);
-        QTableWidgetItem *valueItem = new QTableWidgetItem(QString::number(value, 'g', 6));
-        QTableWidgetItem *unitItem = new QTableWidgetItem(unit);
+    BD_GUI_ACTIVITY("MainWindow::showMaterialDetails");
+    // Модель берет значения из матрицы свойств и обновляет только изменившиеся строки
+    materialPropertiesModel->setMaterial(materialName);
+}
 
-        materialPropertiesTable->setItem(row, 0, nameItem);
-        materialPropertiesTable->setItem(row, 1, valueItem);
-        materialPropertiesTable->setItem(row, 2, unitItem);
+void MainWindow::searchMaterials(const QString &searchText)
+{
+    Q_UNUSED(searchText)
 
-        row++;
-    }
+    // Предыдущий поиск устарел; новый запустится после паузы в наборе
+    searchGeneration++;
+    searchDebounceTimer->start();
+}
 
-    materialPropertiesTable->resizeRowsToContents();
+void MainWindow::runMaterialSearch()
+{
+    const QString text = materialSearchEdit->text();
+    const int generation = ++searchGeneration;
+    // На одно совпадение больше лимита - чтобы знать, что список обрезан
+    const int limit = text.trimmed().isEmpty() ? -1 : SearchResultLimit + 1;
+
+    searchWatcherGeneration = generation;
+    searchWatcher->setFuture(QtConcurrent::run(&searchPool, [this, text, generation, limit]() {
+        return searchIndex.search(text, limit, [this, generation]() {
+            return searchGeneration.load() != generation;
+        });
+    }));
 }
 
-void MainWindow::searchMaterials(const QString &searchText)
+void MainWindow::showMaterialSearchResults()
 {
-    QStringList materials = db->getAllMaterials();
-    materialsListWidget->clear();
+    BD_GUI_ACTIVITY("MainWindow::showMaterialSearchResults");
+    // Результат отмененного или устаревшего запроса не показываем
+    if (searchWatcherGeneration != searchGeneration.load()) {
+        return;
+    }
 
-    for (const QString &material : materials) {
-        if (searchText.isEmpty() || material.contains(searchText, Qt::CaseInsensitive)) {
-            materialsListWidget->addItem(material);
-        }
+    QStringList materials = searchWatcher->result();
+    searchTruncated = materials.size() > SearchResultLimit;
+    if (searchTruncated) {
+        materials.resize(SearchResultLimit);
     }
+    materialListModel->setMaterials(materials);
 
     updateMaterialStats();
 }
 
 void MainWindow::editMaterialProperty()
 {
-    int row = materialPropertiesTable->currentRow();
+    int row = materialPropertiesView->currentIndex().row();
     if (row < 0) return;
 
-    QListWidgetItem *materialItem = materialsListWidget->currentItem();
-    if (!materialItem) return;
+    QString materialName = materialPropertiesModel->materialName();
+    if (materialName.isEmpty()) return;
 
-    QString materialName = materialItem->text();
-    QString propertyName = materialPropertiesTable->item(row, 0)->text();
-    QString currentValueStr = materialPropertiesTable->item(row, 1)->text();
-    QString unit = materialPropertiesTable->item(row, 2)->text();
+    QString propertyName = materialPropertiesModel->propertyName(row);
+    QString unit = materialPropertiesModel->unit(row);
+    double currentValue = materialPropertiesModel->value(row);
 
     bool ok;
-    double currentValue = currentValueStr.toDouble(&ok);
-    if (!ok) currentValue = 0.0;
-
-    double newValue = QInputDialog::getDouble(this,
-                                              "Редактирование свойства",
-                                              QString("Новое значение для '%1' (%2):")
-                                                  .arg(propertyName).arg(unit),
-                                              currentValue,
-                                              -1e9, 1e9, 6, &ok);
-
-    if (ok && db->updateMaterialProperty(materialName, propertyName, newValue)) {
-        // Обновляем в таблице
-        materialPropertiesTable->item(row, 1)->setText(QString::number(newValue, 'g', 6));
+
+    // Текстом, а не getDouble: значения в исходных единицах бывают любого порядка
+    // (модуль упругости в Па ~2e11, КТР ~1e-5), спин-бокс обрезал бы их
+    QString text = QInputDialog::getText(this,
+                                         "Редактирование свойства",
+                                         QString("Новое значение для '%1' (%2):")
+                                             .arg(propertyName).arg(unit),
+                                         QLineEdit::Normal,
+                                         QString::number(currentValue, 'g', 15), &ok);
+    if (!ok) {
+        return;
+    }
+
+    double newValue = text.trimmed().replace(',', '.').toDouble(&ok);
+    if (!ok || !std::isfinite(newValue)) {
+        QMessageBox::warning(this, "Ошибка", "Некорректное число: " + text);
+        return;
+    }
+
+    // В базе значение хранится в СИ
+    double siValue = UnitRegistry::instance().convert(newValue, unit,
+                                                      materialPropertiesModel->siUnit(row));
+
+    if (db->updateMaterialProperty(materialName, propertyName, siValue)) {
+        // Матрица свойств уже обновлена - перерисовываем строку
+        materialPropertiesModel->refreshRow(row);
         QMessageBox::information(this, "Успех", "Свойство обновлено");
-    } else if (ok) {
+    } else {
         QMessageBox::warning(this, "Ошибка", "Не удалось обновить свойство");
     }
 }
 
 void MainWindow::deleteMaterial()
 {
-    QListWidgetItem *currentItem = materialsListWidget->currentItem();
-    if (!currentItem) return;
-
-    QString materialName = currentItem->text();
+    QString materialName = currentMaterialName();
+    if (materialName.isEmpty()) return;
 
     int reply = QMessageBox::question(this,
                                       "Подтверждение удаления",
@@ -524,13 +1171,10 @@ void MainWindow::deleteMaterial()
                                       QMessageBox::Yes | QMessageBox::No);
 
     if (reply == QMessageBox::Yes) {
+        // Строку из списка и таблицу свойств убирает обработчик Database::materialRemoved
         if (db->removeMaterial(materialName)) {
-            delete materialsListWidget->takeItem(materialsListWidget->currentRow());
-            materialPropertiesTable->setRowCount(0);
             materialDescriptionEdit->clear();
 
-            updateMaterialStats();
-
             QMessageBox::information(this, "Успех", "Материал удален");
         } else {
             QMessageBox::warning(this, "Ошибка", "Не удалось удалить материал");
@@ -540,10 +1184,9 @@ void MainWindow::deleteMaterial()
 
 void MainWindow::exportMaterialData()
 {
-    QListWidgetItem *currentItem = materialsListWidget->currentItem();
-    if (!currentItem) return;
+    QString materialName = currentMaterialName();
+    if (materialName.isEmpty()) return;
 
-    QString materialName = currentItem->text();
     QString fileName = QFileDialog::getSaveFileName(this,
                                                     "Экспорт материала",
                                                     QString("%1.csv").arg(materialName),
@@ -564,11 +1207,14 @@ void MainWindow::exportMaterialData()
     out << "Свойство;Значение;Единица измерения\n";
 
     // Данные
-    auto properties = db->getMaterialProperties(materialName);
-    for (const auto &property : properties) {
-        out << property.first << ";"
-            << QString::number(property.second, 'g', 6) << ";"
-            << "\n";
+    MaterialPropertyMatrix &matrix = db->materialMatrix();
+    int materialRow = matrix.rowOf(materialName);
+    if (materialRow >= 0) {
+        for (int column : matrix.columnsOf(materialRow)) {
+            out << matrix.propertyName(column) << ";"
+                << QString::number(matrix.displayValue(materialRow, column), 'g', 6) << ";"
+                << matrix.displayUnit(materialRow, column) << "\n";
+        }
     }
 
     file.close();
@@ -577,23 +1223,20 @@ void MainWindow::exportMaterialData()
 
 void MainWindow::showMaterialStatistics()
 {
+    BD_GUI_ACTIVITY("MainWindow::showMaterialStatistics");
     QStringList materials = db->getAllMaterials();
     int totalMaterials = materials.size();
 
-    // Получаем все материалы со свойствами
-    auto allMaterials = db->getAllMaterialsWithProperties();
+    // Считаем по матрице свойств: число заполненных ячеек в каждой колонке
+    MaterialPropertyMatrix &matrix = db->materialMatrix();
     int totalProperties = 0;
+    int uniqueProperties = 0;
 
-    // Считаем общее количество свойств
-    for (auto it = allMaterials.begin(); it != allMaterials.end(); ++it) {
-        totalProperties += it->size();
-    }
-
-    // Считаем уникальные названия свойств
-    QSet<QString> uniqueProperties;
-    for (auto it = allMaterials.begin(); it != allMaterials.end(); ++it) {
-        for (auto propIt = it->begin(); propIt != it->end(); ++propIt) {
-            uniqueProperties.insert(propIt.key());
+    for (int column = 0; column < matrix.columnCount(); ++column) {
+        int filled = matrix.presence(column).count();
+        totalProperties += filled;
+        if (filled > 0) {
+            uniqueProperties++;
         }
     }
 
@@ -604,7 +1247,7 @@ void MainWindow::showMaterialStatistics()
                             "Среднее свойств на материал: %4")
                         .arg(totalMaterials)
                         .arg(totalProperties)
-                        .arg(uniqueProperties.size())
+                        .arg(uniqueProperties)
                         .arg(totalMaterials > 0 ?
                                  QString::number((double)totalProperties / totalMaterials, 'f', 2) : "0");
 
@@ -616,10 +1259,15 @@ void MainWindow::showMaterialStatistics()
         int maxDisplay = qMin(10, totalMaterials);
         int count = 0;
 
-        for (auto it = allMaterials.begin(); it != allMaterials.end() && count < maxDisplay; ++it) {
+        for (const QString &material : materials) {
+            if (count >= maxDisplay) {
+                break;
+            }
+
+            int materialRow = matrix.rowOf(material);
             stats += QString("\n  • %1: %2 свойств")
-                         .arg(it.key())
-                         .arg(it->size());
+                         .arg(material)
+                         .arg(materialRow >= 0 ? matrix.columnsOf(materialRow).size() : 0);
             count++;
         }
 
@@ -633,34 +1281,56 @@ void MainWindow::showMaterialStatistics()
 
 void MainWindow::showMaterialContextMenu(const QPoint &pos)
 {
-    QListWidgetItem *item = materialsListWidget->itemAt(pos);
-    if (!item) return;
+    QString materialName = materialListModel->materialAt(materialsListView->indexAt(pos).row());
+    if (materialName.isEmpty()) return;
 
     QMenu contextMenu(this);
 
     QAction *showDetailsAction = contextMenu.addAction("📋 Показать свойства");
     QAction *deleteAction = contextMenu.addAction("🗑️ Удалить");
     QAction *exportAction = contextMenu.addAction("📤 Экспорт");
+    QAction *substituteAction = contextMenu.addAction("🔁 Найти замену");
 
-    QAction *selectedAction = contextMenu.exec(materialsListWidget->mapToGlobal(pos));
+    QAction *selectedAction = contextMenu.exec(materialsListView->viewport()->mapToGlobal(pos));
 
     if (selectedAction == showDetailsAction) {
-        showMaterialDetails(item->text());
+        showMaterialDetails(materialName);
     } else if (selectedAction == deleteAction) {
         deleteMaterial();
     } else if (selectedAction == exportAction) {
         exportMaterialData();
+    } else if (selectedAction == substituteAction) {
+        findSubstituteMaterials(materialName);
     }
 }
 
+void MainWindow::findSubstituteMaterials(const QString &materialName)
+{
+    // Текущие условия подбора можно использовать как жесткие ограничения
+    SubstituteDialog dialog(db, &selector, materialName, selectionPredicates, this);
+    dialog.exec();
+}
+
 void MainWindow::updateMaterialStats()
 {
-    int count = materialsListWidget->count();
-    statsLabel->setText(QString("Найдено материалов: %1").arg(count));
+    int count = materialListModel->rowCount();
+    statsLabel->setText(searchTruncated
+                            ? QString("Показаны первые %1 совпадений - уточните запрос").arg(count)
+                            : QString("Найдено материалов: %1").arg(count));
+}
+
+QString MainWindow::currentMaterialName() const
+{
+    return materialListModel->materialAt(materialsListView->currentIndex().row());
 }
 
 void MainWindow::loadModels()
 {
+    BD_GUI_ACTIVITY("MainWindow::loadModels");
+    // clear/addItem не должны запускать фильтрацию на каждый элемент
+    QSignalBlocker blocker(modelComboBox);
+    QString currentModel = modelComboBox->currentData().toString();
+
     modelComboBox->clear();
     modelComboBox->addItem("Все модели", "");
 
@@ -668,16 +1338,181 @@ void MainWindow::loadModels()
     for (const QString &model : models) {
         modelComboBox->addItem(model, model);
     }
+
+    int index = modelComboBox->findData(currentModel);
+    modelComboBox->setCurrentIndex(qMax(0, index));
+    if (index < 0 && !currentModel.isEmpty()) {
+        resultsRefresh->request(RefreshScheduler::FilterChanged);
+    }
 }
 
 void MainWindow::loadCalculationTypes()
 {
+    BD_GUI_ACTIVITY("MainWindow::loadCalculationTypes");
+    QSignalBlocker blocker(calcTypeComboBox);
+    QString currentType = calcTypeComboBox->currentData().toString();
+
     calcTypeComboBox->clear();
     calcTypeComboBox->addItem("Все типы", "");
 
     auto types = db->getAllCalculationTypes();
+    const QHash<QString, QString> displayUnits = db->getCalculationTypeDisplayUnits();
     for (const auto &type : types) {
-        calcTypeComboBox->addItem(type.first + " (" + type.second + ")", type.first);
+        QString unit = displayUnits.value(type.first, type.second);
+        calcTypeComboBox->addItem(type.first + " (" + unit + ")", type.first);
+    }
+
+    int index = calcTypeComboBox->findData(currentType);
+    calcTypeComboBox->setCurrentIndex(qMax(0, index));
+    if (index < 0 && !currentType.isEmpty()) {
+        resultsRefresh->request(RefreshScheduler::FilterChanged);
+    }
+}
+
+
+void MainWindow::updateSelectionProperties()
+{
+    MaterialPropertyMatrix &matrix = db->materialMatrix();
+
+    QStringList properties;
+    for (int column = 0; column < matrix.columnCount(); ++column) {
+        if (matrix.presence(column).count() > 0) {
+            properties.append(matrix.propertyName(column));
+        }
+    }
+    properties.sort(Qt::CaseInsensitive);
+
+    QString currentProperty = selectionPropertyComboBox->currentText();
+    QString currentRank = selectionRankComboBox->currentData().toString();
+
+    selectionPropertyComboBox->clear();
+    selectionPropertyComboBox->addItems(properties);
+    selectionPropertyComboBox->setCurrentText(currentProperty);
+
+    selectionRankComboBox->clear();
+    selectionRankComboBox->addItem("По названию", "");
+    for (const QString &property : properties) {
+        selectionRankComboBox->addItem(property, property);
     }
+    selectionRankComboBox->setCurrentIndex(qMax(0, selectionRankComboBox->findData(currentRank)));
 }
 
+void MainWindow::addSelectionCriterion()
+{
+    QString propertyName = selectionPropertyComboBox->currentText();
+    if (propertyName.isEmpty()) {
+        return;
+    }
+
+    RangePredicate predicate;
+    predicate.propertyName = propertyName;
+
+    // Пустая граница - без ограничения; допускаем запятую как десятичный разделитель
+    bool minOk = true;
+    bool maxOk = true;
+    QString minText = selectionMinEdit->text().trimmed().replace(',', '.');
+    QString maxText = selectionMaxEdit->text().trimmed().replace(',', '.');
+
+    if (!minText.isEmpty()) {
+        predicate.minimum = minText.toDouble(&minOk);
+    }
+    if (!maxText.isEmpty()) {
+        predicate.maximum = maxText.toDouble(&maxOk);
+    }
+
+    if (!minOk || !maxOk || (minText.isEmpty() && maxText.isEmpty())) {
+        QMessageBox::warning(this, "Ошибка", "Укажите числовую нижнюю и/или верхнюю границу");
+        return;
+    }
+
+    selectionPredicates.append(predicate);
+    selectionCriteriaList->addItem(QString("%1: %2 … %3")
+                                       .arg(propertyName)
+                                       .arg(minText.isEmpty() ? "-∞" : minText)
+                                       .arg(maxText.isEmpty() ? "+∞" : maxText));
+
+    selectionMinEdit->clear();
+    selectionMaxEdit->clear();
+}
+
+void MainWindow::removeSelectionCriterion()
+{
+    int row = selectionCriteriaList->currentRow();
+    if (row < 0) {
+        return;
+    }
+
+    delete selectionCriteriaList->takeItem(row);
+    selectionPredicates.removeAt(row);
+}
+
+void MainWindow::runMaterialSelection()
+{
+    selectionPage = 0;
+    showSelectionPage();
+}
+
+void MainWindow::resetMaterialSelection()
+{
+    selectionPredicates.clear();
+    selectionCriteriaList->clear();
+    selectionPage = 0;
+    selectionPageCount = 0;
+    selectionStatusLabel->clear();
+    previousPageButton->setEnabled(false);
+    nextPageButton->setEnabled(false);
+
+    refreshMaterialsList();
+}
+
+void MainWindow::showPreviousSelectionPage()
+{
+    if (selectionPage > 0) {
+        selectionPage--;
+        showSelectionPage();
+    }
+}
+
+void MainWindow::showNextSelectionPage()
+{
+    if (selectionPage + 1 < selectionPageCount) {
+        selectionPage++;
+        showSelectionPage();
+    }
+}
+
+void MainWindow::showSelectionPage()
+{
+    BD_GUI_ACTIVITY("MainWindow::showSelectionPage");
+    const int pageSize = 50;
+
+    SelectionQuery query;
+    query.predicates = selectionPredicates;
+    query.rankBy = selectionRankComboBox->currentData().toString();
+    query.descending = selectionDescendingCheckBox->isChecked();
+    query.offset = selectionPage * pageSize;
+    query.limit = pageSize;
+
+    SelectionResult result = selector.select(query);
+    MaterialPropertyMatrix &matrix = db->materialMatrix();
+
+    QStringList names;
+    names.reserve(result.rows.size());
+    for (int row : result.rows) {
+        names.append(matrix.materialName(row));
+    }
+    searchTruncated = false;
+    materialListModel->setMaterials(names);
+
+    selectionPageCount = (result.totalMatches + pageSize - 1) / pageSize;
+    selectionStatusLabel->setText(QString("Найдено: %1 · стр. %2 из %3 · %4 мс")
+                                      .arg(result.totalMatches)
+                                      .arg(selectionPageCount > 0 ? selectionPage + 1 : 0)
+                                      .arg(selectionPageCount)
+                                      .arg(result.elapsedMs, 0, 'f', 2));
+
+    previousPageButton->setEnabled(selectionPage > 0);
+    nextPageButton->setEnabled(selectionPage + 1 < selectionPageCount);
+
+    updateMaterialStats();
+}
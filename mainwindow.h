@@ -13,6 +13,8 @@
 #include <QMessageBox>
 #include <QTabWidget>
 #include <QListWidget>
+#include <QListView>
+#include <QTableView>
 #include <QTextEdit>
 #include <QProgressDialog>
 #include <QHeaderView>
@@ -22,8 +24,37 @@
 #include <QMenu>
 #include <QAction>
 #include <QInputDialog>
+#include <QCheckBox>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
 #include "database.h"
 #include "fileparser.h"
+#include "batchingest.h"
+#include "watchfolderservice.h"
+#include "refreshscheduler.h"
+#include "resultcache.h"
+#include "resultstore.h"
+#include "resultexporter.h"
+#include "materialselector.h"
+#include "memorybudget.h"
+#include "materialsearchindex.h"
+#include "materiallistmodel.h"
+#include "materialpropertiesmodel.h"
+
+// Результат фонового запроса таблицы результатов
+struct ResultsQueryResult {
+    quint64 generation = 0;     // поколение RefreshScheduler, для которого выполнялся запрос
+    quint64 cacheVersion = 0;   // версия кэша на момент начала запроса
+    ResultFilter filter;
+    QueryOutcome outcome;
+    std::shared_ptr<const ResultBlock> block;
+    std::shared_ptr<MemoryReservation> memory;  // выборка в пути: до кэша или таблицы
+};
+
+class DiagnosticsPanel;
 
 class MainWindow : public QMainWindow
 {
@@ -36,11 +67,20 @@ public:
 private slots:
     // Вкладка "Результаты расчетов"
     void loadResultsFile();
-    void updateResultsTable();
+    void loadResultsDirectory();
+    void toggleWatchFolder(bool enabled);
+    void onResultIngestFinished();
+    void updateResultsTable(RefreshScheduler::Reasons reasons, quint64 generation);
+    void onResultsQueryFinished();
     void filterByModel();
     void filterByCalculationType();
     void filterByMaterial();
     void exportResults();
+    void onExportFinished();
+    void deleteFilteredResults();
+    void saveResultSnapshot();
+    void onResultSnapshotSaved();
+    void openResultSnapshot();
 
     // Вкладка "Материалы"
     void importMatMLMaterials();
@@ -48,13 +88,24 @@ private slots:
     void showMaterialDetails(const QString &materialName);
     void onMaterialSelected(int row);
     void searchMaterials(const QString &searchText);
+    void runMaterialSearch();
+    void showMaterialSearchResults();
     void editMaterialProperty();
     void deleteMaterial();
     void exportMaterialData();
     void showMaterialStatistics();
 
+    // Подбор материалов по диапазонам свойств
+    void addSelectionCriterion();
+    void removeSelectionCriterion();
+    void runMaterialSelection();
+    void resetMaterialSelection();
+    void showPreviousSelectionPage();
+    void showNextSelectionPage();
+
     // Контекстное меню материалов
     void showMaterialContextMenu(const QPoint &pos);
+    void findSubstituteMaterials(const QString &materialName);
 
 private:
     void setupUI();
@@ -63,30 +114,83 @@ private:
     void setupMaterialsTab(QWidget *parent);
 
     void loadModels();
+    void ingestResultFiles(const QStringList &fileNames);
+    bool askModelNamingRule(int fileCount, const QString &samplePath, ModelNamingRule &rule);
+    void mergeIngestedResults(const QStringList &models, const QStringList &calculationTypes,
+                              const QList<QPair<QString, QString>> &resultSets);
+    void onResultsChanged(const QString &modelName, const QString &calculationType);
+    ResultFilter currentResultFilter() const;
     void loadCalculationTypes();
-    void showResults(const QList<QVector<QVariant>>& results);
+    void showResults(const ResultBlock &results);
 
     // Методы для работы с материалами
     void displayMaterialProperties(const QString &materialName);
     void displayAllMaterials();
     void updateMaterialStats();
+    QString currentMaterialName() const;
+    void updateSelectionProperties();
+    void showSelectionPage();
 
     Database *db;
-    FileParser *parser;
+    WatchFolderService *watchService;
+    MaterialSelector selector;
+
+    // Нечеткий поиск: индекс, отложенный запуск и фоновое выполнение
+    MaterialSearchIndex searchIndex;
+    QTimer *searchDebounceTimer;
+    QFutureWatcher<QStringList> *searchWatcher;
+    // Поиск идет в своем пуле: при закрытии окна ждем только его, а не весь общий пул
+    QThreadPool searchPool;
+    std::atomic<int> searchGeneration{0};
+    int searchWatcherGeneration = 0;
+    // Поиск по тексту показывает не больше SearchResultLimit лучших совпадений
+    static constexpr int SearchResultLimit = 1000;
+    bool searchTruncated = false;
 
     // UI элементы для вкладки "Результаты расчетов"
     QTabWidget *mainTabWidget;
+    DiagnosticsPanel *diagnosticsPanel;
 
     // Вкладка "Результаты"
     QTableWidget *resultsTable;
     QComboBox *modelComboBox;
     QComboBox *calcTypeComboBox;
     QPushButton *loadFileButton;
+    QPushButton *loadDirectoryButton;
+    QPushButton *watchFolderButton;
+    QLabel *watchStatusLabel;
+    QProgressDialog *ingestProgress;
+    QFutureWatcher<BatchIngestStats> *ingestWatcher;
+    RefreshScheduler *resultsRefresh;
+
+    // Запрос таблицы идет в фоне через свое соединение; новый запрос отменяет предыдущий
+    QThreadPool resultsQueryPool;
+    QFutureWatcher<ResultsQueryResult> *resultsQueryWatcher;
+    CancellationToken resultsQueryToken;
+
+    // Недавние выборки результатов; сбрасываются по затронутым (модель, вид расчета)
+    ResultCache resultCache;
+    // Наборы результатов в памяти: выборки по фильтру идут без SQL
+    ResultStore resultStore;
+    // Источники бюджета памяти: при превышении сначала вытесняется кэш, затем наборы
+    int resultCacheSource = 0;
+    int resultStoreSource = 0;
+    // Ячейки resultsTable (оценка)
+    MemoryReservation resultsTableMemory{MemorySubsystem::Views};
     QPushButton *exportButton;
+    QProgressDialog *exportProgress;
+    QFutureWatcher<ResultExportStats> *exportWatcher;
+    CancellationToken exportToken;      // прерывает и подсчет строк, и чтение
+    QPushButton *saveSnapshotButton;
+    QPushButton *openSnapshotButton;
+    QFutureWatcher<QString> *snapshotWatcher;   // пустая строка - снимок записан
+    QPushButton *deleteResultsButton;
 
     // Вкладка "Материалы"
-    QListWidget *materialsListWidget;
-    QTableWidget *materialPropertiesTable;
+    QListView *materialsListView;
+    QTableView *materialPropertiesView;
+    MaterialListModel *materialListModel;
+    MaterialPropertiesModel *materialPropertiesModel;
     QTextEdit *materialDescriptionEdit;
     QLineEdit *materialSearchEdit;
     QPushButton *importMaterialsButton;
@@ -95,6 +199,25 @@ private:
     QPushButton *exportMaterialButton;
     QPushButton *statsButton;
 
+    // Панель подбора по свойствам
+    QComboBox *selectionPropertyComboBox;
+    QLineEdit *selectionMinEdit;
+    QLineEdit *selectionMaxEdit;
+    QPushButton *addCriterionButton;
+    QPushButton *removeCriterionButton;
+    QListWidget *selectionCriteriaList;
+    QComboBox *selectionRankComboBox;
+    QCheckBox *selectionDescendingCheckBox;
+    QPushButton *runSelectionButton;
+    QPushButton *resetSelectionButton;
+    QPushButton *previousPageButton;
+    QPushButton *nextPageButton;
+    QLabel *selectionStatusLabel;
+
+    QVector<RangePredicate> selectionPredicates;
+    int selectionPage = 0;
+    int selectionPageCount = 0;
+
     // Статистика
     QLabel *statsLabel;
 };
@@ -1,4 +1,5 @@
 #include "materialimportdialog.h"
+#include "stringinterner.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDirIterator>
@@ -226,7 +227,7 @@ void MaterialImportDialog::startImport()
                            .arg(material.isotropic ? "да" : "нет"));
 
             // Импортируем в базу данных
-            if (importMaterialToDatabase(material)) {
+            if (db->addParsedMaterial(material)) {
                 importedMaterials++;
                 logMessage(QString("    ✓ Успешно импортирован"));
             } else {
@@ -285,8 +286,11 @@ ParsedMaterial MaterialImportDialog::parseMatML(const QString &filePath)
     QXmlStreamReader xml(&file);
     QString currentPropId;
     QString currentMetaId;
+    QString currentParameterId;
     bool inPropertyDetails = false;
     bool inPropertyData = false;
+    bool inParameterDetails = false;
+    bool inParameterValue = false;
 
     while (!xml.atEnd() && !xml.hasError()) {
         QXmlStreamReader::TokenType token = xml.readNext();
@@ -304,18 +308,38 @@ ParsedMaterial MaterialImportDialog::parseMatML(const QString &filePath)
                 currentMetaId = xml.attributes().value("id").toString();
                 material.meta[currentMetaId] = PropertyMeta();
             }
+            else if (xml.name() == "ParameterDetails") {
+                inParameterDetails = true;
+                currentParameterId = xml.attributes().value("id").toString();
+            }
             else if (xml.name() == "PropertyData") {
                 inPropertyData = true;
                 currentPropId = xml.attributes().value("property").toString();
             }
+            else if (xml.name() == "ParameterValue" && inPropertyData && !currentPropId.isEmpty()) {
+                inParameterValue = true;
+
+                // Учитываем только первый параметр зависимости
+                ParsedCurve &curve = material.curves[currentPropId];
+                if (curve.parameterId.isEmpty()) {
+                    curve.parameterId = xml.attributes().value("parameter").toString();
+                }
+            }
             else if (xml.name() == "Data" && inPropertyData && !currentPropId.isEmpty()) {
                 QString text = xml.readElementText().trimmed();
 
-                // Преобразуем значение
-                bool ok;
-                double value = text.toDouble(&ok);
-                if (ok) {
-                    material.values[currentPropId] = value;
+                // Значение может быть списком точек: "2.1e11,2.0e11,1.9e11"
+                QVector<double> values = MaterialParser::parseDataList(text);
+                if (inParameterValue) {
+                    ParsedCurve &curve = material.curves[currentPropId];
+                    if (curve.abscissa.isEmpty()) {
+                        curve.abscissa = values;
+                    }
+                } else if (!values.isEmpty()) {
+                    material.values[currentPropId] = values.first();
+                    if (values.size() > 1) {
+                        material.curves[currentPropId].ordinate = values;
+                    }
                 }
 
                 // Проверяем на Isotropic
@@ -326,14 +350,25 @@ ParsedMaterial MaterialImportDialog::parseMatML(const QString &filePath)
             else if (xml.name() == "Name" && inPropertyDetails && !currentMetaId.isEmpty()) {
                 QString propertyName = xml.readElementText().trimmed();
                 if (!propertyName.isEmpty()) {
-                    material.meta[currentMetaId].name = propertyName;
+                    material.meta[currentMetaId].name = StringInterner::instance().intern(propertyName);
                 }
             }
             else if (xml.name() == "Unit" && inPropertyDetails && !currentMetaId.isEmpty()) {
                 xml.readNextStartElement(); // Name внутри Unit
                 if (xml.name() == "Name") {
                     QString unit = xml.readElementText().trimmed();
-                    material.meta[currentMetaId].unit = unit;
+                    material.meta[currentMetaId].unit = StringInterner::instance().intern(unit);
+                }
+            }
+            else if (xml.name() == "Name" && inParameterDetails && !currentParameterId.isEmpty()) {
+                material.parameters[currentParameterId].name =
+                    StringInterner::instance().intern(xml.readElementText().trimmed());
+            }
+            else if (xml.name() == "Unit" && inParameterDetails && !currentParameterId.isEmpty()) {
+                xml.readNextStartElement(); // Name внутри Unit
+                if (xml.name() == "Name") {
+                    material.parameters[currentParameterId].unit =
+                        StringInterner::instance().intern(xml.readElementText().trimmed());
                 }
             }
         }
@@ -342,6 +377,13 @@ ParsedMaterial MaterialImportDialog::parseMatML(const QString &filePath)
                 inPropertyDetails = false;
                 currentMetaId.clear();
             }
+            else if (xml.name() == "ParameterDetails") {
+                inParameterDetails = false;
+                currentParameterId.clear();
+            }
+            else if (xml.name() == "ParameterValue") {
+                inParameterValue = false;
+            }
             else if (xml.name() == "PropertyData") {
                 inPropertyData = false;
                 currentPropId.clear();
@@ -374,55 +416,6 @@ ParsedMaterial MaterialImportDialog::parseMatML(const QString &filePath)
     return material;
 }
 
-bool MaterialImportDialog::importMaterialToDatabase(const ParsedMaterial &material)
-{
-    if (material.name.isEmpty()) {
-        return false;
-    }
-
-    // Добавляем материал
-    if (!db->addMaterial(material.name)) {
-        return false;
-    }
-
-    // Добавляем свойства
-    for (auto it = material.meta.begin(); it != material.meta.end(); ++it) {
-        QString propertyId = it.key();
-        PropertyMeta meta = it.value();
-
-        if (meta.name.isEmpty()) {
-            continue;
-        }
-
-        // Получаем значение
-        double value = 0.0;
-        if (material.values.contains(propertyId)) {
-            value = material.values[propertyId];
-        } else {
-            // Пробуем найти значение по имени
-            for (auto valueIt = material.values.begin(); valueIt != material.values.end(); ++valueIt) {
-                QString valueKey = valueIt.key();
-                if (valueKey.contains(meta.name) || meta.name.contains(valueKey)) {
-                    value = valueIt.value();
-                    break;
-                }
-            }
-        }
-
-        // Добавляем свойство с значением
-        if (!db->addMaterialProperty(material.name, meta.name, meta.unit, value)) {
-            qDebug() << "Failed to add property:" << meta.name << "for material:" << material.name;
-        }
-    }
-
-    // Добавляем свойство Isotropic
-    if (material.isotropic) {
-        db->addMaterialProperty(material.name, "Isotropic", "dimensionless", 1.0);
-    }
-
-    return true;
-}
-
 void MaterialImportDialog::logMessage(const QString &message)
 {
     QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
@@ -38,7 +38,6 @@ private:
     void setupUI();
     void checkDirectory(const QString &dirPath);
     ParsedMaterial parseMatML(const QString &filePath);
-    bool importMaterialToDatabase(const ParsedMaterial &material);
     void logMessage(const QString &message);
 };
 
@@ -0,0 +1,77 @@
+#include "materiallistmodel.h"
+#include "modeldiff.h"
+#include <algorithm>
+
+MaterialListModel::MaterialListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int MaterialListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : names.size();
+}
+
+QVariant MaterialListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= names.size()) {
+        return QVariant();
+    }
+
+    if (role == Qt::DisplayRole || role == Qt::ToolTipRole) {
+        return names[index.row()];
+    }
+    return QVariant();
+}
+
+void MaterialListModel::setMaterials(const QStringList &materials)
+{
+    applyListDiff(names, materials,
+        [this](int first, int last) {
+            beginRemoveRows(QModelIndex(), first, last);
+            names.erase(names.begin() + first, names.begin() + last + 1);
+            endRemoveRows();
+        },
+        [this](int position, const QStringList &items) {
+            beginInsertRows(QModelIndex(), position, position + items.size() - 1);
+            for (int i = 0; i < items.size(); ++i) {
+                names.insert(position + i, items[i]);
+            }
+            endInsertRows();
+        },
+        [this](const QStringList &items) {
+            beginResetModel();
+            names = items;
+            endResetModel();
+        });
+}
+
+void MaterialListModel::insertMaterial(const QString &name)
+{
+    auto it = std::lower_bound(names.begin(), names.end(), name);
+    if (it != names.end() && *it == name) {
+        return;
+    }
+
+    int row = it - names.begin();
+    beginInsertRows(QModelIndex(), row, row);
+    names.insert(row, name);
+    endInsertRows();
+}
+
+void MaterialListModel::removeMaterial(const QString &name)
+{
+    int row = names.indexOf(name);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    names.removeAt(row);
+    endRemoveRows();
+}
+
+QString MaterialListModel::materialAt(int row) const
+{
+    return row >= 0 && row < names.size() ? names[row] : QString();
+}
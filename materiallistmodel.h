@@ -0,0 +1,33 @@
+#ifndef MATERIALLISTMODEL_H
+#define MATERIALLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+
+// Список названий материалов для QListView.
+// Обновляется точечными вставками/удалениями, без полного сброса модели.
+class MaterialListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit MaterialListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // Приводит список к materials вставками и удалениями; при большой перестановке - сбросом модели
+    void setMaterials(const QStringList &materials);
+
+    // Точечные изменения каталога (список отсортирован по названию)
+    void insertMaterial(const QString &name);
+    void removeMaterial(const QString &name);
+
+    QString materialAt(int row) const;
+    int rowOf(const QString &name) const { return names.indexOf(name); }
+
+private:
+    QStringList names;
+};
+
+#endif // MATERIALLISTMODEL_H
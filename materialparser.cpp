@@ -1,4 +1,6 @@
 #include "materialparser.h"
+#include "stringinterner.h"
+#include "tracer.h"
 
 MaterialParser::MaterialParser(QObject *parent) : QObject(parent)
 {
@@ -6,6 +8,7 @@ MaterialParser::MaterialParser(QObject *parent) : QObject(parent)
 
 ParsedMaterial MaterialParser::parseMatML(const QString &path)
 {
+    BD_TRACE_SCOPE("parse", "MaterialParser::parseMatML");
     ParsedMaterial material;
     QFile file(path);
 
@@ -15,22 +18,27 @@ ParsedMaterial MaterialParser::parseMatML(const QString &path)
     }
 
     QXmlStreamReader xml(&file);
-    QString currentPropId;
-    QString currentMetaId;
+    ParseState state;
 
     while (!xml.atEnd()) {
         xml.readNext();
 
         if (xml.isStartElement()) {
-            processElement(xml, material, currentPropId, currentMetaId);
+            processElement(xml, material, state);
         }
 
         if (xml.isEndElement()) {
             if (xml.name() == "PropertyDetails") {
-                currentMetaId.clear();
+                state.metaId.clear();
+            }
+            if (xml.name() == "ParameterDetails") {
+                state.parameterId.clear();
+            }
+            if (xml.name() == "ParameterValue") {
+                state.inParameterValue = false;
             }
             if (xml.name() == "PropertyData") {
-                currentPropId.clear();
+                state.propId.clear();
             }
         }
     }
@@ -48,28 +56,64 @@ ParsedMaterial MaterialParser::parseMatML(const QString &path)
     return material;
 }
 
-void MaterialParser::processElement(QXmlStreamReader &xml, ParsedMaterial &material,
-                                    QString &currentPropId, QString &currentMetaId)
+QVector<double> MaterialParser::parseDataList(const QString &text)
+{
+    QVector<double> values;
+    const QStringList parts = text.split(',', Qt::SkipEmptyParts);
+
+    for (const QString &part : parts) {
+        bool ok;
+        double value = part.trimmed().toDouble(&ok);
+        if (!ok) {
+            return QVector<double>();
+        }
+        values.append(value);
+    }
+    return values;
+}
+
+void MaterialParser::processElement(QXmlStreamReader &xml, ParsedMaterial &material, ParseState &state)
 {
     if (xml.name() == "Name" && material.name.isEmpty()) {
         material.name = xml.readElementText().trimmed();
     }
 
     if (xml.name() == "PropertyDetails") {
-        currentMetaId = xml.attributes().value("id").toString();
+        state.metaId = xml.attributes().value("id").toString();
+    }
+
+    if (xml.name() == "ParameterDetails") {
+        state.parameterId = xml.attributes().value("id").toString();
     }
 
     if (xml.name() == "PropertyData") {
-        currentPropId = xml.attributes().value("property").toString();
+        state.propId = xml.attributes().value("property").toString();
     }
 
-    if (xml.name() == "Data" && !currentPropId.isEmpty()) {
+    if (xml.name() == "ParameterValue" && !state.propId.isEmpty()) {
+        state.inParameterValue = true;
+
+        // Учитываем только первый параметр зависимости
+        ParsedCurve &curve = material.curves[state.propId];
+        if (curve.parameterId.isEmpty()) {
+            curve.parameterId = xml.attributes().value("parameter").toString();
+        }
+    }
+
+    if (xml.name() == "Data" && !state.propId.isEmpty()) {
         const QString txt = xml.readElementText().trimmed();
-        bool ok;
-        double value = txt.toDouble(&ok);
+        const QVector<double> values = parseDataList(txt);
 
-        if (ok) {
-            material.values[currentPropId] = value;
+        if (state.inParameterValue) {
+            ParsedCurve &curve = material.curves[state.propId];
+            if (curve.abscissa.isEmpty()) {
+                curve.abscissa = values;
+            }
+        } else if (!values.isEmpty()) {
+            material.values[state.propId] = values.first();
+            if (values.size() > 1) {
+                material.curves[state.propId].ordinate = values;
+            }
         }
 
         if (txt.contains("Isotropic", Qt::CaseInsensitive)) {
@@ -77,14 +121,25 @@ void MaterialParser::processElement(QXmlStreamReader &xml, ParsedMaterial &mater
         }
     }
 
-    if (xml.name() == "Name" && !currentMetaId.isEmpty()) {
-        material.meta[currentMetaId].name = xml.readElementText().trimmed();
+    if (xml.name() == "Name" && !state.metaId.isEmpty()) {
+        material.meta[state.metaId].name =
+            StringInterner::instance().intern(xml.readElementText().trimmed());
     }
 
-    if (xml.name() == "Unit") {
+    if (xml.name() == "Name" && !state.parameterId.isEmpty()) {
+        material.parameters[state.parameterId].name =
+            StringInterner::instance().intern(xml.readElementText().trimmed());
+    }
+
+    if (xml.name() == "Unit" && (!state.metaId.isEmpty() || !state.parameterId.isEmpty())) {
         xml.readNextStartElement(); // Name
         if (!xml.isEndElement() && xml.name() == "Name") {
-            material.meta[currentMetaId].unit = xml.readElementText().trimmed();
+            QString unit = StringInterner::instance().intern(xml.readElementText().trimmed());
+            if (!state.metaId.isEmpty()) {
+                material.meta[state.metaId].unit = unit;
+            } else {
+                material.parameters[state.parameterId].unit = unit;
+            }
         }
     }
 }
@@ -6,6 +6,7 @@
 #include <QXmlStreamReader>
 #include <QDirIterator>
 #include <QMap>
+#include <QVector>
 #include <QDebug>
 
 struct PropertyMeta {
@@ -13,10 +14,19 @@ struct PropertyMeta {
     QString unit;
 };
 
+// Табличная зависимость из PropertyData/ParameterValue
+struct ParsedCurve {
+    QString parameterId;
+    QVector<double> abscissa;   // значения параметра (ParameterValue/Data)
+    QVector<double> ordinate;   // значения свойства (PropertyData/Data)
+};
+
 struct ParsedMaterial {
     QString name;
-    QMap<QString, PropertyMeta> meta;   // id → meta
-    QMap<QString, double> values;       // id → value
+    QMap<QString, PropertyMeta> meta;         // id → meta
+    QMap<QString, double> values;             // id → value
+    QMap<QString, PropertyMeta> parameters;   // id параметра → meta
+    QMap<QString, ParsedCurve> curves;        // id → зависимость от параметра
     bool isotropic = false;
 
     bool isEmpty() const {
@@ -34,13 +44,22 @@ public:
     ParsedMaterial parseMatML(const QString &path);
     QList<ParsedMaterial> parseDirectory(const QString &directoryPath);
 
+    // Разбор списка значений из <Data>: "2.1e11,2.0e11,1.9e11"
+    static QVector<double> parseDataList(const QString &text);
+
 signals:
     void progressChanged(int current, int total);
     void logMessage(const QString &message);
 
 private:
-    void processElement(QXmlStreamReader &xml, ParsedMaterial &material,
-                        QString &currentPropId, QString &currentMetaId);
+    struct ParseState {
+        QString propId;         // PropertyData/@property
+        QString metaId;         // PropertyDetails/@id
+        QString parameterId;    // ParameterDetails/@id
+        bool inParameterValue = false;
+    };
+
+    void processElement(QXmlStreamReader &xml, ParsedMaterial &material, ParseState &state);
 };
 
 #endif // MATERIALPARSER_H
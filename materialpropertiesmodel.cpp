@@ -0,0 +1,150 @@
+#include "materialpropertiesmodel.h"
+#include "modeldiff.h"
+
+MaterialPropertiesModel::MaterialPropertiesModel(Database *database, QObject *parent)
+    : QAbstractTableModel(parent)
+    , db(database)
+{
+}
+
+int MaterialPropertiesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : columns.size();
+}
+
+int MaterialPropertiesModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 3;
+}
+
+QVariant MaterialPropertiesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= columns.size()) {
+        return QVariant();
+    }
+
+    auto curve = curves.constFind(propertyName(index.row()));
+    if (role == Qt::ToolTipRole && curve != curves.constEnd()) {
+        // Точки хранятся в СИ
+        QStringList lines = {QString("Зависимость от %1, %2 -> %3:")
+                                 .arg(curve->parameterName, curve->parameterUnit, siUnit(index.row()))};
+        for (int i = 0; i < curve->size(); ++i) {
+            lines.append(QString("%1: %2").arg(curve->abscissa()[i], 0, 'g', 6)
+                                          .arg(curve->ordinate()[i], 0, 'g', 6));
+        }
+        return lines.join('\n');
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case 0:
+        return propertyName(index.row());
+    case 1:
+        if (curve != curves.constEnd()) {
+            return QString("%1 (f(%2), точек: %3)").arg(value(index.row()), 0, 'g', 6)
+                                                   .arg(curve->parameterName).arg(curve->size());
+        }
+        return QString::number(value(index.row()), 'g', 6);
+    case 2:
+        return unit(index.row());
+    }
+    return QVariant();
+}
+
+QVariant MaterialPropertiesModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    static const QStringList headers = {"Свойство", "Значение", "Единица измерения"};
+    return headers.value(section);
+}
+
+void MaterialPropertiesModel::setMaterial(const QString &materialName)
+{
+    MaterialPropertyMatrix &matrix = db->materialMatrix();
+    int row = matrix.rowOf(materialName);
+    if (row < 0) {
+        clear();
+        return;
+    }
+
+    QList<int> target = matrix.columnsOf(row);
+    material = materialName;
+    materialRow = row;
+
+    curves.clear();
+    for (const QString &property : db->getMaterialCurveProperties(materialName)) {
+        PropertyCurve curve = db->getMaterialPropertyCurve(materialName, property);
+        if (!curve.isEmpty()) {
+            curves.insert(property, curve);
+        }
+    }
+
+    applyListDiff(columns, target,
+        [this](int first, int last) {
+            beginRemoveRows(QModelIndex(), first, last);
+            columns.erase(columns.begin() + first, columns.begin() + last + 1);
+            endRemoveRows();
+        },
+        [this](int position, const QList<int> &items) {
+            beginInsertRows(QModelIndex(), position, position + items.size() - 1);
+            for (int i = 0; i < items.size(); ++i) {
+                columns.insert(position + i, items[i]);
+            }
+            endInsertRows();
+        },
+        [this](const QList<int> &items) {
+            beginResetModel();
+            columns = items;
+            endResetModel();
+        });
+
+    // Набор свойств мог совпасть, но значения у другого материала другие
+    if (!columns.isEmpty()) {
+        emit dataChanged(index(0, 1), index(columns.size() - 1, 2));
+    }
+}
+
+void MaterialPropertiesModel::clear()
+{
+    material.clear();
+    materialRow = -1;
+    curves.clear();
+
+    if (!columns.isEmpty()) {
+        beginRemoveRows(QModelIndex(), 0, columns.size() - 1);
+        columns.clear();
+        endRemoveRows();
+    }
+}
+
+void MaterialPropertiesModel::refreshRow(int row)
+{
+    if (row >= 0 && row < columns.size()) {
+        emit dataChanged(index(row, 0), index(row, 2));
+    }
+}
+
+QString MaterialPropertiesModel::propertyName(int row) const
+{
+    return db->materialMatrix().propertyName(columns[row]);
+}
+
+QString MaterialPropertiesModel::unit(int row) const
+{
+    return db->materialMatrix().displayUnit(materialRow, columns[row]);
+}
+
+double MaterialPropertiesModel::value(int row) const
+{
+    return db->materialMatrix().displayValue(materialRow, columns[row]);
+}
+
+QString MaterialPropertiesModel::siUnit(int row) const
+{
+    return db->materialMatrix().unit(materialRow, columns[row]);
+}
@@ -0,0 +1,47 @@
+#ifndef MATERIALPROPERTIESMODEL_H
+#define MATERIALPROPERTIESMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include "database.h"
+#include "propertycurve.h"
+
+// Таблица свойств выбранного материала, читает значения из матрицы свойств.
+// При смене материала строки вставляются/удаляются по разнице наборов свойств,
+// у общих строк обновляются только данные. У свойств с зависимостью от параметра
+// (температуры) рядом со значением - число точек, сами точки - в подсказке.
+class MaterialPropertiesModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit MaterialPropertiesModel(Database *database, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    void setMaterial(const QString &materialName);
+    void clear();
+    void refreshRow(int row);
+
+    QString materialName() const { return material; }
+    QString propertyName(int row) const;
+    // Значение и единица для отображения (единица исходного файла)
+    QString unit(int row) const;
+    double value(int row) const;
+    // Единица хранения (СИ)
+    QString siUnit(int row) const;
+
+private:
+    Database *db;
+    QString material;
+    int materialRow = -1;
+    QList<int> columns;   // колонки матрицы свойств, в порядке названий
+    QHash<QString, PropertyCurve> curves;   // по названию свойства
+};
+
+#endif // MATERIALPROPERTIESMODEL_H
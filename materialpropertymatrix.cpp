@@ -0,0 +1,270 @@
+#include "materialpropertymatrix.h"
+#include "database.h"
+#include "unitregistry.h"
+#include <algorithm>
+
+MaterialPropertyMatrix::MaterialPropertyMatrix(Database *database)
+    : db(database)
+{
+}
+
+void MaterialPropertyMatrix::ensureBuilt()
+{
+    if (!built) {
+        build();
+    }
+}
+
+void MaterialPropertyMatrix::invalidateAll()
+{
+    if (built) {
+        clear();
+        changeCount++;
+    }
+}
+
+void MaterialPropertyMatrix::clear()
+{
+    rows.clear();
+    columns.clear();
+    alive = DenseBitmap();
+    rowByName.clear();
+    rowByMaterialId.clear();
+    columnByName.clear();
+    columnByPropertyId.clear();
+    built = false;
+}
+
+void MaterialPropertyMatrix::build()
+{
+    clear();
+
+    QSqlQuery query(db->getDatabase());
+    query.setForwardOnly(true);
+
+    if (!query.exec("SELECT id, name FROM materials ORDER BY name")) {
+        qDebug() << "Error building property matrix:" << query.lastError().text();
+        return;
+    }
+    while (query.next()) {
+        appendRow(query.value(0).toInt(), query.value(1).toString());
+    }
+
+    if (!query.exec("SELECT material_id, property_id, unit_id, value, display_unit_id "
+                    "FROM material_properties")) {
+        qDebug() << "Error building property matrix:" << query.lastError().text();
+        return;
+    }
+    while (query.next()) {
+        int row = rowByMaterialId.value(query.value(0).toInt(), -1);
+        if (row < 0) {
+            continue;
+        }
+
+        Column &column = columns[columnFor(query.value(1).toInt())];
+        column.values[row] = query.value(3).toDouble();
+        column.unitIds[row] = query.value(2).toInt();
+        column.displayUnitIds[row] = query.value(4).isNull() ? column.unitIds[row]
+                                                             : query.value(4).toInt();
+        column.present.set(row);
+    }
+
+    built = true;
+    changeCount++;
+}
+
+int MaterialPropertyMatrix::appendRow(int materialId, const QString &name)
+{
+    int row = rows.size();
+
+    Row entry;
+    entry.materialId = materialId;
+    entry.name = name;
+    rows.append(entry);
+
+    alive.resize(row + 1);
+    alive.set(row);
+
+    for (Column &column : columns) {
+        column.values.resize(row + 1);
+        column.unitIds.resize(row + 1);
+        column.displayUnitIds.resize(row + 1);
+        column.present.resize(row + 1);
+    }
+
+    rowByName.insert(name, row);
+    rowByMaterialId.insert(materialId, row);
+    return row;
+}
+
+int MaterialPropertyMatrix::columnFor(int propertyId)
+{
+    auto it = columnByPropertyId.constFind(propertyId);
+    if (it != columnByPropertyId.constEnd()) {
+        return it.value();
+    }
+
+    Column column;
+    column.propertyId = propertyId;
+    column.name = db->propertyName(propertyId);
+    column.values = QVector<double>(rows.size(), 0.0);
+    column.unitIds = QVector<int>(rows.size(), -1);
+    column.displayUnitIds = QVector<int>(rows.size(), -1);
+    column.present = DenseBitmap(rows.size());
+
+    int index = columns.size();
+    columns.append(column);
+    columnByPropertyId.insert(propertyId, index);
+    columnByName.insert(column.name, index);
+    return index;
+}
+
+void MaterialPropertyMatrix::clearRow(int row)
+{
+    for (Column &column : columns) {
+        column.present.reset(row);
+    }
+}
+
+void MaterialPropertyMatrix::loadRow(int row)
+{
+    clearRow(row);
+
+    QSqlQuery query(db->getDatabase());
+    query.prepare("SELECT property_id, unit_id, value, display_unit_id FROM material_properties "
+                  "WHERE material_id = :material_id");
+    query.bindValue(":material_id", rows[row].materialId);
+
+    if (!query.exec()) {
+        qDebug() << "Error loading material row:" << query.lastError().text();
+        return;
+    }
+
+    while (query.next()) {
+        Column &column = columns[columnFor(query.value(0).toInt())];
+        column.values[row] = query.value(2).toDouble();
+        column.unitIds[row] = query.value(1).toInt();
+        column.displayUnitIds[row] = query.value(3).isNull() ? column.unitIds[row]
+                                                             : query.value(3).toInt();
+        column.present.set(row);
+    }
+}
+
+void MaterialPropertyMatrix::invalidateMaterial(const QString &materialName)
+{
+    if (!built) {
+        return;
+    }
+
+    QSqlQuery query(db->getDatabase());
+    query.prepare("SELECT id FROM materials WHERE name = :name");
+    query.bindValue(":name", materialName);
+
+    if (!query.exec() || !query.next()) {
+        removeMaterial(materialName);
+        return;
+    }
+
+    int materialId = query.value(0).toInt();
+    int row = rowByName.value(materialName, -1);
+    if (row < 0 || rows[row].materialId != materialId) {
+        removeMaterial(materialName);
+        row = appendRow(materialId, materialName);
+    }
+
+    loadRow(row);
+    changeCount++;
+}
+
+void MaterialPropertyMatrix::removeMaterial(const QString &materialName)
+{
+    int row = rowByName.value(materialName, -1);
+    if (!built || row < 0) {
+        return;
+    }
+
+    // Строка остается "надгробием" до следующей полной перестройки
+    clearRow(row);
+    alive.reset(row);
+    rowByName.remove(materialName);
+    rowByMaterialId.remove(rows[row].materialId);
+    changeCount++;
+}
+
+void MaterialPropertyMatrix::setValue(const QString &materialName, int propertyId,
+                                      int unitId, int displayUnitId, double value)
+{
+    if (!built) {
+        return;
+    }
+
+    int row = rowByName.value(materialName, -1);
+    if (row < 0) {
+        invalidateMaterial(materialName);
+        return;
+    }
+
+    Column &column = columns[columnFor(propertyId)];
+    column.values[row] = value;
+    if (unitId >= 0) {
+        column.unitIds[row] = unitId;
+        column.displayUnitIds[row] = displayUnitId >= 0 ? displayUnitId : unitId;
+    }
+    column.present.set(row);
+    changeCount++;
+}
+
+void MaterialPropertyMatrix::removeValue(const QString &materialName, int propertyId)
+{
+    int row = rowByName.value(materialName, -1);
+    int column = columnByPropertyId.value(propertyId, -1);
+    if (!built || row < 0 || column < 0) {
+        return;
+    }
+
+    columns[column].present.reset(row);
+    changeCount++;
+}
+
+QString MaterialPropertyMatrix::unit(int row, int column) const
+{
+    return db->unitName(columns[column].unitIds[row]);
+}
+
+QString MaterialPropertyMatrix::displayUnit(int row, int column) const
+{
+    return db->unitName(columns[column].displayUnitIds[row]);
+}
+
+double MaterialPropertyMatrix::displayValue(int row, int column) const
+{
+    const Column &entry = columns[column];
+    if (entry.displayUnitIds[row] == entry.unitIds[row]) {
+        return entry.values[row];
+    }
+    return UnitRegistry::instance().convert(entry.values[row], unit(row, column),
+                                            displayUnit(row, column));
+}
+
+QString MaterialPropertyMatrix::columnUnit(int column) const
+{
+    // Единица СИ первой заполненной ячейки (после нормализации она общая для колонки)
+    const Column &entry = columns[column];
+    int row = entry.present.nextSetBit(0);
+    return row >= 0 ? db->unitName(entry.unitIds[row]) : QString();
+}
+
+QVector<int> MaterialPropertyMatrix::columnsOf(int row) const
+{
+    QVector<int> result;
+    for (int column = 0; column < columns.size(); ++column) {
+        if (columns[column].present.test(row)) {
+            result.append(column);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [this](int a, int b) {
+        return columns[a].name < columns[b].name;
+    });
+    return result;
+}
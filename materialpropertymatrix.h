@@ -0,0 +1,96 @@
+#ifndef MATERIALPROPERTYMATRIX_H
+#define MATERIALPROPERTYMATRIX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include "densebitmap.h"
+
+class Database;
+
+// Колоночное представление material_properties в памяти:
+// строка - материал, колонка - свойство (непрерывный массив double + битовая карта наличия).
+// Строится лениво при первом обращении и поддерживается Database инкрементально.
+class MaterialPropertyMatrix
+{
+public:
+    explicit MaterialPropertyMatrix(Database *database);
+
+    void ensureBuilt();
+    bool isBuilt() const { return built; }
+
+    // Инкрементальное обновление (вызывается из Database)
+    void invalidateAll();
+    void invalidateMaterial(const QString &materialName);
+    void removeMaterial(const QString &materialName);
+    void setValue(const QString &materialName, int propertyId, int unitId,
+                  int displayUnitId, double value);
+    void removeValue(const QString &materialName, int propertyId);
+
+    // Номер изменения - по нему производные индексы понимают, что устарели
+    quint64 revision() const { return changeCount; }
+
+    int rowCount() const { return rows.size(); }
+    int columnCount() const { return columns.size(); }
+    int liveRowCount() const { return alive.count(); }
+
+    int rowOf(const QString &materialName) const { return rowByName.value(materialName, -1); }
+    int columnOf(const QString &propertyName) const { return columnByName.value(propertyName, -1); }
+
+    const QString &materialName(int row) const { return rows[row].name; }
+    const QString &propertyName(int column) const { return columns[column].name; }
+    // Значения хранятся в СИ; единица из исходного файла сохраняется для отображения
+    QString unit(int row, int column) const;
+    QString displayUnit(int row, int column) const;
+    double displayValue(int row, int column) const;
+    QString columnUnit(int column) const;
+
+    bool isAlive(int row) const { return alive.test(row); }
+    const DenseBitmap &aliveRows() const { return alive; }
+
+    bool hasValue(int row, int column) const { return columns[column].present.test(row); }
+    double value(int row, int column) const { return columns[column].values[row]; }
+    const QVector<double> &values(int column) const { return columns[column].values; }
+    const DenseBitmap &presence(int column) const { return columns[column].present; }
+
+    // Колонки, заполненные у материала, в порядке названий свойств
+    QVector<int> columnsOf(int row) const;
+
+private:
+    struct Row {
+        int materialId = -1;
+        QString name;
+    };
+
+    struct Column {
+        int propertyId = -1;
+        QString name;
+        QVector<double> values;
+        QVector<int> unitIds;
+        QVector<int> displayUnitIds;
+        DenseBitmap present;
+    };
+
+    void build();
+    void clear();
+    int appendRow(int materialId, const QString &name);
+    int columnFor(int propertyId);
+    void loadRow(int row);
+    void clearRow(int row);
+
+    Database *db;
+    bool built = false;
+    quint64 changeCount = 0;
+
+    QVector<Row> rows;
+    QVector<Column> columns;
+    DenseBitmap alive;
+
+    QHash<QString, int> rowByName;
+    QHash<int, int> rowByMaterialId;
+    QHash<QString, int> columnByName;
+    QHash<int, int> columnByPropertyId;
+};
+
+#endif // MATERIALPROPERTYMATRIX_H
@@ -0,0 +1,209 @@
+#include "materialsearchindex.h"
+#include <algorithm>
+
+namespace {
+
+const int CancelCheckInterval = 256;
+
+}
+
+QString MaterialSearchIndex::normalize(const QString &text)
+{
+    QString result;
+    result.reserve(text.size());
+
+    for (QChar ch : text) {
+        if (ch.isLetterOrNumber()) {
+            result.append(ch.toLower());
+        }
+    }
+    return result;
+}
+
+QVector<quint64> MaterialSearchIndex::trigrams(const QString &normalized)
+{
+    QVector<quint64> result;
+    for (int i = 0; i + 2 < normalized.size(); ++i) {
+        quint64 key = (quint64(normalized[i].unicode()) << 32)
+                      | (quint64(normalized[i + 1].unicode()) << 16)
+                      | quint64(normalized[i + 2].unicode());
+        result.append(key);
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// Наименьшее число правок, за которое pattern совпадает с какой-либо подстрокой text
+int MaterialSearchIndex::substringDistance(const QString &pattern, const QString &text, int maxDistance)
+{
+    const int m = pattern.size();
+    QVector<int> previous(m + 1);
+    QVector<int> current(m + 1);
+
+    for (int i = 0; i <= m; ++i) {
+        previous[i] = i;
+    }
+
+    int best = previous[m];
+    for (int j = 0; j < text.size(); ++j) {
+        // Совпадение может начинаться с любой позиции text
+        current[0] = 0;
+
+        for (int i = 1; i <= m; ++i) {
+            int cost = pattern[i - 1] == text[j] ? 0 : 1;
+            current[i] = qMin(qMin(current[i - 1] + 1, previous[i] + 1), previous[i - 1] + cost);
+        }
+
+        best = qMin(best, current[m]);
+        if (best == 0) {
+            break;
+        }
+        std::swap(previous, current);
+    }
+
+    return best <= maxDistance ? best : maxDistance + 1;
+}
+
+void MaterialSearchIndex::rebuild(const QStringList &names)
+{
+    QWriteLocker locker(&lock);
+
+    entries.clear();
+    entryByName.clear();
+    postings.clear();
+
+    entries.reserve(names.size());
+    for (const QString &name : names) {
+        insertLocked(name);
+    }
+}
+
+void MaterialSearchIndex::addMaterial(const QString &name)
+{
+    QWriteLocker locker(&lock);
+    insertLocked(name);
+}
+
+void MaterialSearchIndex::insertLocked(const QString &name)
+{
+    auto it = entryByName.constFind(name);
+    if (it != entryByName.constEnd()) {
+        entries[it.value()].alive = true;
+        return;
+    }
+
+    Entry entry;
+    entry.name = name;
+    entry.normalized = normalize(name);
+
+    int index = entries.size();
+    entries.append(entry);
+    entryByName.insert(name, index);
+
+    for (quint64 key : trigrams(entry.normalized)) {
+        postings[key].append(index);
+    }
+}
+
+void MaterialSearchIndex::removeMaterial(const QString &name)
+{
+    QWriteLocker locker(&lock);
+
+    // Записи не удаляются из списков триграмм, а только помечаются
+    auto it = entryByName.constFind(name);
+    if (it != entryByName.constEnd()) {
+        entries[it.value()].alive = false;
+    }
+}
+
+int MaterialSearchIndex::size() const
+{
+    QReadLocker locker(&lock);
+
+    int count = 0;
+    for (const Entry &entry : entries) {
+        if (entry.alive) {
+            count++;
+        }
+    }
+    return count;
+}
+
+QStringList MaterialSearchIndex::search(const QString &text, int limit,
+                                        const std::function<bool()> &cancelled) const
+{
+    QReadLocker locker(&lock);
+    QStringList result;
+
+    const QString pattern = normalize(text);
+    const int maxDistance = qMax(1, int(pattern.size()) / 4);
+
+    // Кандидаты: при коротком запросе - все записи, иначе - по общим триграммам
+    QVector<int> candidates;
+    const QVector<quint64> patternTrigrams = trigrams(pattern);
+    const int requiredShared = int(patternTrigrams.size()) - 3 * maxDistance;
+
+    if (pattern.isEmpty() || requiredShared <= 0) {
+        candidates.reserve(entries.size());
+        for (int i = 0; i < entries.size(); ++i) {
+            candidates.append(i);
+        }
+    } else {
+        QVector<quint16> shared(entries.size(), 0);
+        for (quint64 key : patternTrigrams) {
+            auto it = postings.constFind(key);
+            if (it == postings.constEnd()) {
+                continue;
+            }
+            for (int index : it.value()) {
+                if (++shared[index] == requiredShared) {
+                    candidates.append(index);
+                }
+            }
+        }
+    }
+
+    QVector<Match> matches;
+    for (int n = 0; n < candidates.size(); ++n) {
+        if (cancelled && n % CancelCheckInterval == 0 && cancelled()) {
+            return QStringList();
+        }
+
+        const Entry &entry = entries[candidates[n]];
+        if (!entry.alive) {
+            continue;
+        }
+
+        if (pattern.isEmpty() || entry.normalized.startsWith(pattern)) {
+            matches.append({candidates[n], 0, 0});
+        } else if (entry.normalized.contains(pattern)) {
+            matches.append({candidates[n], 1, 0});
+        } else if (pattern.size() >= 3) {
+            int distance = substringDistance(pattern, entry.normalized, maxDistance);
+            if (distance <= maxDistance) {
+                matches.append({candidates[n], 2, distance});
+            }
+        }
+    }
+
+    auto better = [this](const Match &a, const Match &b) {
+        if (a.category != b.category) {
+            return a.category < b.category;
+        }
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        return entries[a.entry].name < entries[b.entry].name;
+    };
+
+    int count = limit < 0 ? int(matches.size()) : qMin(limit, int(matches.size()));
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), better);
+
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result.append(entries[matches[i].entry].name);
+    }
+    return result;
+}
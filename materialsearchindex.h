@@ -0,0 +1,56 @@
+#ifndef MATERIALSEARCHINDEX_H
+#define MATERIALSEARCHINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QReadWriteLock>
+#include <functional>
+
+// Триграммный индекс названий материалов для нечеткого поиска.
+// Названия нормализуются (нижний регистр, только буквы и цифры), поэтому
+// "Ti6Al4V" находит "Ti-6Al-4V"; кандидаты отбираются по общим триграммам и
+// ранжируются по расстоянию редактирования. Поиск можно вызывать из рабочих потоков.
+class MaterialSearchIndex
+{
+public:
+    MaterialSearchIndex() = default;
+
+    static QString normalize(const QString &text);
+
+    void rebuild(const QStringList &names);
+    void addMaterial(const QString &name);
+    void removeMaterial(const QString &name);
+    int size() const;
+
+    // Пустой запрос возвращает все названия по алфавиту.
+    // cancelled проверяется периодически; если вернул true - поиск прерывается
+    QStringList search(const QString &text, int limit = -1,
+                       const std::function<bool()> &cancelled = {}) const;
+
+private:
+    struct Entry {
+        QString name;
+        QString normalized;
+        bool alive = true;
+    };
+
+    struct Match {
+        int entry;
+        int category;   // 0 - начало названия, 1 - подстрока, 2 - с опечатками
+        int distance;
+    };
+
+    static QVector<quint64> trigrams(const QString &normalized);
+    static int substringDistance(const QString &pattern, const QString &text, int maxDistance);
+
+    void insertLocked(const QString &name);
+
+    mutable QReadWriteLock lock;
+    QVector<Entry> entries;
+    QHash<QString, int> entryByName;
+    QHash<quint64, QVector<int>> postings;
+};
+
+#endif // MATERIALSEARCHINDEX_H
@@ -0,0 +1,176 @@
+#include "materialselector.h"
+#include "database.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <numeric>
+
+MaterialSelector::MaterialSelector(Database *database)
+    : db(database)
+{
+}
+
+void MaterialSelector::syncWithMatrix()
+{
+    matrix = &db->materialMatrix();
+
+    // Любое изменение матрицы делает индексы неактуальными; перестраиваются лениво по колонкам
+    if (matrix->revision() != indexedRevision) {
+        indexes.clear();
+        indexedRevision = matrix->revision();
+    }
+    if (indexes.size() < matrix->columnCount()) {
+        indexes.resize(matrix->columnCount());
+    }
+}
+
+const MaterialSelector::SortedIndex &MaterialSelector::indexFor(int column)
+{
+    SortedIndex &index = indexes[column];
+    if (index.built) {
+        return index;
+    }
+
+    const QVector<double> &values = matrix->values(column);
+    const DenseBitmap &present = matrix->presence(column);
+
+    QVector<int> rows;
+    rows.reserve(present.count());
+    for (int row = present.nextSetBit(0); row >= 0; row = present.nextSetBit(row + 1)) {
+        rows.append(row);
+    }
+
+    std::sort(rows.begin(), rows.end(), [&values](int a, int b) {
+        return values[a] < values[b];
+    });
+
+    index.values.resize(rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        index.values[i] = values[rows[i]];
+    }
+    index.rows = rows;
+    index.built = true;
+    return index;
+}
+
+DenseBitmap MaterialSelector::match(const QVector<RangePredicate> &predicates)
+{
+    syncWithMatrix();
+
+    const int rowCount = matrix->rowCount();
+    if (predicates.isEmpty()) {
+        return matrix->aliveRows();
+    }
+
+    // Оцениваем селективность каждого условия двоичным поиском по индексу
+    QVector<PredicateRange> ranges;
+    for (const RangePredicate &predicate : predicates) {
+        PredicateRange range;
+        range.column = matrix->columnOf(predicate.propertyName);
+        if (range.column < 0 || predicate.minimum > predicate.maximum) {
+            return DenseBitmap(rowCount);
+        }
+
+        const SortedIndex &index = indexFor(range.column);
+        range.begin = std::lower_bound(index.values.begin(), index.values.end(),
+                                       predicate.minimum) - index.values.begin();
+        range.end = std::upper_bound(index.values.begin(), index.values.end(),
+                                     predicate.maximum) - index.values.begin();
+        range.minimum = predicate.minimum;
+        range.maximum = predicate.maximum;
+
+        if (range.begin >= range.end) {
+            return DenseBitmap(rowCount);
+        }
+        ranges.append(range);
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const PredicateRange &a, const PredicateRange &b) {
+        return (a.end - a.begin) < (b.end - b.begin);
+    });
+
+    // Кандидаты - из самого селективного условия
+    DenseBitmap candidates(rowCount);
+    const SortedIndex &first = indexes[ranges[0].column];
+    for (int i = ranges[0].begin; i < ranges[0].end; ++i) {
+        candidates.set(first.rows[i]);
+    }
+    int candidateCount = ranges[0].end - ranges[0].begin;
+
+    for (int r = 1; r < ranges.size() && candidateCount > 0; ++r) {
+        const PredicateRange &range = ranges[r];
+
+        if (candidateCount * 8 < range.end - range.begin) {
+            // Кандидатов мало: проверяем значения напрямую по колонке
+            const QVector<double> &values = matrix->values(range.column);
+            const DenseBitmap &present = matrix->presence(range.column);
+            candidateCount = 0;
+
+            for (int row = candidates.nextSetBit(0); row >= 0; row = candidates.nextSetBit(row + 1)) {
+                if (present.test(row) && values[row] >= range.minimum && values[row] <= range.maximum) {
+                    candidateCount++;
+                } else {
+                    candidates.reset(row);
+                }
+            }
+        } else {
+            DenseBitmap hits(rowCount);
+            const SortedIndex &index = indexes[range.column];
+            for (int i = range.begin; i < range.end; ++i) {
+                hits.set(index.rows[i]);
+            }
+            candidates &= hits;
+            candidateCount = candidates.count();
+        }
+    }
+
+    return candidates;
+}
+
+SelectionResult MaterialSelector::select(const SelectionQuery &query)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    SelectionResult result;
+    DenseBitmap hits = match(query.predicates);
+
+    QVector<int> rows;
+    rows.reserve(hits.count());
+    for (int row = hits.nextSetBit(0); row >= 0; row = hits.nextSetBit(row + 1)) {
+        rows.append(row);
+    }
+    result.totalMatches = rows.size();
+
+    // Ранжирование: частичная сортировка только до конца запрошенной страницы
+    int offset = qBound(0, query.offset, int(rows.size()));
+    int pageEnd = qMin(int(rows.size()), offset + qMax(0, query.limit));
+    int rankColumn = query.rankBy.isEmpty() ? -1 : matrix->columnOf(query.rankBy);
+
+    auto byName = [this](int a, int b) {
+        return matrix->materialName(a) < matrix->materialName(b);
+    };
+
+    if (rankColumn >= 0) {
+        const QVector<double> &values = matrix->values(rankColumn);
+        const DenseBitmap &present = matrix->presence(rankColumn);
+        const bool descending = query.descending;
+
+        std::partial_sort(rows.begin(), rows.begin() + pageEnd, rows.end(),
+                          [&](int a, int b) {
+            // Материалы без значения - в конце списка
+            if (present.test(a) != present.test(b)) {
+                return present.test(a);
+            }
+            if (!present.test(a) || values[a] == values[b]) {
+                return byName(a, b);
+            }
+            return descending ? values[a] > values[b] : values[a] < values[b];
+        });
+    } else {
+        std::partial_sort(rows.begin(), rows.begin() + pageEnd, rows.end(), byName);
+    }
+
+    result.rows = rows.mid(offset, pageEnd - offset);
+    result.elapsedMs = timer.nsecsElapsed() / 1e6;
+    return result;
+}
@@ -0,0 +1,70 @@
+#ifndef MATERIALSELECTOR_H
+#define MATERIALSELECTOR_H
+
+#include <QString>
+#include <QVector>
+#include <limits>
+#include "densebitmap.h"
+
+class Database;
+class MaterialPropertyMatrix;
+
+// Условие "минимум <= свойство <= максимум" (границы включительно)
+struct RangePredicate {
+    QString propertyName;
+    double minimum = -std::numeric_limits<double>::infinity();
+    double maximum = std::numeric_limits<double>::infinity();
+};
+
+struct SelectionQuery {
+    QVector<RangePredicate> predicates;  // объединяются по И
+    QString rankBy;                      // свойство для ранжирования, пусто - по названию
+    bool descending = false;
+    int offset = 0;
+    int limit = 50;
+};
+
+struct SelectionResult {
+    QVector<int> rows;      // строки матрицы свойств на текущей странице
+    int totalMatches = 0;
+    double elapsedMs = 0.0;
+};
+
+// Подбор материалов по набору диапазонов свойств.
+// По каждому свойству строится отсортированный индекс (значение, строка);
+// поиск начинается с самого селективного условия, остальные пересекаются битовыми картами.
+class MaterialSelector
+{
+public:
+    explicit MaterialSelector(Database *database);
+
+    SelectionResult select(const SelectionQuery &query);
+
+    // Битовая карта строк, удовлетворяющих всем условиям (без ранжирования)
+    DenseBitmap match(const QVector<RangePredicate> &predicates);
+
+private:
+    struct SortedIndex {
+        bool built = false;
+        QVector<double> values;
+        QVector<int> rows;
+    };
+
+    struct PredicateRange {
+        int column = -1;
+        int begin = 0;
+        int end = 0;
+        double minimum = 0.0;
+        double maximum = 0.0;
+    };
+
+    const SortedIndex &indexFor(int column);
+    void syncWithMatrix();
+
+    Database *db;
+    MaterialPropertyMatrix *matrix = nullptr;
+    quint64 indexedRevision = 0;
+    QVector<SortedIndex> indexes;
+};
+
+#endif // MATERIALSELECTOR_H
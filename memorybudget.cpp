@@ -0,0 +1,235 @@
+#include "memorybudget.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+MemoryBudget &MemoryBudget::instance()
+{
+    static MemoryBudget budget;
+    return budget;
+}
+
+QString MemoryBudget::subsystemName(MemorySubsystem subsystem)
+{
+    switch (subsystem) {
+    case MemorySubsystem::ParseBuffers:
+        return "Разбор файлов";
+    case MemorySubsystem::QueryResults:
+        return "Выборки";
+    case MemorySubsystem::Caches:
+        return "Кэши";
+    case MemorySubsystem::Views:
+        return "Таблицы и списки";
+    }
+    return QString();
+}
+
+void MemoryBudget::setLimitBytes(qint64 bytes)
+{
+    limit.store(qMax<qint64>(0, bytes), std::memory_order_relaxed);
+    enforce();
+    wakeWaiters();
+}
+
+void MemoryBudget::add(MemorySubsystem subsystem, qint64 bytes)
+{
+    const int index = int(subsystem);
+    const qint64 now = tracked[index].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    qint64 previous = peak[index].load(std::memory_order_relaxed);
+    while (previous < now && !peak[index].compare_exchange_weak(previous, now, std::memory_order_relaxed)) {
+    }
+
+    const qint64 budget = limitBytes();
+    if (budget > 0 && bytes > 0 && totalBytes() > budget) {
+        enforce();
+    }
+}
+
+void MemoryBudget::release(MemorySubsystem subsystem, qint64 bytes)
+{
+    tracked[int(subsystem)].fetch_sub(bytes, std::memory_order_relaxed);
+    wakeWaiters();
+}
+
+void MemoryBudget::reserve(MemorySubsystem subsystem, qint64 bytes, const std::function<bool()> &proceed)
+{
+    QElapsedTimer timer;
+    bool waited = false;
+
+    for (;;) {
+        const qint64 budget = limitBytes();
+        if (budget <= 0 || totalBytes() + bytes <= budget || (proceed && proceed())) {
+            break;
+        }
+        if (enforce() > 0 && totalBytes() + bytes <= budget) {
+            break;
+        }
+
+        if (!waited) {
+            waited = true;
+            waits.fetch_add(1, std::memory_order_relaxed);
+            timer.start();
+        }
+
+        // Таймаут - на случай, если proceed() стало верным без wakeWaiters()
+        QMutexLocker locker(&waitMutex);
+        released.wait(&waitMutex, 50);
+    }
+
+    if (waited) {
+        waitedMs.fetch_add(timer.elapsed(), std::memory_order_relaxed);
+    }
+    add(subsystem, bytes);
+}
+
+void MemoryBudget::wakeWaiters()
+{
+    QMutexLocker locker(&waitMutex);
+    released.wakeAll();
+}
+
+int MemoryBudget::addSource(MemorySubsystem subsystem, const QString &name,
+                            const std::function<qint64()> &bytes,
+                            const std::function<qint64(qint64)> &evict)
+{
+    QMutexLocker locker(&mutex);
+    MemorySource source;
+    source.id = nextSourceId++;
+    source.subsystem = subsystem;
+    source.name = name;
+    source.bytes = bytes;
+    source.evict = evict;
+    registered.append(source);
+    return source.id;
+}
+
+void MemoryBudget::removeSource(int id)
+{
+    // enforce() и опрос объема работают с копией списка - дожидаемся их
+    QWriteLocker callbackLocker(&callbacks);
+    QMutexLocker locker(&mutex);
+    for (int i = 0; i < registered.size(); ++i) {
+        if (registered[i].id == id) {
+            registered.removeAt(i);
+            return;
+        }
+    }
+}
+
+QList<MemorySource> MemoryBudget::sourceList() const
+{
+    // Источники опрашиваются без блокировки бюджета: у них свои мьютексы.
+    // Вызывающий держит callbacks на чтение, пока пользуется копией
+    QMutexLocker locker(&mutex);
+    return registered;
+}
+
+qint64 MemoryBudget::sourceBytes(const QList<MemorySource> &list, int subsystem) const
+{
+    qint64 bytes = 0;
+    for (const MemorySource &source : list) {
+        if (subsystem < 0 || int(source.subsystem) == subsystem) {
+            bytes += source.bytes();
+        }
+    }
+    return bytes;
+}
+
+qint64 MemoryBudget::trackedBytes(MemorySubsystem subsystem) const
+{
+    return tracked[int(subsystem)].load(std::memory_order_relaxed);
+}
+
+qint64 MemoryBudget::peakBytes(MemorySubsystem subsystem) const
+{
+    return peak[int(subsystem)].load(std::memory_order_relaxed);
+}
+
+qint64 MemoryBudget::usedBytes(MemorySubsystem subsystem) const
+{
+    QReadLocker locker(&callbacks);
+    return trackedBytes(subsystem) + sourceBytes(sourceList(), int(subsystem));
+}
+
+qint64 MemoryBudget::totalBytes() const
+{
+    QReadLocker locker(&callbacks);
+    qint64 bytes = sourceBytes(sourceList(), -1);
+    for (int i = 0; i < SubsystemCount; ++i) {
+        bytes += tracked[i].load(std::memory_order_relaxed);
+    }
+    return bytes;
+}
+
+QList<MemorySourceUsage> MemoryBudget::sources() const
+{
+    QReadLocker locker(&callbacks);
+    QList<MemorySourceUsage> usage;
+    for (const MemorySource &source : sourceList()) {
+        usage.append({source.subsystem, source.name, source.bytes()});
+    }
+    return usage;
+}
+
+qint64 MemoryBudget::enforce()
+{
+    const qint64 budget = limitBytes();
+    if (budget <= 0) {
+        return 0;
+    }
+
+    // Вытесняет один поток; остальные в это время просто ждут или идут дальше
+    bool expected = false;
+    if (!enforcing.compare_exchange_strong(expected, true)) {
+        return 0;
+    }
+
+    qint64 freed = 0;
+    {
+        QReadLocker locker(&callbacks);
+        qint64 excess = totalBytes() - budget;
+        for (const MemorySource &source : sourceList()) {
+            if (excess <= 0) {
+                break;
+            }
+            if (source.evict) {
+                const qint64 bytes = source.evict(excess);
+                freed += bytes;
+                excess -= bytes;
+            }
+        }
+    }
+
+    enforcing.store(false);
+    if (freed > 0) {
+        evicted.fetch_add(freed, std::memory_order_relaxed);
+        wakeWaiters();
+    }
+    return freed;
+}
+
+MemoryReservation::MemoryReservation(MemorySubsystem subsystem, qint64 bytes)
+    : subsystem(subsystem)
+{
+    resize(bytes);
+}
+
+void MemoryReservation::resize(qint64 bytes)
+{
+    bytes = qMax<qint64>(0, bytes);
+    if (bytes > reserved) {
+        MemoryBudget::instance().add(subsystem, bytes - reserved);
+    } else if (bytes < reserved) {
+        MemoryBudget::instance().release(subsystem, reserved - bytes);
+    }
+    reserved = bytes;
+}
+
+void MemoryReservation::grow(qint64 bytes, const std::function<bool()> &proceed)
+{
+    if (bytes <= 0) {
+        return;
+    }
+    MemoryBudget::instance().reserve(subsystem, bytes, proceed);
+    reserved += bytes;
+}
@@ -0,0 +1,128 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QList>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+
+// Подсистемы, по которым ведется учет памяти
+enum class MemorySubsystem {
+    ParseBuffers,       // разобранные файлы, ждущие записи в базу
+    QueryResults,       // выборки в пути: от запроса до кэша или таблицы
+    Caches,             // ResultCache, ResultStore
+    Views               // ячейки таблиц и списки GUI
+};
+
+// Источник, который сам знает свой объем (кэш), и как его уменьшить
+struct MemorySource {
+    int id = 0;
+    MemorySubsystem subsystem = MemorySubsystem::Caches;
+    QString name;
+    std::function<qint64()> bytes;
+    std::function<qint64(qint64)> evict;    // освободить не меньше заданного, вернуть освобожденное
+};
+
+struct MemorySourceUsage {
+    MemorySubsystem subsystem;
+    QString name;
+    qint64 bytes = 0;
+};
+
+// Учет памяти по подсистемам и общий бюджет процесса. Данные в пути (разбор, выборки,
+// таблицы) учитываются резервами MemoryReservation, кэши - своими источниками.
+// При превышении бюджета кэши вытесняются в порядке регистрации, а загрузка ждет
+// (обратное давление), пока разобранные файлы не будут записаны.
+// Оценки - по емкости контейнеров, без накладных расходов аллокатора.
+class MemoryBudget
+{
+public:
+    static constexpr int SubsystemCount = 4;
+
+    static MemoryBudget &instance();
+    static QString subsystemName(MemorySubsystem subsystem);
+
+    // 0 - без ограничения
+    void setLimitBytes(qint64 bytes);
+    qint64 limitBytes() const { return limit.load(std::memory_order_relaxed); }
+
+    // Резервы: учет без ожидания (add может уйти за бюджет - тогда вытесняются кэши)
+    void add(MemorySubsystem subsystem, qint64 bytes);
+    void release(MemorySubsystem subsystem, qint64 bytes);
+
+    // Резерв с обратным давлением: ждет, пока объем поместится в бюджет.
+    // proceed() == true пропускает без ожидания - например, файл, который прямо сейчас
+    // ждет писатель: иначе загрузка может встать навсегда
+    void reserve(MemorySubsystem subsystem, qint64 bytes, const std::function<bool()> &proceed);
+    // Разбудить ждущих в reserve (условие proceed могло измениться)
+    void wakeWaiters();
+
+    int addSource(MemorySubsystem subsystem, const QString &name, const std::function<qint64()> &bytes,
+                  const std::function<qint64(qint64)> &evict = {});
+    // Ждет окончания идущих вызовов bytes/evict: после возврата источник можно уничтожать
+    void removeSource(int id);
+
+    qint64 trackedBytes(MemorySubsystem subsystem) const;
+    qint64 peakBytes(MemorySubsystem subsystem) const;
+    // Резервы и источники подсистемы
+    qint64 usedBytes(MemorySubsystem subsystem) const;
+    qint64 totalBytes() const;
+    QList<MemorySourceUsage> sources() const;
+
+    // Вытеснить из кэшей столько, чтобы уложиться в бюджет; возвращает освобожденное
+    qint64 enforce();
+
+    quint64 backpressureWaits() const { return waits.load(std::memory_order_relaxed); }
+    qint64 backpressureMs() const { return waitedMs.load(std::memory_order_relaxed); }
+    qint64 evictedBytes() const { return evicted.load(std::memory_order_relaxed); }
+
+private:
+    MemoryBudget() = default;
+    Q_DISABLE_COPY(MemoryBudget)
+
+    QList<MemorySource> sourceList() const;
+    qint64 sourceBytes(const QList<MemorySource> &list, int subsystem) const;
+
+    std::atomic<qint64> tracked[SubsystemCount] = {};
+    std::atomic<qint64> peak[SubsystemCount] = {};
+    std::atomic<qint64> limit{0};
+
+    mutable QMutex mutex;
+    QList<MemorySource> registered;
+    // Вызовы источников - под чтением (вложенные разрешены), removeSource - под записью
+    mutable QReadWriteLock callbacks{QReadWriteLock::Recursive};
+    int nextSourceId = 1;
+
+    QMutex waitMutex;
+    QWaitCondition released;
+    std::atomic<bool> enforcing{false};
+
+    std::atomic<quint64> waits{0};
+    std::atomic<qint64> waitedMs{0};
+    std::atomic<qint64> evicted{0};
+};
+
+// Резерв на время жизни объекта; размер можно уточнять (resize), когда он стал известен
+class MemoryReservation
+{
+public:
+    explicit MemoryReservation(MemorySubsystem subsystem, qint64 bytes = 0);
+    ~MemoryReservation() { release(); }
+    Q_DISABLE_COPY(MemoryReservation)
+
+    // Без ожидания
+    void resize(qint64 bytes);
+    void release() { resize(0); }
+    // Увеличить на bytes с обратным давлением (см. MemoryBudget::reserve)
+    void grow(qint64 bytes, const std::function<bool()> &proceed);
+    qint64 bytes() const { return reserved; }
+
+private:
+    MemorySubsystem subsystem;
+    qint64 reserved = 0;
+};
+
+#endif // MEMORYBUDGET_H
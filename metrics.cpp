@@ -0,0 +1,200 @@
+#include "metrics.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <cmath>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+void LatencyHistogram::record(qint64 microseconds)
+{
+    microseconds = qMax<qint64>(0, microseconds);
+
+    int bucket = 0;
+    while (bucket < Buckets - 1 && (qint64(1) << bucket) <= microseconds) {
+        bucket++;
+    }
+
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(quint64(microseconds), std::memory_order_relaxed);
+
+    qint64 previous = maximum.load(std::memory_order_relaxed);
+    while (previous < microseconds
+           && !maximum.compare_exchange_weak(previous, microseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < Buckets; ++i) {
+        buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    total.fetch_add(other.count(), std::memory_order_relaxed);
+    sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    const qint64 otherMaximum = other.maxUs();
+    qint64 previous = maximum.load(std::memory_order_relaxed);
+    while (previous < otherMaximum
+           && !maximum.compare_exchange_weak(previous, otherMaximum, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::subtract(const LatencyHistogram &earlier)
+{
+    int highest = -1;
+    for (int i = 0; i < Buckets; ++i) {
+        const quint64 remaining = buckets[i].load(std::memory_order_relaxed)
+                                  - qMin(buckets[i].load(std::memory_order_relaxed),
+                                         earlier.buckets[i].load(std::memory_order_relaxed));
+        buckets[i].store(remaining, std::memory_order_relaxed);
+        if (remaining > 0) {
+            highest = i;
+        }
+    }
+    total.store(count() - qMin(count(), earlier.count()), std::memory_order_relaxed);
+    const quint64 earlierSum = earlier.sum.load(std::memory_order_relaxed);
+    const quint64 currentSum = sum.load(std::memory_order_relaxed);
+    sum.store(currentSum - qMin(currentSum, earlierSum), std::memory_order_relaxed);
+
+    if (highest < 0) {
+        maximum.store(0, std::memory_order_relaxed);
+    } else if (maxUs() <= earlier.maxUs()) {
+        maximum.store(qMin(qint64(1) << highest, earlier.maxUs()), std::memory_order_relaxed);
+    }
+}
+
+double LatencyHistogram::meanUs() const
+{
+    quint64 n = count();
+    return n == 0 ? 0.0 : double(sum.load(std::memory_order_relaxed)) / n;
+}
+
+qint64 LatencyHistogram::percentileUs(double percentile) const
+{
+    quint64 n = count();
+    if (n == 0) {
+        return 0;
+    }
+
+    const quint64 rank = quint64(std::ceil(n * percentile / 100.0));
+    quint64 seen = 0;
+    for (int i = 0; i < Buckets; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Верхняя граница корзины, но не больше наблюдавшегося максимума
+            return qMin(qint64(1) << i, maxUs());
+        }
+    }
+    return maxUs();
+}
+
+Metrics &Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+LatencyHistogram &Metrics::latency(const char *name)
+{
+    QMutexLocker locker(&mutex);
+    std::unique_ptr<LatencyHistogram> &histogram = histograms[QString::fromLatin1(name)];
+    if (!histogram) {
+        histogram = std::make_unique<LatencyHistogram>();
+    }
+    return *histogram;
+}
+
+QList<QPair<QString, const LatencyHistogram *>> Metrics::latencies() const
+{
+    QMutexLocker locker(&mutex);
+    QList<QPair<QString, const LatencyHistogram *>> result;
+    for (const auto &entry : histograms) {
+        result.append(qMakePair(entry.first, entry.second.get()));
+    }
+    return result;
+}
+
+void Metrics::resetLatencies()
+{
+    QMutexLocker locker(&mutex);
+    for (const auto &entry : histograms) {
+        entry.second->reset();
+    }
+}
+
+void Metrics::addParsedFile(qint64 bytes)
+{
+    parsedFiles.fetch_add(1, std::memory_order_relaxed);
+    parsedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+qint64 Metrics::residentBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.WorkingSetSize);
+    }
+    return -1;
+#elif defined(Q_OS_LINUX)
+    // /proc/self/statm: размер и резидентная часть в страницах
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+std::shared_ptr<QueuedJob> Metrics::jobQueued()
+{
+    return std::make_shared<QueuedJob>();
+}
+
+QueuedJob::QueuedJob()
+{
+    Metrics::instance().queuedJobs.fetch_add(1, std::memory_order_relaxed);
+}
+
+QueuedJob::~QueuedJob()
+{
+    if (!started) {
+        Metrics::instance().queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+RunningJob::RunningJob(const std::shared_ptr<QueuedJob> &queued)
+{
+    Metrics &metrics = Metrics::instance();
+    if (queued && !queued->started) {
+        queued->started = true;
+        metrics.queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+    metrics.runningJobs.fetch_add(1, std::memory_order_relaxed);
+}
+
+RunningJob::~RunningJob()
+{
+    Metrics::instance().runningJobs.fetch_sub(1, std::memory_order_relaxed);
+}
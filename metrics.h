@@ -0,0 +1,130 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <atomic>
+#include <map>
+#include <memory>
+
+// Распределение задержек: корзина i - от 2^(i-1) до 2^i мкс. Запись - несколько
+// атомарных операций без блокировок; процентили приблизительные (верхняя граница корзины).
+class LatencyHistogram
+{
+public:
+    static constexpr int Buckets = 40;
+
+    void record(qint64 microseconds);
+    void reset();
+    // Добавить все записи другой гистограммы (итог по нескольким замерам)
+    void merge(const LatencyHistogram &other);
+    // Убрать записи снимка earlier (копии этой гистограммы через merge) - остаются новые.
+    // Максимум точный, если вырос после снимка, иначе - верхняя граница корзины
+    void subtract(const LatencyHistogram &earlier);
+
+    quint64 count() const { return total.load(std::memory_order_relaxed); }
+    double meanUs() const;
+    qint64 maxUs() const { return maximum.load(std::memory_order_relaxed); }
+    qint64 percentileUs(double percentile) const;
+
+private:
+    std::atomic<quint64> buckets[Buckets] = {};
+    std::atomic<quint64> total{0};
+    std::atomic<quint64> sum{0};
+    std::atomic<qint64> maximum{0};
+};
+
+class QueuedJob;
+
+// Счетчики для вкладки "Диагностика": обновляются на горячих путях атомарно,
+// читаются периодически. Скорости считает тот, кто читает, по разнице значений.
+class Metrics
+{
+public:
+    static Metrics &instance();
+
+    // Гистограмма по имени (строковый литерал); создается при первом обращении
+    LatencyHistogram &latency(const char *name);
+    QList<QPair<QString, const LatencyHistogram *>> latencies() const;
+    void resetLatencies();
+
+    // Загрузка результатов
+    void addParsedFile(qint64 bytes);
+    void addWrittenRows(qint64 rows) { writtenRows.fetch_add(rows, std::memory_order_relaxed); }
+    qint64 parsedFileCount() const { return parsedFiles.load(std::memory_order_relaxed); }
+    qint64 parsedByteCount() const { return parsedBytes.load(std::memory_order_relaxed); }
+    qint64 writtenRowCount() const { return writtenRows.load(std::memory_order_relaxed); }
+
+    // Фоновые задания: поставлены в очередь пула, но еще не начаты / выполняются.
+    // Отметку очереди захватывает задача; снимается при начале (RunningJob) или при
+    // уничтожении так и не начатой задачи (отмена, очистка пула)
+    std::shared_ptr<QueuedJob> jobQueued();
+    int queuedJobCount() const { return queuedJobs.load(std::memory_order_relaxed); }
+    int runningJobCount() const { return runningJobs.load(std::memory_order_relaxed); }
+
+    // Резидентная память процесса, байт (-1 - платформа не поддерживается)
+    static qint64 residentBytes();
+
+private:
+    friend class QueuedJob;
+    friend class RunningJob;
+
+    Metrics() = default;
+    Q_DISABLE_COPY(Metrics)
+
+    mutable QMutex mutex;
+    std::map<QString, std::unique_ptr<LatencyHistogram>> histograms;
+
+    std::atomic<qint64> parsedFiles{0};
+    std::atomic<qint64> parsedBytes{0};
+    std::atomic<qint64> writtenRows{0};
+    std::atomic<int> queuedJobs{0};
+    std::atomic<int> runningJobs{0};
+};
+
+class QueuedJob
+{
+public:
+    QueuedJob();
+    ~QueuedJob();
+    Q_DISABLE_COPY(QueuedJob)
+
+private:
+    friend class RunningJob;
+    bool started = false;
+};
+
+// В начале тела фоновой задачи; queued - отметка, полученная от Metrics::jobQueued()
+class RunningJob
+{
+public:
+    explicit RunningJob(const std::shared_ptr<QueuedJob> &queued);
+    ~RunningJob();
+    Q_DISABLE_COPY(RunningJob)
+};
+
+// Время от конструктора до деструктора - в гистограмму
+class LatencyTimer
+{
+public:
+    explicit LatencyTimer(LatencyHistogram &histogram) : histogram(histogram) { timer.start(); }
+    ~LatencyTimer() { histogram.record(timer.nsecsElapsed() / 1000); }
+    Q_DISABLE_COPY(LatencyTimer)
+
+private:
+    LatencyHistogram &histogram;
+    QElapsedTimer timer;
+};
+
+#define BD_METRIC_CONCAT_(a, b) a##b
+#define BD_METRIC_CONCAT(a, b) BD_METRIC_CONCAT_(a, b)
+
+// Задержка текущей области видимости; поиск гистограммы - один раз на место вызова
+#define BD_METRIC_LATENCY(name) \
+    static LatencyHistogram &BD_METRIC_CONCAT(bdLatency_, __LINE__) = Metrics::instance().latency(name); \
+    LatencyTimer BD_METRIC_CONCAT(bdLatencyTimer_, __LINE__)(BD_METRIC_CONCAT(bdLatency_, __LINE__))
+
+#endif // METRICS_H
@@ -0,0 +1,121 @@
+#ifndef MODELDIFF_H
+#define MODELDIFF_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+// Больше стольких диапазонов вставки/удаления (или больше четверти списка перемещено) -
+// дешевле сбросить модель: каждая правка QList в середине - O(n) и отдельный сигнал представлению
+constexpr int ListDiffMaxRanges = 256;
+
+// Приводит current к target, сообщая о вставках и удалениях непрерывными диапазонами -
+// модели превращают их в beginInsertRows/beginRemoveRows. Элементы должны быть уникальными.
+// На месте остается наибольшая общая часть, идущая в том же порядке; остальные общие
+// элементы (перемещенные) удаляются и вставляются заново. При большой разнице
+// вызывается reset(target) - beginResetModel/endResetModel.
+//   remove(first, last)      - удалить current[first..last]
+//   insert(position, items)  - вставить items перед current[position]
+template <typename T, typename RemoveFn, typename InsertFn, typename ResetFn>
+void applyListDiff(const QList<T> &current, const QList<T> &target,
+                   RemoveFn remove, InsertFn insert, ResetFn reset)
+{
+    QHash<T, int> targetIndex;
+    targetIndex.reserve(target.size());
+    for (int j = 0; j < target.size(); ++j) {
+        targetIndex.insert(target[j], j);
+    }
+
+    // Позиции общих элементов в target, в порядке current
+    QVector<int> positions;
+    QVector<int> currentRows;
+    for (int i = 0; i < current.size(); ++i) {
+        auto it = targetIndex.constFind(current[i]);
+        if (it != targetIndex.constEnd()) {
+            positions.append(it.value());
+            currentRows.append(i);
+        }
+    }
+
+    // Наибольшая возрастающая подпоследовательность позиций - элементы, которые не двигаются
+    QVector<int> tails;                     // индекс в positions - конец цепочки длины k + 1
+    QVector<int> previous(positions.size(), -1);
+    for (int k = 0; k < positions.size(); ++k) {
+        int low = 0;
+        int high = tails.size();
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (positions[tails[middle]] < positions[k]) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        previous[k] = low > 0 ? tails[low - 1] : -1;
+        if (low == tails.size()) {
+            tails.append(k);
+        } else {
+            tails[low] = k;
+        }
+    }
+
+    QVector<bool> keepCurrent(current.size(), false);
+    QVector<bool> keepTarget(target.size(), false);
+    for (int k = tails.isEmpty() ? -1 : tails.last(); k >= 0; k = previous[k]) {
+        keepCurrent[currentRows[k]] = true;
+        keepTarget[positions[k]] = true;
+    }
+
+    // Сколько будет диапазонов правки
+    int ranges = 0;
+    for (int i = 0; i < current.size(); ++i) {
+        if (!keepCurrent[i] && (i == 0 || keepCurrent[i - 1])) {
+            ranges++;
+        }
+    }
+    for (int j = 0; j < target.size(); ++j) {
+        if (!keepTarget[j] && (j == 0 || keepTarget[j - 1])) {
+            ranges++;
+        }
+    }
+
+    const int moved = positions.size() - tails.size();
+    if (ranges > ListDiffMaxRanges || qint64(moved) * 4 > qMax(current.size(), target.size())) {
+        reset(target);
+        return;
+    }
+
+    // Удаления с конца: индексы впереди не сдвигаются
+    int i = current.size() - 1;
+    while (i >= 0) {
+        if (keepCurrent[i]) {
+            i--;
+            continue;
+        }
+        int last = i;
+        while (i >= 0 && !keepCurrent[i]) {
+            i--;
+        }
+        remove(i + 1, last);
+    }
+
+    // Остались элементы target в его порядке - вставляем недостающие
+    int position = 0;
+    int j = 0;
+    while (j < target.size()) {
+        if (keepTarget[j]) {
+            position++;
+            j++;
+            continue;
+        }
+        int end = j;
+        while (end < target.size() && !keepTarget[end]) {
+            end++;
+        }
+        insert(position, target.mid(j, end - j));
+        position += end - j;
+        j = end;
+    }
+}
+
+#endif // MODELDIFF_H
@@ -0,0 +1,346 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+#include <atomic>
+#include "batchingest.h"
+#include "benchmarkrunner.h"
+#include "database.h"
+#include "fileparser.h"
+#include "materialparser.h"
+#include "propertycurve.h"
+#include "syntheticdata.h"
+
+// Бенчмарки разбора: FileParser (файл целиком, числа, вид расчета), MaterialParser
+// (один и много материалов, папка), загрузка пакета файлов и вычисление разобранных
+// зависимостей свойств по полю температур. Данные генерируются
+// детерминированно во временной папке; отчет - JSON.
+
+namespace {
+
+// Результат, который компилятор не может выбросить
+std::atomic<double> sink{0.0};
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+void benchmarkResultFiles(BenchmarkRunner &runner, const QDir &dir, int nodes, quint64 seed)
+{
+    struct Variant {
+        const char *name;
+        ResultFileOptions::NumberFormat format;
+        bool commaDecimals;
+        double junkRatio;
+    };
+    const QList<Variant> variants = {
+        {"exponent", ResultFileOptions::Exponent, false, 0.0},
+        {"fixed", ResultFileOptions::Fixed, false, 0.0},
+        {"comma_decimals", ResultFileOptions::Exponent, true, 0.0},
+        {"spaced_exponent", ResultFileOptions::SpacedExponent, false, 0.0},
+        {"mixed_junk10", ResultFileOptions::Mixed, true, 0.1}
+    };
+
+    for (const Variant &variant : variants) {
+        const QString name = QString("FileParser::parseFile/%1").arg(variant.name);
+        if (!runner.isSelected(name)) {
+            continue;
+        }
+
+        ResultFileOptions options;
+        options.nodes = nodes;
+        options.format = variant.format;
+        options.commaDecimals = variant.commaDecimals;
+        options.junkRatio = variant.junkRatio;
+        options.seed = seed;
+
+        const QString path = dir.filePath(resultFileName(options.calculationType, int(variant.format)));
+        const QByteArray data = generateResultFile(options);
+        if (!writeFile(path, data)) {
+            continue;
+        }
+
+        runner.run(name, data.size(), nodes, "nodes",
+                   [&path]() {
+                       FileParser parser;
+                       QString error;
+                       ParsedData parsed = parser.parseFile(path, error);
+                       sink = sink + parsed.nodeValues.size();
+                   },
+                   {{"nodes", nodes}, {"format", variant.name}, {"junk_ratio", variant.junkRatio}});
+    }
+}
+
+void benchmarkNumbers(BenchmarkRunner &runner, int count, quint64 seed)
+{
+    struct Variant {
+        const char *name;
+        ResultFileOptions::NumberFormat format;
+        bool commaDecimals;
+    };
+    const QList<Variant> variants = {
+        {"fixed", ResultFileOptions::Fixed, false},
+        {"exponent", ResultFileOptions::Exponent, false},
+        {"spaced_exponent", ResultFileOptions::SpacedExponent, false},
+        {"comma_decimals", ResultFileOptions::Exponent, true}
+    };
+
+    for (const Variant &variant : variants) {
+        const QString name = QString("FileParser::parseNumber/%1").arg(variant.name);
+        if (!runner.isSelected(name)) {
+            continue;
+        }
+
+        const QStringList numbers = generateNumbers(count, variant.format, variant.commaDecimals, seed);
+        qint64 bytes = 0;
+        for (const QString &number : numbers) {
+            bytes += number.size();
+        }
+
+        runner.run(name, bytes, count, "numbers",
+                   [&numbers]() {
+                       double sum = 0.0;
+                       for (const QString &number : numbers) {
+                           sum += FileParser::parseNumber(number);
+                       }
+                       sink = sink + sum;
+                   },
+                   {{"count", count}, {"format", variant.name}});
+    }
+}
+
+void benchmarkCalculationTypes(BenchmarkRunner &runner, int count, quint64 seed)
+{
+    const QStringList names = generateResultFileNames(count, seed);
+    runner.run("FileParser::detectCalculationType", 0, count, "names", [&names]() {
+        FileParser parser;
+        qint64 length = 0;
+        for (const QString &name : names) {
+            length += parser.detectCalculationType(name).size();
+        }
+        sink = sink + length;
+    }, {{"count", count}});
+}
+
+void benchmarkMatML(BenchmarkRunner &runner, const QDir &dir, int materials, quint64 seed)
+{
+    // Входные файлы генерируются только для выбранных фильтром замеров
+    // Один материал в файле - как в экспорте библиотеки Granta по материалу
+    if (runner.isSelected("MaterialParser::parseMatML/single")) {
+        MatMLOptions single;
+        single.seed = seed;
+        const QByteArray singleData = generateMatML(single);
+        const QString singlePath = dir.filePath("single.xml");
+        writeFile(singlePath, singleData);
+
+        runner.run("MaterialParser::parseMatML/single", singleData.size(), 1, "materials", [&singlePath]() {
+            MaterialParser parser;
+            sink = sink + parser.parseMatML(singlePath).values.size();
+        }, {{"properties", single.properties}});
+    }
+
+    // Вся библиотека в одном документе
+    if (runner.isSelected("MaterialParser::parseMatML/multi")) {
+        MatMLOptions multi;
+        multi.materials = materials;
+        multi.seed = seed;
+        const QByteArray multiData = generateMatML(multi);
+        const QString multiPath = dir.filePath("library.xml");
+        writeFile(multiPath, multiData);
+
+        runner.run("MaterialParser::parseMatML/multi", multiData.size(), materials, "materials",
+                   [&multiPath]() {
+                       MaterialParser parser;
+                       sink = sink + parser.parseMatML(multiPath).values.size();
+                   },
+                   {{"materials", materials}, {"properties", multi.properties}});
+    }
+
+    // Папка файлов по одному материалу
+    if (!runner.isSelected("MaterialParser::parseDirectory")) {
+        return;
+    }
+    QDir libraryDir(dir.filePath("library"));
+    libraryDir.mkpath(".");
+    qint64 libraryBytes = 0;
+    for (int i = 0; i < materials; ++i) {
+        MatMLOptions options;
+        options.seed = seed + i;
+        const QByteArray data = generateMatML(options);
+        writeFile(libraryDir.filePath(QString("material_%1.xml").arg(i)), data);
+        libraryBytes += data.size();
+    }
+
+    runner.run("MaterialParser::parseDirectory", libraryBytes, materials, "materials",
+               [&libraryDir]() {
+                   MaterialParser parser;
+                   sink = sink + parser.parseDirectory(libraryDir.path()).size();
+               },
+               {{"materials", materials}});
+}
+
+void benchmarkCurves(BenchmarkRunner &runner, int nodes, int points, quint64 seed)
+{
+    if (!runner.isSelected("PropertyCurve::evaluate/scalar")
+        && !runner.isSelected("PropertyCurve::evaluate/batch")) {
+        return;
+    }
+
+    // Зависимость как в MatML (модуль упругости от температуры) и температура в каждом узле
+    QVector<double> temperatures(points);
+    QVector<double> moduli(points);
+    for (int i = 0; i < points; ++i) {
+        temperatures[i] = -50.0 + 600.0 * i / qMax(1, points - 1);
+        moduli[i] = 2.1e11 - 1.0e8 * temperatures[i];
+    }
+    const PropertyCurve curve(temperatures, moduli);
+
+    QRandomGenerator random(quint32(seed ^ (seed >> 32)));
+    QVector<double> field(nodes);
+    for (double &temperature : field) {
+        temperature = -100.0 + 700.0 * random.generateDouble();
+    }
+    const QVariantMap parameters = {{"nodes", nodes}, {"points", points}};
+
+    runner.run("PropertyCurve::evaluate/scalar", 0, nodes, "nodes", [&curve, &field]() {
+        double sum = 0.0;
+        for (double temperature : field) {
+            sum += curve.evaluate(temperature);
+        }
+        sink = sink + sum;
+    }, parameters);
+
+    QVector<double> values(nodes);
+    runner.run("PropertyCurve::evaluate/batch", 0, nodes, "nodes", [&curve, &field, &values]() {
+        curve.evaluate(field.constData(), values.data(), field.size());
+        sink = sink + values.last();
+    }, parameters);
+}
+
+void benchmarkIngest(BenchmarkRunner &runner, const QDir &dir, int files, int nodes, quint64 seed)
+{
+    if (!runner.isSelected("ingest/parallelParse") && !runner.isSelected("ingest/batchToSqlite")) {
+        return;
+    }
+
+    // Пакет файлов разных видов расчета для одной модели
+    QDir modelDir(dir.filePath("Bracket"));
+    modelDir.mkpath(".");
+    static const QStringList types = {"Normal Stress", "Shear Stress", "Total Deformation",
+                                      "Directional Deformation X"};
+
+    QStringList paths;
+    qint64 bytes = 0;
+    for (int i = 0; i < files; ++i) {
+        ResultFileOptions options;
+        options.nodes = nodes;
+        options.calculationType = types[i % types.size()];
+        options.unit = options.calculationType.contains("Stress") ? "MPa" : "mm";
+        options.seed = seed + i;
+
+        const QByteArray data = generateResultFile(options);
+        const QString path = modelDir.filePath(resultFileName(options.calculationType, i));
+        writeFile(path, data);
+        paths.append(path);
+        bytes += data.size();
+    }
+
+    const qint64 totalNodes = qint64(files) * nodes;
+    const QVariantMap parameters = {{"files", files}, {"nodes_per_file", nodes},
+                                    {"threads", QThreadPool::globalInstance()->maxThreadCount()}};
+
+    runner.run("ingest/parallelParse", bytes, totalNodes, "nodes", [&paths]() {
+        const QList<int> sizes = QtConcurrent::blockingMapped<QList<int>>(paths, [](const QString &path) {
+            FileParser parser;
+            QString error;
+            return int(parser.parseFile(path, error).nodeValues.size());
+        });
+        sink = sink + sizes.size();
+    }, parameters);
+
+    // Разбор и запись одной транзакцией в новую базу - как bd_lab3_cli ingest
+    int run = 0;
+    QString databasePath;
+    runner.run("ingest/batchToSqlite", bytes, totalNodes, "nodes",
+               [&]() {
+                   Database database(QString("bench_ingest_%1").arg(run));
+                   if (!database.initDatabase(databasePath)) {
+                       return;
+                   }
+                   BatchIngest ingest(&database);
+                   sink = sink + ingest.run(paths).rows;
+               },
+               parameters,
+               [&]() {
+                   QFile::remove(databasePath);
+                   databasePath = dir.filePath(QString("ingest_%1.db").arg(++run));
+               });
+    QFile::remove(databasePath);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bd_lab3_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Parser and ingest benchmarks on deterministic synthetic data.\n"
+        "Table goes to stderr, JSON report to --out.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {{"o", "out"}, "JSON report file, '-' for stdout (default: bench_parsers.json).", "file",
+         "bench_parsers.json"},
+        {"filter", "Run only benchmarks whose name matches the regular expression.", "regex"},
+        {"nodes", "Nodes per result file (default: 200000).", "count", "200000"},
+        {"files", "Files in the ingest benchmarks (default: 16).", "count", "16"},
+        {"materials", "Materials in the MatML benchmarks (default: 200).", "count", "200"},
+        {"numbers", "Numbers in the parseNumber benchmarks (default: 200000).", "count", "200000"},
+        {"seed", "Generator seed (default: 1).", "seed", "1"},
+        {"quick", "One measured iteration per benchmark (smoke run)."}
+    });
+    parser.process(app);
+
+    const int nodes = qMax(1, parser.value("nodes").toInt());
+    const int files = qMax(1, parser.value("files").toInt());
+    const int materials = qMax(1, parser.value("materials").toInt());
+    const int numbers = qMax(1, parser.value("numbers").toInt());
+    const quint64 seed = parser.value("seed").toULongLong();
+
+    QTemporaryDir temporaryDir;
+    if (!temporaryDir.isValid()) {
+        QTextStream(stderr) << "Cannot create temporary directory\n";
+        return 2;
+    }
+    const QDir dir(temporaryDir.path());
+
+    BenchmarkRunner runner("parsers");
+    runner.setFilter(parser.value("filter"));
+    if (parser.isSet("quick")) {
+        runner.setIterations(1, 1);
+        runner.setMinTimeMs(0);
+    }
+    runner.setContext("nodes", nodes);
+    runner.setContext("seed", QString::number(seed));
+
+    benchmarkResultFiles(runner, dir, nodes, seed);
+    benchmarkNumbers(runner, numbers, seed);
+    benchmarkCalculationTypes(runner, numbers, seed);
+    benchmarkMatML(runner, dir, materials, seed);
+    benchmarkCurves(runner, nodes, 64, seed);
+    benchmarkIngest(runner, dir, files, qMax(1, nodes / 4), seed);
+
+    QString error;
+    if (!runner.writeReport(parser.value("out"), &error)) {
+        QTextStream(stderr) << error << "\n";
+        return 2;
+    }
+    return 0;
+}
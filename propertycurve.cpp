@@ -0,0 +1,136 @@
+#include "propertycurve.h"
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <cstring>
+
+PropertyCurve::PropertyCurve(const QVector<double> &abscissa, const QVector<double> &ordinate)
+{
+    const int count = qMin(abscissa.size(), ordinate.size());
+
+    QVector<int> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&abscissa](int a, int b) {
+        return abscissa[a] < abscissa[b];
+    });
+
+    // Повторяющиеся абсциссы схлопываем, оставляя последнее значение
+    for (int index : order) {
+        if (!xs.isEmpty() && xs.last() == abscissa[index]) {
+            ys.last() = ordinate[index];
+            continue;
+        }
+        xs.append(abscissa[index]);
+        ys.append(ordinate[index]);
+    }
+
+    prepare();
+}
+
+void PropertyCurve::prepare()
+{
+    const int n = xs.size();
+    slopes.resize(qMax(0, n - 1));
+    for (int i = 0; i + 1 < n; ++i) {
+        slopes[i] = (ys[i + 1] - ys[i]) / (xs[i + 1] - xs[i]);
+    }
+
+    bucketSegments.clear();
+    bucketScale = 0.0;
+    if (n < 2) {
+        return;
+    }
+
+    // По 4 ведра на отрезок: поиск отрезка почти всегда за O(1)
+    const int buckets = 4 * (n - 1);
+    bucketScale = buckets / (xs.last() - xs.first());
+    bucketSegments.resize(buckets + 1);
+
+    int segment = 0;
+    for (int b = 0; b <= buckets; ++b) {
+        const double left = xs.first() + b / bucketScale;
+        while (segment + 1 < n - 1 && xs[segment + 1] <= left) {
+            segment++;
+        }
+        bucketSegments[b] = segment;
+    }
+}
+
+int PropertyCurve::segmentOf(double x) const
+{
+    // Приведение к int вне диапазона (и NaN) - UB: ограничиваем еще в double
+    if (std::isnan(x)) {
+        return 0;
+    }
+    const double position = qBound(0.0, (x - xs.first()) * bucketScale,
+                                   double(bucketSegments.size() - 1));
+    const int bucket = int(position);
+
+    int segment = bucketSegments[bucket];
+    const int last = xs.size() - 2;
+    while (segment < last && x >= xs[segment + 1]) {
+        segment++;
+    }
+    return segment;
+}
+
+double PropertyCurve::evaluate(double x) const
+{
+    double result = 0.0;
+    evaluate(&x, &result, 1);
+    return result;
+}
+
+void PropertyCurve::evaluate(const double *x, double *out, qsizetype count) const
+{
+    const int n = xs.size();
+    if (n == 0) {
+        std::fill(out, out + count, 0.0);
+        return;
+    }
+    if (n == 1) {
+        std::fill(out, out + count, ys.first());
+        return;
+    }
+
+    const double xMin = xs.first();
+    const double xMax = xs.last();
+    const double yMin = ys.first();
+    const double yMax = ys.last();
+    const double *px = xs.constData();
+    const double *py = ys.constData();
+    const double *ps = slopes.constData();
+
+    for (qsizetype i = 0; i < count; ++i) {
+        const double value = x[i];
+        if (std::isnan(value)) {
+            out[i] = value;
+        } else if (value <= xMin) {
+            out[i] = yMin;
+        } else if (value >= xMax) {
+            out[i] = yMax;
+        } else {
+            const int s = segmentOf(value);
+            out[i] = py[s] + ps[s] * (value - px[s]);
+        }
+    }
+}
+
+QByteArray PropertyCurve::toBlob(const QVector<double> &values)
+{
+    QByteArray blob(values.size() * qsizetype(sizeof(double)), Qt::Uninitialized);
+    for (int i = 0; i < values.size(); ++i) {
+        qToLittleEndian(values[i], blob.data() + i * sizeof(double));
+    }
+    return blob;
+}
+
+QVector<double> PropertyCurve::fromBlob(const QByteArray &blob)
+{
+    QVector<double> values(blob.size() / qsizetype(sizeof(double)));
+    for (int i = 0; i < values.size(); ++i) {
+        values[i] = qFromLittleEndian<double>(blob.constData() + i * sizeof(double));
+    }
+    return values;
+}
@@ -0,0 +1,45 @@
+#ifndef PROPERTYCURVE_H
+#define PROPERTYCURVE_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+// Табличная зависимость свойства от параметра (обычно от температуры).
+// Точки хранятся отсортированными по абсциссе; между точками - линейная
+// интерполяция, за пределами диапазона - крайние значения, для NaN - NaN.
+class PropertyCurve
+{
+public:
+    PropertyCurve() = default;
+    PropertyCurve(const QVector<double> &abscissa, const QVector<double> &ordinate);
+
+    QString parameterName;
+    QString parameterUnit;
+
+    bool isEmpty() const { return xs.isEmpty(); }
+    int size() const { return xs.size(); }
+    const QVector<double> &abscissa() const { return xs; }
+    const QVector<double> &ordinate() const { return ys; }
+
+    double evaluate(double x) const;
+
+    // Пакетное вычисление: out[i] = f(x[i]), например для поля температур по узлам
+    void evaluate(const double *x, double *out, qsizetype count) const;
+
+    // Компактное хранение в БД: массив double как BLOB
+    static QByteArray toBlob(const QVector<double> &values);
+    static QVector<double> fromBlob(const QByteArray &blob);
+
+private:
+    void prepare();
+    int segmentOf(double x) const;
+
+    QVector<double> xs;
+    QVector<double> ys;
+    QVector<double> slopes;       // наклон на каждом отрезке
+    QVector<int> bucketSegments;  // равномерная сетка: ведро -> первый подходящий отрезок
+    double bucketScale = 0.0;
+};
+
+#endif // PROPERTYCURVE_H
@@ -0,0 +1,45 @@
+#include "refreshscheduler.h"
+
+RefreshScheduler::RefreshScheduler(int debounceMs, QObject *parent)
+    : QObject(parent)
+    , debounceMs(qMax(0, debounceMs))
+{
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, &RefreshScheduler::fire);
+}
+
+void RefreshScheduler::request(Reason reason)
+{
+    requests++;
+    pending |= reason;
+
+    // Новый запрос делает устаревшим уже идущее обновление
+    currentGeneration++;
+
+    // Каждый запрос откладывает обновление на debounceMs, но не дальше maxLatencyMs от первого
+    if (!timer.isActive()) {
+        firstPending.start();
+    }
+    const qint64 left = qMax<qint64>(0, maxLatencyMs - firstPending.elapsed());
+    timer.start(int(qMin<qint64>(debounceMs, left)));
+}
+
+void RefreshScheduler::cancel()
+{
+    timer.stop();
+    pending = Reasons();
+    currentGeneration++;
+}
+
+void RefreshScheduler::fire()
+{
+    if (!pending) {
+        return;
+    }
+
+    Reasons reasons = pending;
+    pending = Reasons();
+    refreshes++;
+
+    emit refreshRequested(reasons, currentGeneration);
+}
@@ -0,0 +1,59 @@
+#ifndef REFRESHSCHEDULER_H
+#define REFRESHSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+// Объединяет запросы на обновление представления (смена фильтра, новые данные, запуск)
+// в одно обновление: оно выполняется, когда запросов не было debounceMs (0 - до конца
+// прохода цикла событий), но не позже maxLatencyMs после первого необработанного запроса.
+// Номер поколения позволяет отбросить результат, если после начала
+// обновления пришел новый запрос.
+class RefreshScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Reason {
+        FilterChanged = 0x1,
+        DataChanged = 0x2,
+        Startup = 0x4
+    };
+    Q_DECLARE_FLAGS(Reasons, Reason)
+
+    explicit RefreshScheduler(int debounceMs = 0, QObject *parent = nullptr);
+
+    void request(Reason reason);
+    void cancel();
+
+    // Непрерывный поток запросов все равно обновляет представление не реже этого
+    void setMaxLatency(int milliseconds) { maxLatencyMs = qMax(0, milliseconds); }
+
+    quint64 generation() const { return currentGeneration; }
+    bool isCurrent(quint64 generation) const { return generation == currentGeneration && !timer.isActive(); }
+
+    // Сколько запросов пришло и сколько обновлений выполнено
+    quint64 requestCount() const { return requests; }
+    quint64 refreshCount() const { return refreshes; }
+
+signals:
+    void refreshRequested(RefreshScheduler::Reasons reasons, quint64 generation);
+
+private slots:
+    void fire();
+
+private:
+    QTimer timer;
+    int debounceMs;
+    int maxLatencyMs = 250;
+    QElapsedTimer firstPending;
+    Reasons pending;
+    quint64 currentGeneration = 0;
+    quint64 requests = 0;
+    quint64 refreshes = 0;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(RefreshScheduler::Reasons)
+
+#endif // REFRESHSCHEDULER_H
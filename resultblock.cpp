@@ -0,0 +1,67 @@
+#include "resultblock.h"
+
+int ResultBlock::indexOf(QStringList &names, int &lastIndex, const QString &name)
+{
+    // Строки идут по моделям подряд, поэтому чаще всего совпадает предыдущее имя
+    if (lastIndex >= 0 && names[lastIndex] == name) {
+        return lastIndex;
+    }
+
+    lastIndex = names.indexOf(name);
+    if (lastIndex < 0) {
+        names.append(name);
+        lastIndex = names.size() - 1;
+    }
+    return lastIndex;
+}
+
+void ResultBlock::append(const QString &modelName, const QString &nodeNumber,
+                         const QString &calculationType, double value)
+{
+    modelIndex.append(indexOf(models, lastModel, modelName));
+    typeIndex.append(indexOf(calculationTypes, lastType, calculationType));
+    values.append(value);
+    nodeText.append(nodeNumber);
+    nodeEnds.append(nodeText.size());
+}
+
+void ResultBlock::reserve(int rows)
+{
+    modelIndex.reserve(rows);
+    typeIndex.reserve(rows);
+    values.reserve(rows);
+    nodeEnds.reserve(rows);
+}
+
+void ResultBlock::squeeze()
+{
+    modelIndex.squeeze();
+    typeIndex.squeeze();
+    values.squeeze();
+    nodeText.squeeze();
+    nodeEnds.squeeze();
+}
+
+QString ResultBlock::nodeNumber(int row) const
+{
+    int begin = row > 0 ? nodeEnds[row - 1] : 0;
+    return nodeText.mid(begin, nodeEnds[row] - begin);
+}
+
+qint64 ResultBlock::memoryBytes() const
+{
+    qint64 bytes = sizeof(ResultBlock);
+    bytes += modelIndex.capacity() * qint64(sizeof(quint32));
+    bytes += typeIndex.capacity() * qint64(sizeof(quint32));
+    bytes += values.capacity() * qint64(sizeof(double));
+    bytes += nodeEnds.capacity() * qint64(sizeof(int));
+    bytes += nodeText.capacity() * qint64(sizeof(QChar));
+
+    for (const QString &name : models) {
+        bytes += sizeof(QString) + name.capacity() * qint64(sizeof(QChar));
+    }
+    for (const QString &name : calculationTypes) {
+        bytes += sizeof(QString) + name.capacity() * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
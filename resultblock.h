@@ -0,0 +1,50 @@
+#ifndef RESULTBLOCK_H
+#define RESULTBLOCK_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Результаты запроса в колоночном виде. Названия моделей и видов расчетов хранятся
+// один раз в словарях, в строках - их индексы; номера узлов лежат подряд в одном буфере.
+// Порядок строк - как в запросе (модель, узел, вид расчета).
+class ResultBlock
+{
+public:
+    void append(const QString &modelName, const QString &nodeNumber,
+                const QString &calculationType, double value);
+    void reserve(int rows);
+    void squeeze();
+
+    int size() const { return values.size(); }
+    bool isEmpty() const { return values.isEmpty(); }
+
+    const QString &modelName(int row) const { return models[modelIndex[row]]; }
+    const QString &calculationType(int row) const { return calculationTypes[typeIndex[row]]; }
+    QString nodeNumber(int row) const;
+    double value(int row) const { return values[row]; }
+
+    const QStringList &modelNames() const { return models; }
+    const QStringList &calculationTypeNames() const { return calculationTypes; }
+    int modelNameIndex(int row) const { return modelIndex[row]; }
+    int calculationTypeIndex(int row) const { return typeIndex[row]; }
+
+    // Занимаемая память (по выделенной емкости контейнеров)
+    qint64 memoryBytes() const;
+
+private:
+    static int indexOf(QStringList &names, int &lastIndex, const QString &name);
+
+    QStringList models;
+    QStringList calculationTypes;
+    QVector<quint32> modelIndex;
+    QVector<quint32> typeIndex;
+    QVector<double> values;
+    QString nodeText;
+    QVector<int> nodeEnds;      // конец номера узла i в nodeText
+
+    int lastModel = -1;
+    int lastType = -1;
+};
+
+#endif // RESULTBLOCK_H
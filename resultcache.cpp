@@ -0,0 +1,179 @@
+#include "resultcache.h"
+#include <QMutexLocker>
+#include <cmath>
+
+namespace {
+
+QString boundKey(double bound)
+{
+    return std::isfinite(bound) ? QString::number(bound, 'g', 17) : QString();
+}
+
+}
+
+ResultCache::ResultCache(qint64 capacityBytes)
+    : capacity(capacityBytes)
+{
+}
+
+QString ResultCache::keyFor(const ResultFilter &filter)
+{
+    // Бесконечные границы и отрицательный limit означают одно и то же - "без ограничения"
+    return QStringList{filter.modelName,
+                       filter.calculationType,
+                       boundKey(filter.minimum),
+                       boundKey(filter.maximum),
+                       QString::number(filter.limit < 0 ? -1 : filter.limit)}
+        .join(QChar(0x1f));
+}
+
+std::shared_ptr<const ResultBlock> ResultCache::find(const ResultFilter &filter)
+{
+    QMutexLocker locker(&mutex);
+
+    auto it = entries.find(keyFor(filter));
+    if (it == entries.end()) {
+        missCount++;
+        return nullptr;
+    }
+
+    hitCount++;
+    it->lastUse = ++useCounter;
+    return it->block;
+}
+
+quint64 ResultCache::version() const
+{
+    QMutexLocker locker(&mutex);
+    return currentVersion;
+}
+
+bool ResultCache::insert(const ResultFilter &filter, const std::shared_ptr<const ResultBlock> &block,
+                         quint64 version)
+{
+    QMutexLocker locker(&mutex);
+
+    if (!block || version != currentVersion) {
+        return false;
+    }
+
+    qint64 bytes = block->memoryBytes();
+    if (bytes > capacity) {
+        return false;
+    }
+
+    const QString key = keyFor(filter);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        usedBytes -= it->bytes;
+        entries.erase(it);
+    }
+
+    evictTo(capacity - bytes);
+
+    Entry entry;
+    entry.filter = filter;
+    entry.block = block;
+    entry.bytes = bytes;
+    entry.lastUse = ++useCounter;
+    entries.insert(key, entry);
+    usedBytes += bytes;
+    return true;
+}
+
+void ResultCache::invalidate(const QString &modelName, const QString &calculationType)
+{
+    QMutexLocker locker(&mutex);
+
+    currentVersion++;
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        const ResultFilter &filter = it->filter;
+        bool modelMatches = modelName.isEmpty() || filter.modelName.isEmpty()
+                            || filter.modelName == modelName;
+        bool typeMatches = calculationType.isEmpty() || filter.calculationType.isEmpty()
+                           || filter.calculationType == calculationType;
+
+        if (modelMatches && typeMatches) {
+            usedBytes -= it->bytes;
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ResultCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    currentVersion++;
+    entries.clear();
+    usedBytes = 0;
+}
+
+void ResultCache::evictTo(qint64 bytes)
+{
+    // Записей немного (одна на комбинацию фильтров), линейный поиск самой старой достаточен
+    while (usedBytes > bytes && !entries.isEmpty()) {
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->lastUse < oldest->lastUse) {
+                oldest = it;
+            }
+        }
+        usedBytes -= oldest->bytes;
+        entries.erase(oldest);
+        evictionCount++;
+    }
+}
+
+void ResultCache::setCapacityBytes(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    capacity = qMax<qint64>(0, bytes);
+    evictTo(capacity);
+}
+
+qint64 ResultCache::trim(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    const qint64 before = usedBytes;
+    evictTo(usedBytes - bytes);
+    return before - usedBytes;
+}
+
+qint64 ResultCache::capacityBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return capacity;
+}
+
+qint64 ResultCache::memoryBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return usedBytes;
+}
+
+int ResultCache::count() const
+{
+    QMutexLocker locker(&mutex);
+    return entries.size();
+}
+
+quint64 ResultCache::hits() const
+{
+    QMutexLocker locker(&mutex);
+    return hitCount;
+}
+
+quint64 ResultCache::misses() const
+{
+    QMutexLocker locker(&mutex);
+    return missCount;
+}
+
+quint64 ResultCache::evictions() const
+{
+    QMutexLocker locker(&mutex);
+    return evictionCount;
+}
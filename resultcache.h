@@ -0,0 +1,69 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <memory>
+#include "database.h"
+#include "resultblock.h"
+
+// Кэш результатов запросов с вытеснением давно не использованных (LRU) по объему памяти.
+// Ключ - нормализованный фильтр. Запись сбрасывается, только если загрузка или удаление
+// затронули пару (модель, вид расчета), попадающую под ее фильтр.
+// Потокобезопасен: запросы выполняются в фоне, а инвалидация приходит из потока GUI.
+class ResultCache
+{
+public:
+    explicit ResultCache(qint64 capacityBytes = 64 * 1024 * 1024);
+
+    static QString keyFor(const ResultFilter &filter);
+
+    std::shared_ptr<const ResultBlock> find(const ResultFilter &filter);
+
+    // Версию нужно взять до начала запроса: если за время запроса была инвалидация,
+    // результат мог устареть и в кэш не попадет
+    quint64 version() const;
+    bool insert(const ResultFilter &filter, const std::shared_ptr<const ResultBlock> &block,
+                quint64 version);
+
+    // Пустая строка - все модели (все виды расчетов)
+    void invalidate(const QString &modelName, const QString &calculationType = QString());
+    void clear();
+
+    void setCapacityBytes(qint64 bytes);
+    qint64 capacityBytes() const;
+    qint64 memoryBytes() const;
+    int count() const;
+
+    // Вытеснить давно не использованные записи не меньше чем на bytes (бюджет памяти);
+    // возвращает освобожденное
+    qint64 trim(qint64 bytes);
+
+    quint64 hits() const;
+    quint64 misses() const;
+    quint64 evictions() const;
+
+private:
+    struct Entry {
+        ResultFilter filter;
+        std::shared_ptr<const ResultBlock> block;
+        qint64 bytes = 0;
+        quint64 lastUse = 0;
+    };
+
+    void evictTo(qint64 bytes);
+
+    mutable QMutex mutex;
+    QHash<QString, Entry> entries;
+    qint64 capacity;
+    qint64 usedBytes = 0;
+    quint64 useCounter = 0;
+    quint64 currentVersion = 0;
+
+    quint64 hitCount = 0;
+    quint64 missCount = 0;
+    quint64 evictionCount = 0;
+};
+
+#endif // RESULTCACHE_H
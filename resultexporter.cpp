@@ -0,0 +1,330 @@
+#include "resultexporter.h"
+#include "metrics.h"
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPromise>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <atomic>
+#include <charconv>
+#include <memory>
+
+namespace {
+
+QByteArray csvField(const QString &text)
+{
+    QByteArray utf8 = text.toUtf8();
+    if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n') || utf8.contains('\r')) {
+        utf8.replace("\"", "\"\"");
+        return '"' + utf8 + '"';
+    }
+    return utf8;
+}
+
+// Кратчайшая запись, которая читается обратно в то же значение
+void appendNumber(QByteArray &out, double value)
+{
+    char buffer[32];
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, int(result.ptr - buffer));
+}
+
+void writeUtf8(QDataStream &stream, const QByteArray &utf8)
+{
+    stream << quint32(utf8.size());
+    stream.writeRawData(utf8.constData(), int(utf8.size()));
+}
+
+}
+
+ResultExporter::ResultExporter(Database *database)
+    : db(database)
+{
+}
+
+ResultExportFormat ResultExporter::formatForFile(const QString &fileName)
+{
+    return QFileInfo(fileName).suffix().compare("bdr", Qt::CaseInsensitive) == 0
+               ? ResultExportFormat::Binary
+               : ResultExportFormat::Csv;
+}
+
+QByteArray ResultExporter::csvHeader()
+{
+    return "Model,Node Number,Calculation Type,Value,Unit\n";
+}
+
+QByteArray ResultExporter::formatCsvChunk(const ResultBlock &block, const QHash<QString, QString> &units)
+{
+    // Названия моделей, видов расчетов и их единицы кодируются один раз на порцию
+    QList<QByteArray> models;
+    for (const QString &name : block.modelNames()) {
+        models.append(csvField(name));
+    }
+    QList<QByteArray> types;
+    QList<QByteArray> typeUnits;
+    for (const QString &name : block.calculationTypeNames()) {
+        types.append(csvField(name));
+        typeUnits.append(csvField(units.value(name)));
+    }
+
+    QByteArray out;
+    out.reserve(block.size() * 48);
+
+    for (int i = 0; i < block.size(); ++i) {
+        out += models[block.modelNameIndex(i)];
+        out += ',';
+        out += csvField(block.nodeNumber(i));
+        out += ',';
+        out += types[block.calculationTypeIndex(i)];
+        out += ',';
+        appendNumber(out, block.value(i));
+        out += ',';
+        out += typeUnits[block.calculationTypeIndex(i)];
+        out += '\n';
+    }
+    return out;
+}
+
+QByteArray ResultExporter::binaryHeader()
+{
+    QByteArray out;
+    QDataStream stream(&out, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("BDRB", 4);
+    stream << quint32(1);
+    return out;
+}
+
+QByteArray ResultExporter::formatBinaryChunk(const ResultBlock &block)
+{
+    QByteArray out;
+    out.reserve(block.size() * 24);
+
+    QDataStream stream(&out, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+    stream << quint32(block.size());
+
+    stream << quint32(block.modelNames().size());
+    for (const QString &name : block.modelNames()) {
+        writeUtf8(stream, name.toUtf8());
+    }
+    stream << quint32(block.calculationTypeNames().size());
+    for (const QString &name : block.calculationTypeNames()) {
+        writeUtf8(stream, name.toUtf8());
+    }
+
+    for (int i = 0; i < block.size(); ++i) {
+        stream << quint32(block.modelNameIndex(i));
+    }
+    for (int i = 0; i < block.size(); ++i) {
+        stream << quint32(block.calculationTypeIndex(i));
+    }
+
+    QByteArray nodes;
+    QVector<quint32> nodeEnds;
+    nodeEnds.reserve(block.size());
+    for (int i = 0; i < block.size(); ++i) {
+        nodes += block.nodeNumber(i).toUtf8();
+        nodeEnds.append(quint32(nodes.size()));
+    }
+    writeUtf8(stream, nodes);
+    for (quint32 end : nodeEnds) {
+        stream << end;
+    }
+
+    for (int i = 0; i < block.size(); ++i) {
+        stream << block.value(i);
+    }
+    return out;
+}
+
+QByteArray ResultExporter::binaryFooter(qint64 rows)
+{
+    QByteArray out;
+    QDataStream stream(&out, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint32(0) << quint64(rows);
+    return out;
+}
+
+ResultExportStats ResultExporter::run(const ResultFilter &filter, const QString &fileName,
+                                      ResultExportFormat format,
+                                      const std::function<bool(qint64, qint64)> &progress,
+                                      const CancellationToken &token)
+{
+    ResultExportStats stats;
+    QElapsedTimer timer;
+    timer.start();
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        stats.error = "Cannot open file for writing: " + fileName;
+        stats.outcome.status = QueryStatus::Failed;
+        return stats;
+    }
+
+    // Общее число строк - только для индикатора прогресса; подсчет тоже отменяется токеном
+    qint64 totalRows = -1;
+    if (progress) {
+        QList<ResultSummary> summaries;
+        if (db->summarizeCalculationResults(filter, summaries, token).isComplete()) {
+            totalRows = 0;
+            for (const ResultSummary &summary : summaries) {
+                totalRows += summary.count;
+            }
+        }
+        if (!progress(0, totalRows)) {
+            token.cancel();
+        }
+    }
+
+    // Значения пишутся в СИ - рядом единица СИ вида расчета
+    QHash<QString, QString> units;
+    if (format == ResultExportFormat::Csv) {
+        for (const auto &type : db->getAllCalculationTypes()) {
+            units.insert(type.first, type.second);
+        }
+    }
+
+    QList<QFuture<QByteArray>> pending;
+    const int maxPending = qMax(2, QThreadPool::globalInstance()->maxThreadCount() * 2);
+
+    auto write = [&](const QByteArray &bytes) {
+        if (!stats.error.isEmpty()) {
+            return false;
+        }
+        if (file.write(bytes) != bytes.size()) {
+            stats.error = "Write failed: " + file.errorString();
+            token.cancel();
+            return false;
+        }
+        stats.bytes += bytes.size();
+        return true;
+    };
+
+    // Готовые порции уходят в файл по порядку; при полной очереди ждем самую старую
+    auto drain = [&](bool all) {
+        while (!pending.isEmpty()
+               && (all || pending.size() >= maxPending || pending.first().isFinished())) {
+            if (!write(pending.takeFirst().result())) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    ResultBlock chunk;
+    chunk.reserve(chunkRows);
+    qint64 dispatchedRows = 0;
+
+    auto dispatch = [&]() {
+        auto block = std::make_shared<const ResultBlock>(std::move(chunk));
+        chunk = ResultBlock();
+        chunk.reserve(chunkRows);
+        dispatchedRows += block->size();
+
+        pending.append(QtConcurrent::run([block, format, units]() {
+            return format == ResultExportFormat::Binary ? formatBinaryChunk(*block)
+                                                        : formatCsvChunk(*block, units);
+        }));
+        return drain(false);
+    };
+
+    write(format == ResultExportFormat::Binary ? binaryHeader() : csvHeader());
+
+    stats.outcome = db->forEachCalculationResult(filter,
+        [&](const QString &modelName, const QString &nodeNumber,
+            const QString &calculationType, double value) {
+            chunk.append(modelName, nodeNumber, calculationType, value);
+            if (chunk.size() < chunkRows) {
+                return true;
+            }
+
+            if (!dispatch()) {
+                return false;
+            }
+            if (progress && !progress(dispatchedRows, totalRows)) {
+                token.cancel();
+            }
+            return true;
+        }, token);
+
+    if (stats.outcome.isComplete() && stats.error.isEmpty()) {
+        if (!chunk.isEmpty()) {
+            dispatch();
+        }
+        drain(true);
+        if (format == ResultExportFormat::Binary) {
+            write(binaryFooter(dispatchedRows));
+        }
+    } else {
+        // Форматирование уже отправленных порций дожидаемся - они ссылаются на свои блоки
+        for (QFuture<QByteArray> &future : pending) {
+            future.waitForFinished();
+        }
+        pending.clear();
+    }
+
+    stats.rows = dispatchedRows;
+    if (stats.ok()) {
+        if (!file.commit()) {
+            stats.error = "Cannot save file: " + file.errorString();
+        }
+    } else {
+        file.cancelWriting();
+    }
+
+    if (progress && stats.ok()) {
+        progress(stats.rows, stats.rows);
+    }
+
+    stats.elapsedMs = timer.elapsed();
+    return stats;
+}
+
+QFuture<ResultExportStats> ResultExporter::runInBackground(const QString &databaseName,
+                                                           const ResultFilter &filter,
+                                                           const QString &fileName,
+                                                           ResultExportFormat format,
+                                                           const CancellationToken &token)
+{
+    // Как и загрузка: поток чтения и записи вне общего пула, где форматируются порции
+    static QThreadPool exportPool;
+    exportPool.setMaxThreadCount(1);
+
+    const std::shared_ptr<QueuedJob> queued = Metrics::instance().jobQueued();
+    return QtConcurrent::run(&exportPool,
+                             [databaseName, filter, fileName, format, token,
+                              queued](QPromise<ResultExportStats> &promise) {
+        RunningJob job(queued);
+        static std::atomic<int> connectionCounter{0};
+
+        ResultExportStats stats;
+        Database database(QString("result_export_%1").arg(++connectionCounter));
+        if (!database.openConnection(databaseName)) {
+            stats.outcome.status = QueryStatus::Failed;
+            stats.error = "Cannot open database: " + databaseName;
+            promise.addResult(stats);
+            return;
+        }
+
+        ResultExporter exporter(&database);
+        bool rangeSet = false;
+        stats = exporter.run(filter, fileName, format, [&](qint64 rows, qint64 totalRows) {
+            if (!rangeSet && totalRows >= 0) {
+                promise.setProgressRange(0, int(qMin<qint64>(totalRows, std::numeric_limits<int>::max())));
+                rangeSet = true;
+            }
+            promise.setProgressValueAndText(int(qMin<qint64>(rows, std::numeric_limits<int>::max())),
+                                            QString("%1 rows written").arg(rows));
+            return !promise.isCanceled();
+        }, token);
+
+        promise.addResult(stats);
+    });
+}
@@ -0,0 +1,75 @@
+#ifndef RESULTEXPORTER_H
+#define RESULTEXPORTER_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QString>
+#include <functional>
+#include "database.h"
+
+enum class ResultExportFormat {
+    Csv,        // Model,Node Number,Calculation Type,Value,Unit; значения и единицы в СИ
+    Binary      // колоночные блоки, см. ResultExporter::formatBinaryChunk
+};
+
+struct ResultExportStats {
+    QueryOutcome outcome;       // итог чтения из базы
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    qint64 elapsedMs = 0;
+    QString error;              // ошибка записи файла
+
+    bool ok() const { return error.isEmpty() && outcome.isComplete(); }
+};
+
+// Потоковый экспорт результатов по фильтру. Строки читаются из курсора порциями,
+// каждая порция форматируется в пуле потоков, готовые порции пишутся в файл
+// строго по порядку. В памяти одновременно не больше нескольких порций на поток.
+// Файл пишется через QSaveFile: при отмене или ошибке прежний файл не портится.
+class ResultExporter
+{
+public:
+    explicit ResultExporter(Database *database);
+
+    void setChunkRows(int rows) { chunkRows = qMax(1, rows); }
+
+    // *.bdr - двоичный формат, остальное - CSV
+    static ResultExportFormat formatForFile(const QString &fileName);
+
+    // progress(записано строк, всего строк) вызывается после подсчета строк и после каждой
+    // порции; false - отмена. token прерывает и подсчет, и чтение (ошибка записи тоже его отменяет)
+    ResultExportStats run(const ResultFilter &filter, const QString &fileName, ResultExportFormat format,
+                          const std::function<bool(qint64, qint64)> &progress = {},
+                          const CancellationToken &token = CancellationToken());
+
+    // Экспорт в фоне через отдельное соединение с базой. Прогресс - в строках,
+    // cancel() у QFuture или token прерывает запрос и оставляет прежний файл
+    // (token - и посреди подсчета строк или первой порции)
+    static QFuture<ResultExportStats> runInBackground(const QString &databaseName,
+                                                      const ResultFilter &filter,
+                                                      const QString &fileName,
+                                                      ResultExportFormat format,
+                                                      const CancellationToken &token = CancellationToken());
+
+    static QByteArray csvHeader();
+    // units - единица СИ по названию вида расчета (Database::getAllCalculationTypes)
+    static QByteArray formatCsvChunk(const ResultBlock &block, const QHash<QString, QString> &units);
+
+    // Двоичный формат (little-endian):
+    //   "BDRB", quint32 версия (1)
+    //   порции: quint32 строк (> 0),
+    //           словари моделей и видов расчетов: quint32 число, затем quint32 длина + UTF-8,
+    //           quint32[строк] индексы моделей, quint32[строк] индексы видов расчетов,
+    //           quint32 длина + UTF-8 номера узлов подряд, quint32[строк] концы номеров,
+    //           double[строк] значения в СИ
+    //   конец: quint32 0, quint64 всего строк
+    static QByteArray binaryHeader();
+    static QByteArray formatBinaryChunk(const ResultBlock &block);
+    static QByteArray binaryFooter(qint64 rows);
+
+private:
+    Database *db;
+    int chunkRows = 16384;
+};
+
+#endif // RESULTEXPORTER_H
@@ -0,0 +1,450 @@
+#include "resultsnapshot.h"
+#include "database.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char HeaderMagic[8] = {'B', 'D', 'S', 'N', 'A', 'P', '\0', '\0'};
+const char TrailerMagic[8] = {'B', 'D', 'S', 'N', 'E', 'N', 'D', '\0'};
+const qint64 HeaderSize = 32;
+const qint64 TrailerSize = 24;
+
+void writeString(QDataStream &stream, const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    stream << quint32(utf8.size());
+    stream.writeRawData(utf8.constData(), int(utf8.size()));
+}
+
+bool readString(QDataStream &stream, QString &text)
+{
+    quint32 length = 0;
+    stream >> length;
+    if (stream.status() != QDataStream::Ok || length > (1u << 20)) {
+        return false;
+    }
+    QByteArray utf8(int(length), Qt::Uninitialized);
+    if (stream.readRawData(utf8.data(), int(length)) != int(length)) {
+        return false;
+    }
+    text = QString::fromUtf8(utf8);
+    return true;
+}
+
+// Массивы пишутся как есть и читаются из отображения без преобразования
+void align(QDataStream &stream, QIODevice &device)
+{
+    while (device.pos() % 8 != 0) {
+        stream << quint8(0);
+    }
+}
+
+void writeArray(QDataStream &stream, const void *data, qint64 bytes)
+{
+    const char *begin = static_cast<const char *>(data);
+    // writeRawData принимает int - большие столбцы пишутся частями
+    while (bytes > 0) {
+        int part = int(qMin<qint64>(bytes, 1 << 30));
+        stream.writeRawData(begin, part);
+        begin += part;
+        bytes -= part;
+    }
+}
+
+}
+
+ResultSnapshot::~ResultSnapshot()
+{
+    close();
+}
+
+bool ResultSnapshot::write(Database *db, const QString &fileName, QString *error,
+                           const CancellationToken &token)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        qDebug() << "Snapshot:" << message;
+        return false;
+    };
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    return fail("Snapshots are supported on little-endian hosts only");
+#endif
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail("Cannot open file for writing: " + fileName);
+    }
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+    stream.writeRawData(HeaderMagic, 8);
+    stream << FormatVersion << quint32(0) << qint64(QDateTime::currentMSecsSinceEpoch()) << quint64(0);
+
+    // Словари: индексы моделей и видов расчетов в порядке появления
+    QStringList models;
+    QStringList types;
+    QHash<QString, QString> siUnits;
+    for (const auto &type : db->getAllCalculationTypes()) {
+        siUnits.insert(type.first, type.second);
+    }
+    const QHash<QString, QString> displayUnits = db->getCalculationTypeDisplayUnits();
+
+    QVector<SetEntry> entries;
+    QVector<QPair<int, int>> entryIds;
+
+    for (const auto &resultSet : db->getResultSets()) {
+        ResultFilter filter;
+        filter.modelName = resultSet.first;
+        filter.calculationType = resultSet.second;
+
+        ResultBlock block;
+        QueryOutcome outcome = db->queryResultBlock(filter, block, token);
+        if (outcome.isCancelled()) {
+            file.cancelWriting();
+            return fail("Cancelled");
+        }
+        if (!outcome.isComplete()) {
+            file.cancelWriting();
+            return fail("Cannot read results: " + outcome.error);
+        }
+
+        const int rows = block.size();
+        SetEntry entry;
+        entry.info.modelName = resultSet.first;
+        entry.info.calculationType = resultSet.second;
+        entry.info.rows = rows;
+
+        // Целые номера узлов храним числами и сортируем - тогда узел ищется двоичным поиском.
+        // Номер должен восстанавливаться из числа без изменений: "007" или "+5" остаются текстом
+        QVector<qint64> ids(rows);
+        bool numeric = rows > 0;
+        for (int i = 0; i < rows && numeric; ++i) {
+            const QString node = block.nodeNumber(i);
+            ids[i] = node.toLongLong(&numeric);
+            numeric = numeric && QString::number(ids[i]) == node;
+        }
+        entry.info.numericNodes = numeric;
+
+        QVector<int> order(rows);
+        for (int i = 0; i < rows; ++i) {
+            order[i] = i;
+        }
+        if (numeric) {
+            std::sort(order.begin(), order.end(), [&ids](int a, int b) { return ids[a] < ids[b]; });
+        }
+
+        QVector<double> values(rows);
+        double sum = 0.0;
+        for (int i = 0; i < rows; ++i) {
+            values[i] = block.value(order[i]);
+            sum += values[i];
+        }
+        if (rows > 0) {
+            auto range = std::minmax_element(values.constBegin(), values.constEnd());
+            entry.info.minimum = *range.first;
+            entry.info.maximum = *range.second;
+            entry.info.mean = sum / rows;
+        }
+
+        align(stream, file);
+        entry.nodeOffset = quint64(file.pos());
+        if (numeric) {
+            QVector<qint64> sortedIds(rows);
+            for (int i = 0; i < rows; ++i) {
+                sortedIds[i] = ids[order[i]];
+            }
+            writeArray(stream, sortedIds.constData(), qint64(rows) * sizeof(qint64));
+        } else {
+            QByteArray text;
+            QVector<quint64> offsets;
+            offsets.reserve(rows + 1);
+            offsets.append(0);
+            for (int i = 0; i < rows; ++i) {
+                text += block.nodeNumber(i).toUtf8();
+                offsets.append(quint64(text.size()));
+            }
+            writeArray(stream, offsets.constData(), qint64(offsets.size()) * sizeof(quint64));
+            entry.nodeTextOffset = quint64(file.pos());
+            writeArray(stream, text.constData(), text.size());
+        }
+
+        align(stream, file);
+        entry.valueOffset = quint64(file.pos());
+        writeArray(stream, values.constData(), qint64(rows) * sizeof(double));
+
+        if (!models.contains(entry.info.modelName)) {
+            models.append(entry.info.modelName);
+        }
+        if (!types.contains(entry.info.calculationType)) {
+            types.append(entry.info.calculationType);
+        }
+        entries.append(entry);
+        entryIds.append(qMakePair(models.indexOf(entry.info.modelName),
+                                  types.indexOf(entry.info.calculationType)));
+
+        if (stream.status() != QDataStream::Ok) {
+            file.cancelWriting();
+            return fail("Write failed: " + file.errorString());
+        }
+    }
+
+    // Оглавление
+    align(stream, file);
+    const quint64 footerOffset = quint64(file.pos());
+
+    stream << quint32(models.size());
+    for (const QString &model : models) {
+        writeString(stream, model);
+    }
+    stream << quint32(types.size());
+    for (const QString &type : types) {
+        const QString siUnit = siUnits.value(type);
+        writeString(stream, type);
+        writeString(stream, siUnit);
+        writeString(stream, displayUnits.value(type, siUnit));
+    }
+
+    stream << quint32(entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        const SetEntry &entry = entries[i];
+        stream << quint32(entryIds[i].first) << quint32(entryIds[i].second)
+               << qint64(entry.info.rows)
+               << quint32(entry.info.numericNodes ? 1 : 0) << quint32(0)
+               << entry.nodeOffset << entry.nodeTextOffset << entry.valueOffset
+               << entry.info.minimum << entry.info.maximum << entry.info.mean;
+    }
+
+    const quint64 footerSize = quint64(file.pos()) - footerOffset;
+    stream << footerOffset << footerSize;
+    stream.writeRawData(TrailerMagic, 8);
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        return fail("Cannot save snapshot: " + file.errorString());
+    }
+    return true;
+}
+
+bool ResultSnapshot::fail(const QString &message)
+{
+    // message может ссылаться на error, который close() очищает
+    const QString text = message;
+    close();
+    error = text;
+    qDebug() << "Snapshot:" << text;
+    return false;
+}
+
+bool ResultSnapshot::open(const QString &fileName)
+{
+    close();
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    return fail("Snapshots are supported on little-endian hosts only");
+#endif
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail("Cannot open snapshot: " + file.errorString());
+    }
+
+    size = file.size();
+    if (size < HeaderSize + TrailerSize) {
+        return fail("Not a snapshot file");
+    }
+
+    // Отображение файла целиком: страницы читаются с диска только при обращении
+    base = file.map(0, size);
+    if (!base) {
+        return fail("Cannot map snapshot: " + file.errorString());
+    }
+
+    quint32 version = 0;
+    std::memcpy(&version, base + 8, sizeof(version));
+    if (std::memcmp(base, HeaderMagic, 8) != 0
+        || std::memcmp(base + size - 8, TrailerMagic, 8) != 0) {
+        return fail("Not a snapshot file");
+    }
+    if (version != FormatVersion) {
+        return fail(QString("Unsupported snapshot version %1").arg(version));
+    }
+
+    quint64 footerOffset = 0;
+    quint64 footerSize = 0;
+    std::memcpy(&footerOffset, base + size - TrailerSize, sizeof(footerOffset));
+    std::memcpy(&footerSize, base + size - TrailerSize + 8, sizeof(footerSize));
+    if (footerOffset < quint64(HeaderSize) || footerSize > quint64(size - TrailerSize)
+        || footerOffset + footerSize != quint64(size - TrailerSize)) {
+        return fail("Corrupted snapshot footer");
+    }
+
+    return readFooter(footerOffset, footerSize) || fail(error);
+}
+
+bool ResultSnapshot::readFooter(quint64 offset, quint64 footerSize)
+{
+    // Оглавление читается без копирования файла; его размер не зависит от числа строк
+    const QByteArray footer = QByteArray::fromRawData(reinterpret_cast<const char *>(base + offset),
+                                                      qsizetype(footerSize));
+    QDataStream stream(footer);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+    quint32 modelCount = 0;
+    stream >> modelCount;
+    QStringList models;
+    for (quint32 i = 0; i < modelCount; ++i) {
+        QString model;
+        if (!readString(stream, model)) {
+            error = "Corrupted snapshot dictionary";
+            return false;
+        }
+        models.append(model);
+    }
+
+    quint32 typeCount = 0;
+    stream >> typeCount;
+    QStringList types;
+    QStringList siUnits;
+    QStringList displayUnits;
+    for (quint32 i = 0; i < typeCount; ++i) {
+        QString type;
+        QString siUnit;
+        QString displayUnit;
+        if (!readString(stream, type) || !readString(stream, siUnit) || !readString(stream, displayUnit)) {
+            error = "Corrupted snapshot dictionary";
+            return false;
+        }
+        types.append(type);
+        siUnits.append(siUnit);
+        displayUnits.append(displayUnit);
+    }
+
+    quint32 setCount = 0;
+    stream >> setCount;
+    for (quint32 i = 0; i < setCount; ++i) {
+        quint32 modelId = 0;
+        quint32 typeId = 0;
+        qint64 rows = 0;
+        quint32 numeric = 0;
+        quint32 reserved = 0;
+        SetEntry entry;
+        stream >> modelId >> typeId >> rows >> numeric >> reserved
+               >> entry.nodeOffset >> entry.nodeTextOffset >> entry.valueOffset
+               >> entry.info.minimum >> entry.info.maximum >> entry.info.mean;
+
+        if (stream.status() != QDataStream::Ok || modelId >= quint32(models.size())
+            || typeId >= quint32(types.size()) || rows < 0) {
+            error = "Corrupted snapshot index";
+            return false;
+        }
+
+        // Столбцы должны лежать в области данных и быть выровнены
+        // (сравнения без переполнения: значения из файла могут быть любыми)
+        const quint64 dataEnd = offset;
+        auto fits = [dataEnd](quint64 start, quint64 words) {
+            return start <= dataEnd && words <= (dataEnd - start) / 8;
+        };
+        if (entry.valueOffset % 8 != 0 || entry.nodeOffset % 8 != 0
+            || !fits(entry.valueOffset, quint64(rows))
+            || !fits(entry.nodeOffset, quint64(rows) + (numeric ? 0 : 1))) {
+            error = "Corrupted snapshot index";
+            return false;
+        }
+        if (!numeric) {
+            // nodeNumber() читает текст по смещениям без проверок - проверяем их все при открытии:
+            // с нуля, не убывают, последнее - в пределах области данных
+            const quint64 *offsets = reinterpret_cast<const quint64 *>(base + entry.nodeOffset);
+            bool valid = offsets[0] == 0 && entry.nodeTextOffset <= dataEnd
+                         && offsets[rows] <= dataEnd - entry.nodeTextOffset;
+            for (qint64 row = 0; row < rows && valid; ++row) {
+                valid = offsets[row] <= offsets[row + 1];
+            }
+            if (!valid) {
+                error = "Corrupted snapshot index";
+                return false;
+            }
+        }
+
+        entry.info.modelName = models[modelId];
+        entry.info.calculationType = types[typeId];
+        entry.info.siUnit = siUnits[typeId];
+        entry.info.displayUnit = displayUnits[typeId];
+        entry.info.rows = rows;
+        entry.info.numericNodes = numeric != 0;
+        sets.append(entry);
+    }
+
+    return true;
+}
+
+void ResultSnapshot::close()
+{
+    if (base) {
+        file.unmap(base);
+        base = nullptr;
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    size = 0;
+    sets.clear();
+    error.clear();
+}
+
+int ResultSnapshot::findResultSet(const QString &modelName, const QString &calculationType) const
+{
+    for (int i = 0; i < sets.size(); ++i) {
+        if (sets[i].info.modelName == modelName && sets[i].info.calculationType == calculationType) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const double *ResultSnapshot::values(int set) const
+{
+    return reinterpret_cast<const double *>(base + sets[set].valueOffset);
+}
+
+qint64 ResultSnapshot::nodeId(int set, qint64 row) const
+{
+    const SetEntry &entry = sets[set];
+    if (!entry.info.numericNodes) {
+        return -1;
+    }
+    return reinterpret_cast<const qint64 *>(base + entry.nodeOffset)[row];
+}
+
+QString ResultSnapshot::nodeNumber(int set, qint64 row) const
+{
+    const SetEntry &entry = sets[set];
+    if (entry.info.numericNodes) {
+        return QString::number(nodeId(set, row));
+    }
+
+    const quint64 *offsets = reinterpret_cast<const quint64 *>(base + entry.nodeOffset);
+    const char *text = reinterpret_cast<const char *>(base + entry.nodeTextOffset);
+    return QString::fromUtf8(text + offsets[row], qsizetype(offsets[row + 1] - offsets[row]));
+}
+
+qint64 ResultSnapshot::findNode(int set, qint64 id) const
+{
+    const SetEntry &entry = sets[set];
+    if (!entry.info.numericNodes) {
+        return -1;
+    }
+
+    const qint64 *ids = reinterpret_cast<const qint64 *>(base + entry.nodeOffset);
+    const qint64 *end = ids + entry.info.rows;
+    const qint64 *it = std::lower_bound(ids, end, id);
+    return it != end && *it == id ? qint64(it - ids) : -1;
+}
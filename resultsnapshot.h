@@ -0,0 +1,85 @@
+#ifndef RESULTSNAPSHOT_H
+#define RESULTSNAPSHOT_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "cancellationtoken.h"
+
+class Database;
+
+// Описание одного набора результатов (модель, вид расчета) в снимке
+struct SnapshotResultSet {
+    QString modelName;
+    QString calculationType;
+    QString siUnit;
+    QString displayUnit;
+    qint64 rows = 0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    double mean = 0.0;
+    bool numericNodes = false;      // номера узлов - целые, строки отсортированы по номеру
+};
+
+// Снимок результатов для просмотра без базы. Файл открывается через отображение в память:
+// при открытии читается только оглавление в конце файла, столбцы узлов и значений
+// читаются прямо из отображения, страницы подгружаются по мере обращения.
+//
+// Формат (little-endian, массивы выровнены на 8 байт):
+//   заголовок:  char[8] "BDSNAP\0\0", quint32 версия (1), quint32 флаги, qint64 время записи (мс), 8 байт резерв
+//   данные:     для каждого набора - столбец узлов, затем double[rows] значения в СИ.
+//               Целые номера: qint64[rows]; иначе quint64[rows + 1] смещения и UTF-8 текст
+//   оглавление: словари моделей и видов расчетов (с единицами), затем записи наборов
+//               (индексы в словарях, число строк, кодировка узлов, смещения столбцов, min/max/mean)
+//   окончание:  quint64 смещение оглавления, quint64 размер оглавления, char[8] "BDSNEND\0"
+class ResultSnapshot
+{
+public:
+    static constexpr quint32 FormatVersion = 1;
+
+    ResultSnapshot() = default;
+    ~ResultSnapshot();
+
+    // Снимок всех результатов базы. Наборы читаются по одному, в памяти - один набор
+    static bool write(Database *db, const QString &fileName, QString *error = nullptr,
+                      const CancellationToken &token = CancellationToken());
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+    QString errorString() const { return error; }
+    QString fileName() const { return file.fileName(); }
+
+    int resultSetCount() const { return sets.size(); }
+    const SnapshotResultSet &resultSet(int set) const { return sets[set].info; }
+    int findResultSet(const QString &modelName, const QString &calculationType) const;
+
+    // Указатель внутрь отображения: действителен, пока снимок открыт
+    const double *values(int set) const;
+    double value(int set, qint64 row) const { return values(set)[row]; }
+
+    QString nodeNumber(int set, qint64 row) const;
+    // Только для целых номеров: номер узла и поиск строки по номеру (-1 - нет)
+    qint64 nodeId(int set, qint64 row) const;
+    qint64 findNode(int set, qint64 nodeId) const;
+
+private:
+    struct SetEntry {
+        SnapshotResultSet info;
+        quint64 nodeOffset = 0;         // qint64[rows] или quint64[rows + 1]
+        quint64 nodeTextOffset = 0;     // UTF-8 текст номеров (для нецелых)
+        quint64 valueOffset = 0;
+    };
+
+    bool fail(const QString &message);
+    bool readFooter(quint64 offset, quint64 size);
+
+    QFile file;
+    uchar *base = nullptr;
+    qint64 size = 0;
+    QString error;
+    QVector<SetEntry> sets;
+};
+
+#endif // RESULTSNAPSHOT_H
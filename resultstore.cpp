@@ -0,0 +1,711 @@
+#include "resultstore.h"
+#include "memorybudget.h"
+#include "metrics.h"
+#include "tracer.h"
+#include <QMap>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+std::atomic<int> connectionCounter{0};
+
+struct LoadedSet {
+    std::shared_ptr<ResultColumns> columns;
+    QString error;
+};
+
+bool hasBounds(const ResultFilter &filter)
+{
+    return std::isfinite(filter.minimum) || std::isfinite(filter.maximum);
+}
+
+bool inRange(const ResultFilter &filter, double value)
+{
+    return value >= filter.minimum && value <= filter.maximum;
+}
+
+bool matches(const ResultFilter &filter, const QPair<QString, QString> &resultSet)
+{
+    return (filter.modelName.isEmpty() || filter.modelName == resultSet.first)
+           && (filter.calculationType.isEmpty() || filter.calculationType == resultSet.second);
+}
+
+// Порядок узлов: numeric - по значению (оба набора целые), иначе - как строки, как в SQLite
+bool nodeLess(const ResultColumns &a, int rowA, const ResultColumns &b, int rowB, bool numeric)
+{
+    if (numeric) {
+        return a.nodeIds[rowA] < b.nodeIds[rowB];
+    }
+    return a.nodeNumber(rowA) < b.nodeNumber(rowB);
+}
+
+// Строки целого набора в строковом порядке номеров - для слияния с текстовыми наборами
+void sortRowsAsText(const ResultColumns &columns, QVector<int> &rows)
+{
+    QStringList texts;
+    texts.reserve(columns.size());
+    for (int i = 0; i < columns.size(); ++i) {
+        texts.append(columns.nodeNumber(i));
+    }
+    std::stable_sort(rows.begin(), rows.end(), [&texts](int a, int b) { return texts[a] < texts[b]; });
+}
+
+// Строки набора, прошедшие фильтр по значению (все строки - если границ нет)
+QVector<int> filterRows(const ResultColumns &columns, const ResultFilter &filter)
+{
+    QVector<int> rows;
+    rows.reserve(columns.size());
+    for (int i = 0; i < columns.size(); ++i) {
+        if (inRange(filter, columns.values[i])) {
+            rows.append(i);
+        }
+    }
+    return rows;
+}
+
+}
+
+QString ResultColumns::nodeNumber(int row) const
+{
+    return numericNodes ? QString::number(nodeIds[row]) : nodeTexts[row];
+}
+
+qint64 ResultColumns::countMemoryBytes() const
+{
+    qint64 bytes = sizeof(ResultColumns);
+    bytes += nodeIds.capacity() * qint64(sizeof(qint64));
+    bytes += values.capacity() * qint64(sizeof(double));
+    for (const QString &node : nodeTexts) {
+        bytes += sizeof(QString) + node.capacity() * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
+
+ResultStore::ResultStore(const QString &databaseName)
+    : databaseName(databaseName)
+{
+}
+
+void ResultStore::setDatabaseName(const QString &name)
+{
+    QMutexLocker locker(&mutex);
+    if (databaseName != name) {
+        databaseName = name;
+        sets.clear();
+        lastUse.clear();
+        loadedBytes.store(0, std::memory_order_relaxed);
+        catalogValid = false;
+        version++;
+    }
+}
+
+QString ResultStore::modelName(int modelId) const
+{
+    QMutexLocker locker(&mutex);
+    return models.value(modelId);
+}
+
+QString ResultStore::typeName(int typeId) const
+{
+    QMutexLocker locker(&mutex);
+    return types.value(typeId);
+}
+
+int ResultStore::internModel(const QString &name)
+{
+    auto it = modelIds.constFind(name);
+    if (it != modelIds.constEnd()) {
+        return it.value();
+    }
+    models.append(name);
+    modelIds.insert(name, models.size() - 1);
+    return models.size() - 1;
+}
+
+int ResultStore::internType(const QString &name)
+{
+    auto it = typeIds.constFind(name);
+    if (it != typeIds.constEnd()) {
+        return it.value();
+    }
+    types.append(name);
+    typeIds.insert(name, types.size() - 1);
+    return types.size() - 1;
+}
+
+ResultStore::SetPointer ResultStore::loadSet(const QString &model, const QString &calculationType,
+                                             QString &error, const CancellationToken &token)
+{
+    BD_TRACE_SCOPE("store", "ResultStore::loadSet");
+    BD_METRIC_LATENCY("ResultStore::loadSet");
+    QString database;
+    {
+        QMutexLocker locker(&mutex);
+        database = databaseName;
+    }
+
+    // Соединение только на время загрузки и только в этом потоке
+    Database reader(QString("result_store_%1").arg(++connectionCounter));
+    if (!reader.openConnection(database)) {
+        error = "Cannot open database: " + database;
+        return nullptr;
+    }
+
+    ResultFilter filter;
+    filter.modelName = model;
+    filter.calculationType = calculationType;
+
+    ResultBlock block;
+    QueryOutcome outcome = reader.queryResultBlock(filter, block, token);
+    if (!outcome.isComplete()) {
+        error = outcome.isCancelled() ? QString("Cancelled") : outcome.error;
+        return nullptr;
+    }
+
+    const int rows = block.size();
+    auto columns = std::make_shared<ResultColumns>();
+
+    // Целыми считаются только номера, которые восстанавливаются из числа без изменений ("007" - текст)
+    QVector<qint64> ids(rows);
+    for (int i = 0; i < rows && columns->numericNodes; ++i) {
+        const QString node = block.nodeNumber(i);
+        ids[i] = node.toLongLong(&columns->numericNodes);
+        columns->numericNodes = columns->numericNodes && QString::number(ids[i]) == node;
+    }
+
+    // Строки упорядочиваются по узлу: слияние и соединение наборов идут одним проходом
+    QVector<int> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    if (columns->numericNodes) {
+        std::sort(order.begin(), order.end(), [&ids](int a, int b) { return ids[a] < ids[b]; });
+        columns->nodeIds.resize(rows);
+        for (int i = 0; i < rows; ++i) {
+            columns->nodeIds[i] = ids[order[i]];
+        }
+    } else {
+        std::sort(order.begin(), order.end(), [&block](int a, int b) {
+            return block.nodeNumber(a) < block.nodeNumber(b);
+        });
+        columns->nodeTexts.reserve(rows);
+        for (int i = 0; i < rows; ++i) {
+            columns->nodeTexts.append(block.nodeNumber(order[i]));
+        }
+    }
+
+    columns->values.resize(rows);
+    for (int i = 0; i < rows; ++i) {
+        columns->values[i] = block.value(order[i]);
+        columns->sum += columns->values[i];
+    }
+    if (rows > 0) {
+        auto range = std::minmax_element(columns->values.constBegin(), columns->values.constEnd());
+        columns->minimum = *range.first;
+        columns->maximum = *range.second;
+    }
+
+    // Набор больше не меняется - объем считается один раз
+    columns->bytes = columns->countMemoryBytes();
+    return columns;
+}
+
+bool ResultStore::ensureLoaded(const ResultFilter &filter, QVector<SetPointer> &result, QString &error,
+                               const CancellationToken &token)
+{
+    QString database;
+    bool needCatalog = false;
+    quint64 catalogVersion = 0;
+    QList<QPair<QString, QString>> resultSets;
+    {
+        QMutexLocker locker(&mutex);
+        database = databaseName;
+        needCatalog = !catalogValid;
+        catalogVersion = version;
+        resultSets = catalog;
+    }
+
+    if (needCatalog) {
+        Database reader(QString("result_store_%1").arg(++connectionCounter));
+        if (!reader.openConnection(database)) {
+            error = "Cannot open database: " + database;
+            return false;
+        }
+        resultSets = reader.getResultSets();
+
+        // invalidate() во время чтения: список мог устареть, следующий запрос перечитает его
+        QMutexLocker locker(&mutex);
+        if (catalogVersion == version) {
+            catalog = resultSets;
+            catalogValid = true;
+        }
+    }
+
+    QList<QPair<QString, QString>> missing;
+    QVector<int> missingPositions;
+    quint64 loadVersion = 0;
+    result.clear();
+    {
+        QMutexLocker locker(&mutex);
+        loadVersion = version;
+        for (const auto &resultSet : resultSets) {
+            if (!matches(filter, resultSet)) {
+                continue;
+            }
+            QPair<int, int> key(internModel(resultSet.first), internType(resultSet.second));
+            SetPointer set = sets.value(key);
+            lastUse.insert(key, ++useCounter);
+            if (!set) {
+                missing.append(resultSet);
+                missingPositions.append(result.size());
+            }
+            result.append(set);
+        }
+    }
+
+    if (missing.isEmpty()) {
+        return true;
+    }
+
+    // Холодная загрузка: наборы читаются параллельно, каждый своим соединением
+    const QList<LoadedSet> loaded = QtConcurrent::blockingMapped<QList<LoadedSet>>(missing,
+        [this, &token](const QPair<QString, QString> &resultSet) {
+            LoadedSet set;
+            QString loadError;
+            SetPointer columns = loadSet(resultSet.first, resultSet.second, loadError, token);
+            set.columns = std::const_pointer_cast<ResultColumns>(columns);
+            set.error = loadError;
+            return set;
+        });
+
+    {
+        QMutexLocker locker(&mutex);
+        for (int i = 0; i < loaded.size(); ++i) {
+            if (!loaded[i].columns) {
+                error = missing[i].first + " / " + missing[i].second + ": " + loaded[i].error;
+                return false;
+            }
+
+            std::shared_ptr<ResultColumns> columns = loaded[i].columns;
+            columns->modelId = internModel(missing[i].first);
+            columns->typeId = internType(missing[i].second);
+
+            SetPointer set = columns;
+            result[missingPositions[i]] = set;
+
+            // Если пока шла загрузка базу изменили, набор годится только для этого запроса
+            if (loadVersion == version) {
+                const QPair<int, int> key(set->modelId, set->typeId);
+                const SetPointer previous = sets.value(key);
+                loadedBytes.fetch_add(set->memoryBytes() - (previous ? previous->memoryBytes() : 0),
+                                      std::memory_order_relaxed);
+                sets.insert(key, set);
+            }
+        }
+    }
+
+    // Вне блокировки: бюджет может выгрузить наборы через trim()
+    MemoryBudget::instance().enforce();
+    return true;
+}
+
+QueryOutcome ResultStore::select(const ResultFilter &filter, ResultBlock &block,
+                                 const CancellationToken &token)
+{
+    BD_TRACE_SCOPE("store", "ResultStore::select");
+    BD_METRIC_LATENCY("ResultStore::select");
+    block = ResultBlock();
+    QueryOutcome outcome;
+
+    QVector<SetPointer> loaded;
+    if (!ensureLoaded(filter, loaded, outcome.error, token)) {
+        outcome.status = token.isCancelled() ? QueryStatus::Cancelled : QueryStatus::Failed;
+        return outcome;
+    }
+
+    // Фильтр по значению - параллельно по наборам
+    const bool bounded = hasBounds(filter);
+    QList<QVector<int>> rows;
+    QVector<bool> listed(loaded.size(), bounded);     // строки набора заданы списком rows
+    if (bounded) {
+        rows = QtConcurrent::blockingMapped<QList<QVector<int>>>(loaded,
+            [filter](const SetPointer &set) { return filterRows(*set, filter); });
+    } else {
+        rows.resize(loaded.size());
+    }
+
+    auto rowCount = [&](int set) { return listed[set] ? rows[set].size() : loaded[set]->size(); };
+    auto rowAt = [&](int set, int position) { return listed[set] ? rows[set][position] : position; };
+
+    qint64 total = 0;
+    for (int i = 0; i < loaded.size(); ++i) {
+        total += rowCount(i);
+    }
+    block.reserve(int(filter.limit >= 0 ? qMin(total, filter.limit) : total));
+
+    // Наборы идут по (модель, вид расчета): внутри модели сливаем по узлу
+    qint64 appended = 0;
+    int groupBegin = 0;
+    while (groupBegin < loaded.size()) {
+        int groupEnd = groupBegin;
+        while (groupEnd < loaded.size() && loaded[groupEnd]->modelId == loaded[groupBegin]->modelId) {
+            groupEnd++;
+        }
+
+        const QString model = modelName(loaded[groupBegin]->modelId);
+        QVector<QString> groupTypes;
+        bool numeric = true;
+        for (int i = groupBegin; i < groupEnd; ++i) {
+            groupTypes.append(typeName(loaded[i]->typeId));
+            numeric = numeric && loaded[i]->numericNodes;
+        }
+
+        // Есть текстовые номера - вся модель идет в строковом порядке, целые наборы пересортировываются
+        if (!numeric) {
+            for (int i = groupBegin; i < groupEnd; ++i) {
+                if (!loaded[i]->numericNodes) {
+                    continue;
+                }
+                if (!listed[i]) {
+                    rows[i].resize(loaded[i]->size());
+                    std::iota(rows[i].begin(), rows[i].end(), 0);
+                    listed[i] = true;
+                }
+                sortRowsAsText(*loaded[i], rows[i]);
+            }
+        }
+
+        QVector<int> positions(groupEnd - groupBegin, 0);
+        forever {
+            int next = -1;
+            for (int i = groupBegin; i < groupEnd; ++i) {
+                int position = positions[i - groupBegin];
+                if (position >= rowCount(i)) {
+                    continue;
+                }
+                if (next < 0 || nodeLess(*loaded[i], rowAt(i, position), *loaded[next],
+                                         rowAt(next, positions[next - groupBegin]), numeric)) {
+                    next = i;
+                }
+            }
+            if (next < 0) {
+                break;
+            }
+
+            if (filter.limit >= 0 && appended >= filter.limit) {
+                outcome.status = QueryStatus::Partial;
+                outcome.rows = appended;
+                block.squeeze();
+                return outcome;
+            }
+            if ((appended & 4095) == 0 && token.isCancelled()) {
+                outcome.status = QueryStatus::Cancelled;
+                outcome.rows = appended;
+                return outcome;
+            }
+
+            int row = rowAt(next, positions[next - groupBegin]++);
+            const ResultColumns &set = *loaded[next];
+            block.append(model, set.nodeNumber(row), groupTypes[next - groupBegin], set.values[row]);
+            appended++;
+        }
+
+        groupBegin = groupEnd;
+    }
+
+    block.squeeze();
+    outcome.rows = appended;
+    return outcome;
+}
+
+QueryOutcome ResultStore::summarize(const ResultFilter &filter, QList<ResultSummary> &summaries,
+                                    const CancellationToken &token)
+{
+    summaries.clear();
+    QueryOutcome outcome;
+
+    QVector<SetPointer> loaded;
+    if (!ensureLoaded(filter, loaded, outcome.error, token)) {
+        outcome.status = token.isCancelled() ? QueryStatus::Cancelled : QueryStatus::Failed;
+        return outcome;
+    }
+
+    struct Partial {
+        int typeId = -1;
+        qint64 count = 0;
+        double minimum = 0.0;
+        double maximum = 0.0;
+        double sum = 0.0;
+    };
+
+    // Без границ по значению агрегаты набора уже посчитаны при загрузке
+    const bool bounded = hasBounds(filter);
+    const QList<Partial> partials = QtConcurrent::blockingMapped<QList<Partial>>(loaded,
+        [filter, bounded](const SetPointer &set) {
+            Partial partial;
+            partial.typeId = set->typeId;
+            if (!bounded) {
+                partial.count = set->size();
+                partial.minimum = set->minimum;
+                partial.maximum = set->maximum;
+                partial.sum = set->sum;
+                return partial;
+            }
+            for (double value : set->values) {
+                if (!inRange(filter, value)) {
+                    continue;
+                }
+                partial.minimum = partial.count == 0 ? value : qMin(partial.minimum, value);
+                partial.maximum = partial.count == 0 ? value : qMax(partial.maximum, value);
+                partial.sum += value;
+                partial.count++;
+            }
+            return partial;
+        });
+
+    if (token.isCancelled()) {
+        outcome.status = QueryStatus::Cancelled;
+        return outcome;
+    }
+
+    QMap<QString, ResultSummary> byType;
+    QMap<QString, double> sums;
+    for (const Partial &partial : partials) {
+        if (partial.count == 0) {
+            continue;
+        }
+        const QString type = typeName(partial.typeId);
+        ResultSummary &summary = byType[type];
+        if (summary.count == 0) {
+            summary.calculationType = type;
+            summary.minimum = partial.minimum;
+            summary.maximum = partial.maximum;
+        } else {
+            summary.minimum = qMin(summary.minimum, partial.minimum);
+            summary.maximum = qMax(summary.maximum, partial.maximum);
+        }
+        summary.count += partial.count;
+        sums[type] += partial.sum;
+    }
+
+    for (auto it = byType.begin(); it != byType.end(); ++it) {
+        it->mean = sums.value(it.key()) / it->count;
+        summaries.append(it.value());
+    }
+    outcome.rows = summaries.size();
+    return outcome;
+}
+
+QueryOutcome ResultStore::top(const ResultFilter &filter, int count, bool descending, ResultBlock &block,
+                              const CancellationToken &token)
+{
+    block = ResultBlock();
+    QueryOutcome outcome;
+
+    QVector<SetPointer> loaded;
+    if (!ensureLoaded(filter, loaded, outcome.error, token)) {
+        outcome.status = token.isCancelled() ? QueryStatus::Cancelled : QueryStatus::Failed;
+        return outcome;
+    }
+
+    struct Candidate {
+        double value;
+        int set;
+        int row;
+    };
+    auto before = [descending](const Candidate &a, const Candidate &b) {
+        return descending ? a.value > b.value : a.value < b.value;
+    };
+
+    // Куча из limit лучших: на вершине худший из оставленных, он и вытесняется.
+    // Держим count + 1 строк - для признака Partial нужен факт, что строк было больше
+    const int limit = qMax(0, count) + 1;
+    auto offer = [limit, before](QVector<Candidate> &heap, const Candidate &candidate) {
+        if (heap.size() < limit) {
+            heap.append(candidate);
+            std::push_heap(heap.begin(), heap.end(), before);
+        } else if (before(candidate, heap.first())) {
+            std::pop_heap(heap.begin(), heap.end(), before);
+            heap.last() = candidate;
+            std::push_heap(heap.begin(), heap.end(), before);
+        }
+    };
+
+    // Лучшие строки каждого набора - параллельно, затем общий отбор
+    QVector<int> setIndexes(loaded.size());
+    std::iota(setIndexes.begin(), setIndexes.end(), 0);
+    const QList<QVector<Candidate>> perSet = QtConcurrent::blockingMapped<QList<QVector<Candidate>>>(
+        setIndexes, [&loaded, &filter, limit, offer](int setIndex) {
+            const ResultColumns &set = *loaded[setIndex];
+            QVector<Candidate> heap;
+            heap.reserve(qMin(limit, set.size()));
+            for (int i = 0; i < set.size(); ++i) {
+                if (inRange(filter, set.values[i])) {
+                    offer(heap, {set.values[i], setIndex, i});
+                }
+            }
+            return heap;
+        });
+
+    if (token.isCancelled()) {
+        outcome.status = QueryStatus::Cancelled;
+        return outcome;
+    }
+
+    QVector<Candidate> merged;
+    merged.reserve(limit);
+    for (const QVector<Candidate> &candidates : perSet) {
+        for (const Candidate &candidate : candidates) {
+            offer(merged, candidate);
+        }
+    }
+    std::sort_heap(merged.begin(), merged.end(), before);
+
+    int keep = qMin(qMax(0, count), int(merged.size()));
+    for (int i = 0; i < keep; ++i) {
+        const ResultColumns &set = *loaded[merged[i].set];
+        block.append(modelName(set.modelId), set.nodeNumber(merged[i].row),
+                     typeName(set.typeId), merged[i].value);
+    }
+
+    outcome.rows = keep;
+    if (merged.size() > keep) {
+        outcome.status = QueryStatus::Partial;
+    }
+    return outcome;
+}
+
+QueryOutcome ResultStore::join(const QString &model, const QString &firstType, const QString &secondType,
+                               QVector<JoinedResult> &rows, const CancellationToken &token)
+{
+    rows.clear();
+    QueryOutcome outcome;
+
+    ResultFilter firstFilter;
+    firstFilter.modelName = model;
+    firstFilter.calculationType = firstType;
+    ResultFilter secondFilter = firstFilter;
+    secondFilter.calculationType = secondType;
+
+    QVector<SetPointer> first;
+    QVector<SetPointer> second;
+    if (!ensureLoaded(firstFilter, first, outcome.error, token)
+        || !ensureLoaded(secondFilter, second, outcome.error, token)) {
+        outcome.status = token.isCancelled() ? QueryStatus::Cancelled : QueryStatus::Failed;
+        return outcome;
+    }
+    if (first.isEmpty() || second.isEmpty()) {
+        return outcome;
+    }
+
+    // Оба набора упорядочены по узлу - соединение слиянием за один проход.
+    // Если номера одного из наборов текстовые, целый набор идет в строковом порядке
+    const ResultColumns &a = *first.first();
+    const ResultColumns &b = *second.first();
+    const bool numeric = a.numericNodes && b.numericNodes;
+    QVector<int> orderA(a.size());
+    QVector<int> orderB(b.size());
+    std::iota(orderA.begin(), orderA.end(), 0);
+    std::iota(orderB.begin(), orderB.end(), 0);
+    if (!numeric) {
+        if (a.numericNodes) {
+            sortRowsAsText(a, orderA);
+        }
+        if (b.numericNodes) {
+            sortRowsAsText(b, orderB);
+        }
+    }
+
+    int i = 0;
+    int j = 0;
+    while (i < a.size() && j < b.size()) {
+        if ((rows.size() & 4095) == 0 && token.isCancelled()) {
+            outcome.status = QueryStatus::Cancelled;
+            outcome.rows = rows.size();
+            return outcome;
+        }
+
+        const int rowA = orderA[i];
+        const int rowB = orderB[j];
+        if (nodeLess(a, rowA, b, rowB, numeric)) {
+            i++;
+        } else if (nodeLess(b, rowB, a, rowA, numeric)) {
+            j++;
+        } else {
+            rows.append({a.nodeNumber(rowA), a.values[rowA], b.values[rowB]});
+            i++;
+            j++;
+        }
+    }
+
+    outcome.rows = rows.size();
+    return outcome;
+}
+
+void ResultStore::invalidate(const QString &modelName, const QString &calculationType)
+{
+    QMutexLocker locker(&mutex);
+
+    // Новые пары могли появиться в базе - список наборов перечитывается при следующем запросе
+    catalogValid = false;
+    version++;
+
+    for (auto it = sets.begin(); it != sets.end();) {
+        bool modelMatches = modelName.isEmpty() || models.value(it.key().first) == modelName;
+        bool typeMatches = calculationType.isEmpty() || types.value(it.key().second) == calculationType;
+        if (modelMatches && typeMatches) {
+            lastUse.remove(it.key());
+            loadedBytes.fetch_sub(it.value()->memoryBytes(), std::memory_order_relaxed);
+            it = sets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ResultStore::clear()
+{
+    QMutexLocker locker(&mutex);
+    sets.clear();
+    lastUse.clear();
+    loadedBytes.store(0, std::memory_order_relaxed);
+    catalogValid = false;
+    version++;
+}
+
+int ResultStore::loadedSetCount() const
+{
+    QMutexLocker locker(&mutex);
+    return sets.size();
+}
+
+qint64 ResultStore::trim(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+
+    // Кандидаты - от давно не использованных; набор, который держит идущий запрос
+    // (есть другие ссылки), после выгрузки память не освободит - его не трогаем
+    QVector<QPair<quint64, QPair<int, int>>> candidates;
+    candidates.reserve(sets.size());
+    for (auto it = sets.constBegin(); it != sets.constEnd(); ++it) {
+        if (it.value().use_count() == 1) {
+            candidates.append(qMakePair(lastUse.value(it.key()), it.key()));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    qint64 freed = 0;
+    for (const auto &candidate : candidates) {
+        if (freed >= bytes) {
+            break;
+        }
+        freed += sets.value(candidate.second)->memoryBytes();
+        lastUse.remove(candidate.second);
+        sets.remove(candidate.second);
+    }
+    loadedBytes.fetch_sub(freed, std::memory_order_relaxed);
+    return freed;
+}
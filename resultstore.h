@@ -0,0 +1,120 @@
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "database.h"
+#include "resultblock.h"
+
+// Один набор результатов (модель, вид расчета) в памяти: узлы и значения - сплошные массивы,
+// строки упорядочены по номеру узла. После загрузки набор не меняется.
+struct ResultColumns {
+    int modelId = -1;
+    int typeId = -1;
+    bool numericNodes = true;       // номера узлов - целые (nodeIds), иначе строки (nodeTexts)
+    QVector<qint64> nodeIds;
+    QStringList nodeTexts;
+    QVector<double> values;         // в СИ
+
+    double minimum = 0.0;
+    double maximum = 0.0;
+    double sum = 0.0;
+
+    qint64 bytes = 0;               // объем в памяти, считается один раз при загрузке
+
+    int size() const { return values.size(); }
+    QString nodeNumber(int row) const;
+    qint64 memoryBytes() const { return bytes; }
+    qint64 countMemoryBytes() const;
+};
+
+// Строка соединения двух видов расчета одной модели по узлу
+struct JoinedResult {
+    QString nodeNumber;
+    double first = 0.0;
+    double second = 0.0;
+};
+
+// Колоночный движок результатов в памяти. Наборы загружаются из SQLite при первом
+// обращении (каждый через свое соединение, параллельно) и дальше читаются без блокировок.
+// Фильтры, сортировка, агрегаты и соединения выполняются параллельно по наборам.
+// SQLite остается хранилищем: после записи или удаления набор сбрасывается через invalidate().
+// Потокобезопасен.
+class ResultStore
+{
+public:
+    explicit ResultStore(const QString &databaseName = QString());
+
+    void setDatabaseName(const QString &databaseName);
+
+    // Строки в порядке (модель, узел, вид расчета). Узлы модели - по числу, если все ее номера
+    // целые, иначе как строки (тогда порядок тот же, что у Database::queryResultBlock)
+    QueryOutcome select(const ResultFilter &filter, ResultBlock &block,
+                        const CancellationToken &token = CancellationToken());
+
+    // count/min/max/mean по видам расчетов
+    QueryOutcome summarize(const ResultFilter &filter, QList<ResultSummary> &summaries,
+                           const CancellationToken &token = CancellationToken());
+
+    // count строк с наибольшими (наименьшими при descending = false) значениями
+    QueryOutcome top(const ResultFilter &filter, int count, bool descending, ResultBlock &block,
+                     const CancellationToken &token = CancellationToken());
+
+    // Значения двух видов расчета в общих узлах модели
+    QueryOutcome join(const QString &modelName, const QString &firstType, const QString &secondType,
+                      QVector<JoinedResult> &rows,
+                      const CancellationToken &token = CancellationToken());
+
+    // Пустая строка - все модели (все виды расчетов)
+    void invalidate(const QString &modelName, const QString &calculationType = QString());
+    void clear();
+
+    int loadedSetCount() const;
+    // Без обхода наборов: бюджет памяти опрашивает часто
+    qint64 memoryBytes() const { return loadedBytes.load(std::memory_order_relaxed); }
+
+    // Выгрузить давно не использованные наборы не меньше чем на bytes (бюджет памяти);
+    // возвращает освобожденное. Наборы, которые читает идущий запрос, не выгружаются
+    qint64 trim(qint64 bytes);
+
+private:
+    using SetPointer = std::shared_ptr<const ResultColumns>;
+
+    // Загруженные наборы под фильтр, по возрастанию (модель, вид расчета)
+    bool ensureLoaded(const ResultFilter &filter, QVector<SetPointer> &sets, QString &error,
+                      const CancellationToken &token);
+    SetPointer loadSet(const QString &modelName, const QString &calculationType,
+                       QString &error, const CancellationToken &token);
+
+    QString modelName(int modelId) const;
+    QString typeName(int typeId) const;
+    int internModel(const QString &name);
+    int internType(const QString &name);
+
+    mutable QMutex mutex;
+    QString databaseName;
+
+    // Словари: id модели и вида расчета -> название
+    QStringList models;
+    QStringList types;
+    QHash<QString, int> modelIds;
+    QHash<QString, int> typeIds;
+
+    // Какие наборы есть в базе; перечитывается после invalidate()
+    QList<QPair<QString, QString>> catalog;
+    bool catalogValid = false;
+    quint64 version = 0;        // растет при invalidate(): набор, загруженный до сброса, не сохраняется
+
+    QHash<QPair<int, int>, SetPointer> sets;
+    QHash<QPair<int, int>, quint64> lastUse;
+    std::atomic<qint64> loadedBytes{0};     // сумма memoryBytes() наборов sets, меняется под mutex
+    quint64 useCounter = 0;
+};
+
+#endif // RESULTSTORE_H
@@ -0,0 +1,36 @@
+#include "slowquerylog.h"
+#include <QMutexLocker>
+
+SlowQueryLog &SlowQueryLog::instance()
+{
+    static SlowQueryLog log;
+    return log;
+}
+
+void SlowQueryLog::add(const SlowQuery &query)
+{
+    QMutexLocker locker(&mutex);
+    if (queries.size() >= Capacity) {
+        queries.removeFirst();
+    }
+    queries.append(query);
+    recorded++;
+}
+
+QList<SlowQuery> SlowQueryLog::entries() const
+{
+    QMutexLocker locker(&mutex);
+    return queries;
+}
+
+quint64 SlowQueryLog::recordedCount() const
+{
+    QMutexLocker locker(&mutex);
+    return recorded;
+}
+
+void SlowQueryLog::clear()
+{
+    QMutexLocker locker(&mutex);
+    queries.clear();
+}
@@ -0,0 +1,56 @@
+#ifndef SLOWQUERYLOG_H
+#define SLOWQUERYLOG_H
+
+#include <QDateTime>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+// Запрос, выполнявшийся дольше порога
+struct SlowQuery {
+    QDateTime time;
+    QString connection;
+    QString sql;
+    QStringList parameters;         // привязанные значения по порядку
+    qint64 elapsedUs = 0;
+    QStringList plan;               // EXPLAIN QUERY PLAN (с отступами по вложенности)
+    bool fullScan = false;          // в плане есть SCAN таблицы без индекса
+};
+
+// Общий для всех соединений журнал медленных запросов: последние Capacity записей.
+// Пишет Database (время каждого запроса), читают вкладка "Диагностика" и консольная утилита
+class SlowQueryLog
+{
+public:
+    static constexpr int Capacity = 200;
+
+    static SlowQueryLog &instance();
+
+    // Порог в мс; отрицательный - журнал выключен
+    void setThresholdMs(int milliseconds) { threshold.store(milliseconds, std::memory_order_relaxed); }
+    int thresholdMs() const { return threshold.load(std::memory_order_relaxed); }
+    bool isSlow(qint64 elapsedUs) const
+    {
+        const int milliseconds = thresholdMs();
+        return milliseconds >= 0 && elapsedUs >= qint64(milliseconds) * 1000;
+    }
+
+    void add(const SlowQuery &query);
+    QList<SlowQuery> entries() const;
+    // Всего записано с запуска (включая вытесненные)
+    quint64 recordedCount() const;
+    void clear();
+
+private:
+    SlowQueryLog() = default;
+    Q_DISABLE_COPY(SlowQueryLog)
+
+    mutable QMutex mutex;
+    QList<SlowQuery> queries;
+    quint64 recorded = 0;
+    std::atomic<int> threshold{200};
+};
+
+#endif // SLOWQUERYLOG_H
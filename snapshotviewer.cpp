@@ -0,0 +1,190 @@
+#include "snapshotviewer.h"
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <limits>
+
+SnapshotTableModel::SnapshotTableModel(const ResultSnapshot *snapshot, QObject *parent)
+    : QAbstractTableModel(parent)
+    , snapshot(snapshot)
+{
+}
+
+void SnapshotTableModel::setResultSet(int set)
+{
+    beginResetModel();
+    currentSet = set;
+    if (set >= 0) {
+        const SnapshotResultSet &info = snapshot->resultSet(set);
+        displayConversion = UnitRegistry::instance().conversion(info.siUnit, info.displayUnit);
+    }
+    endResetModel();
+}
+
+int SnapshotTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || currentSet < 0) {
+        return 0;
+    }
+    return int(qMin<qint64>(snapshot->resultSet(currentSet).rows, std::numeric_limits<int>::max()));
+}
+
+int SnapshotTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 2;
+}
+
+QVariant SnapshotTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || currentSet < 0
+        || (role != Qt::DisplayRole && role != Qt::TextAlignmentRole)) {
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        return index.column() == 1 ? QVariant(int(Qt::AlignRight | Qt::AlignVCenter)) : QVariant();
+    }
+
+    if (index.column() == 0) {
+        return snapshot->nodeNumber(currentSet, index.row());
+    }
+
+    double value = snapshot->value(currentSet, index.row());
+    if (displayConversion.known && !displayConversion.isIdentity()) {
+        value = displayConversion.toSI(value);
+    }
+    return QString::number(value, 'g', 10);
+}
+
+QVariant SnapshotTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    if (section == 0) {
+        return "Узел";
+    }
+    QString unit = currentSet >= 0 ? snapshot->resultSet(currentSet).displayUnit : QString();
+    return unit.isEmpty() ? QString("Значение") : QString("Значение, %1").arg(unit);
+}
+
+SnapshotViewer::SnapshotViewer(QWidget *parent)
+    : QWidget(parent)
+{
+    setWindowFlag(Qt::Window);
+    resize(700, 800);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+    controlLayout->addWidget(new QLabel("Набор:", this));
+    resultSetComboBox = new QComboBox(this);
+    resultSetComboBox->setMinimumWidth(300);
+    controlLayout->addWidget(resultSetComboBox, 1);
+
+    controlLayout->addWidget(new QLabel("Узел:", this));
+    nodeEdit = new QLineEdit(this);
+    nodeEdit->setMaximumWidth(120);
+    nodeEdit->setPlaceholderText("номер");
+    controlLayout->addWidget(nodeEdit);
+    QPushButton *goButton = new QPushButton("Перейти", this);
+    controlLayout->addWidget(goButton);
+    layout->addLayout(controlLayout);
+
+    statsLabel = new QLabel(this);
+    statsLabel->setStyleSheet("color: gray;");
+    layout->addWidget(statsLabel);
+
+    model = new SnapshotTableModel(&snapshot, this);
+    tableView = new QTableView(this);
+    tableView->setModel(model);
+    // Одинаковая высота строк: представление не перебирает миллионы строк для прокрутки
+    tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    tableView->verticalHeader()->setDefaultSectionSize(22);
+    tableView->horizontalHeader()->setStretchLastSection(true);
+    tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    layout->addWidget(tableView);
+
+    connect(resultSetComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &SnapshotViewer::showResultSet);
+    connect(goButton, &QPushButton::clicked, this, &SnapshotViewer::goToNode);
+    connect(nodeEdit, &QLineEdit::returnPressed, this, &SnapshotViewer::goToNode);
+}
+
+bool SnapshotViewer::openSnapshot(const QString &fileName)
+{
+    model->setResultSet(-1);
+    resultSetComboBox->clear();
+
+    if (!snapshot.open(fileName)) {
+        statsLabel->setText(snapshot.errorString());
+        return false;
+    }
+
+    setWindowTitle("Снимок результатов - " + QFileInfo(fileName).fileName());
+
+    // Открытие читает только оглавление; строки подгружаются при прокрутке
+    for (int i = 0; i < snapshot.resultSetCount(); ++i) {
+        const SnapshotResultSet &info = snapshot.resultSet(i);
+        resultSetComboBox->addItem(QString("%1 - %2 (%3)")
+                                       .arg(info.modelName, info.calculationType)
+                                       .arg(info.rows));
+    }
+    return true;
+}
+
+void SnapshotViewer::showResultSet(int index)
+{
+    model->setResultSet(index);
+    if (index < 0) {
+        statsLabel->clear();
+        return;
+    }
+
+    const SnapshotResultSet &info = snapshot.resultSet(index);
+    UnitConversion conversion = UnitRegistry::instance().conversion(info.siUnit, info.displayUnit);
+    auto display = [&conversion](double value) {
+        return QString::number(conversion.known ? conversion.toSI(value) : value, 'g', 6);
+    };
+
+    statsLabel->setText(QString("Узлов: %1   мин: %2   макс: %3   среднее: %4 %5")
+                            .arg(info.rows)
+                            .arg(display(info.minimum), display(info.maximum), display(info.mean),
+                                 info.displayUnit));
+}
+
+void SnapshotViewer::goToNode()
+{
+    int set = model->resultSet();
+    if (set < 0 || nodeEdit->text().trimmed().isEmpty()) {
+        return;
+    }
+
+    const QString node = nodeEdit->text().trimmed();
+    qint64 row = -1;
+
+    bool numeric = false;
+    qint64 id = node.toLongLong(&numeric);
+    if (numeric && snapshot.resultSet(set).numericNodes) {
+        row = snapshot.findNode(set, id);
+    } else {
+        for (qint64 i = 0; i < snapshot.resultSet(set).rows; ++i) {
+            if (snapshot.nodeNumber(set, i) == node) {
+                row = i;
+                break;
+            }
+        }
+    }
+
+    if (row < 0 || row > std::numeric_limits<int>::max()) {
+        statsLabel->setText("Узел " + node + " не найден");
+        return;
+    }
+
+    QModelIndex index = model->index(int(row), 0);
+    tableView->scrollTo(index, QAbstractItemView::PositionAtCenter);
+    tableView->selectRow(int(row));
+}
@@ -0,0 +1,61 @@
+#ifndef SNAPSHOTVIEWER_H
+#define SNAPSHOTVIEWER_H
+
+#include <QAbstractTableModel>
+#include <QComboBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTableView>
+#include <QWidget>
+#include "resultsnapshot.h"
+#include "unitregistry.h"
+
+// Строки одного набора снимка; данные читаются из отображения файла только для видимых строк
+class SnapshotTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit SnapshotTableModel(const ResultSnapshot *snapshot, QObject *parent = nullptr);
+
+    void setResultSet(int set);
+    int resultSet() const { return currentSet; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    const ResultSnapshot *snapshot;
+    int currentSet = -1;
+    UnitConversion displayConversion;
+};
+
+// Просмотр снимка результатов только для чтения, без базы данных
+class SnapshotViewer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SnapshotViewer(QWidget *parent = nullptr);
+
+    bool openSnapshot(const QString &fileName);
+    QString errorString() const { return snapshot.errorString(); }
+
+private slots:
+    void showResultSet(int index);
+    void goToNode();
+
+private:
+    ResultSnapshot snapshot;
+    SnapshotTableModel *model;
+
+    QComboBox *resultSetComboBox;
+    QLabel *statsLabel;
+    QLineEdit *nodeEdit;
+    QTableView *tableView;
+};
+
+#endif // SNAPSHOTVIEWER_H
@@ -0,0 +1,165 @@
+#include "stallwatchdog.h"
+#include "metrics.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+#include <chrono>
+
+std::atomic<const char *> StallWatchdog::activity{nullptr};
+std::atomic<QThread *> StallWatchdog::watchedThread{nullptr};
+
+namespace {
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+QString EventLoopStall::toString() const
+{
+    const QString duration = QString::number(durationUs / 1e6, 'f', 1) + "s";
+    return activity.isEmpty() ? duration : activity + ' ' + duration;
+}
+
+StallWatchdog &StallWatchdog::instance()
+{
+    static StallWatchdog watchdog;
+    return watchdog;
+}
+
+StallWatchdog::StallWatchdog()
+    : loopLatency(Metrics::instance().latency("GUI event loop"))
+{
+}
+
+void StallWatchdog::start(int intervalMs)
+{
+    if (isRunning() || !QCoreApplication::instance()) {
+        return;
+    }
+
+    interval = qMax(1, intervalMs);
+    watchedThread.store(QCoreApplication::instance()->thread(), std::memory_order_relaxed);
+    pingSentNs.store(-1);
+    {
+        QMutexLocker locker(&controlMutex);
+        stopping = false;
+    }
+
+    thread = QThread::create([this]() { watch(); });
+    thread->setObjectName("StallWatchdog");
+    running.store(true, std::memory_order_relaxed);
+    thread->start(QThread::HighPriority);
+}
+
+void StallWatchdog::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&controlMutex);
+        stopping = true;
+        wakeup.wakeAll();
+    }
+    thread->wait();
+    delete thread;
+    thread = nullptr;
+    running.store(false, std::memory_order_relaxed);
+}
+
+void StallWatchdog::watch()
+{
+    QMutexLocker locker(&controlMutex);
+    while (!stopping) {
+        wakeup.wait(&controlMutex, interval);
+        if (stopping) {
+            break;
+        }
+
+        const qint64 now = nowNs();
+        const qint64 sent = pingSentNs.load();
+        if (sent < 0) {
+            // Прошлый опрос выполнен - отправляем следующий
+            pingSentNs.store(now);
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [this, now]() { answered(now); },
+                                      Qt::QueuedConnection);
+            continue;
+        }
+
+        // Цикл событий занят: запоминаем чем, к ответу занятие уже закончится
+        const int milliseconds = thresholdMs();
+        if (milliseconds >= 0 && now - sent >= qint64(milliseconds) * 1000000
+            && stalledPingNs.load() != sent) {
+            const char *name = currentActivity();
+            if (name) {
+                stalledActivity.store(name);
+                stalledPingNs.store(sent);
+            }
+        }
+    }
+}
+
+void StallWatchdog::answered(qint64 sentNs)
+{
+    const qint64 elapsedUs = (nowNs() - sentNs) / 1000;
+    const char *name = stalledPingNs.load() == sentNs ? stalledActivity.load() : nullptr;
+    pingSentNs.store(-1);
+    loopLatency.record(elapsedUs);
+
+    const int milliseconds = thresholdMs();
+    if (milliseconds < 0 || elapsedUs < qint64(milliseconds) * 1000) {
+        return;
+    }
+
+    EventLoopStall stall;
+    stall.time = QDateTime::currentDateTime();
+    stall.durationUs = elapsedUs;
+    stall.activity = QString::fromLatin1(name);
+    qDebug() << "GUI stall:" << stall.toString();
+
+    QMutexLocker locker(&mutex);
+    if (entries.size() >= Capacity) {
+        entries.removeFirst();
+    }
+    entries.append(stall);
+    recorded++;
+}
+
+QList<EventLoopStall> StallWatchdog::stalls() const
+{
+    QMutexLocker locker(&mutex);
+    return entries;
+}
+
+quint64 StallWatchdog::stallCount() const
+{
+    QMutexLocker locker(&mutex);
+    return recorded;
+}
+
+void StallWatchdog::clear()
+{
+    QMutexLocker locker(&mutex);
+    entries.clear();
+}
+
+GuiActivityScope::GuiActivityScope(const char *name)
+    : active(QThread::currentThread() == StallWatchdog::watchedThread.load(std::memory_order_relaxed))
+{
+    if (active) {
+        previous = StallWatchdog::activity.exchange(name, std::memory_order_relaxed);
+    }
+}
+
+GuiActivityScope::~GuiActivityScope()
+{
+    if (active) {
+        StallWatchdog::activity.store(previous, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QDateTime>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+
+class LatencyHistogram;
+class QThread;
+
+// Цикл событий GUI не отвечал дольше порога
+struct EventLoopStall {
+    QDateTime time;                 // когда цикл событий снова ответил
+    qint64 durationUs = 0;
+    QString activity;               // чем был занят GUI-поток (BD_GUI_ACTIVITY), пусто - неизвестно
+
+    // "MainWindow::showResults 4.2s"
+    QString toString() const;
+};
+
+// Сторожевой поток: каждые intervalMs отправляет в цикл событий GUI пустое событие и
+// меряет, через сколько оно выполнится. Задержки идут в гистограмму Metrics
+// "GUI event loop", ответы дольше порога - в журнал и qDebug вместе с занятием
+// GUI-потока, которое было активно во время зависания.
+class StallWatchdog
+{
+public:
+    static constexpr int Capacity = 200;
+
+    static StallWatchdog &instance();
+
+    // Следит за потоком QCoreApplication; вызывается из него
+    void start(int intervalMs = 50);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Порог в мс; отрицательный - зависания не записываются (гистограмма пишется всегда)
+    void setThresholdMs(int milliseconds) { threshold.store(milliseconds, std::memory_order_relaxed); }
+    int thresholdMs() const { return threshold.load(std::memory_order_relaxed); }
+
+    LatencyHistogram &latency() const { return loopLatency; }
+
+    QList<EventLoopStall> stalls() const;
+    // Всего записано с запуска (включая вытесненные)
+    quint64 stallCount() const;
+    void clear();
+
+    static const char *currentActivity() { return activity.load(std::memory_order_relaxed); }
+
+private:
+    friend class GuiActivityScope;
+
+    StallWatchdog();
+    Q_DISABLE_COPY(StallWatchdog)
+
+    void watch();
+    void answered(qint64 sentNs);
+
+    LatencyHistogram &loopLatency;
+    QThread *thread = nullptr;
+    int interval = 50;
+
+    QMutex controlMutex;
+    QWaitCondition wakeup;
+    bool stopping = false;
+    std::atomic<bool> running{false};
+    std::atomic<int> threshold{250};
+
+    // Опрос в пути: время отправки (-1 - ответ получен) и занятие, замеченное сторожем
+    std::atomic<qint64> pingSentNs{-1};
+    std::atomic<qint64> stalledPingNs{-1};
+    std::atomic<const char *> stalledActivity{nullptr};
+
+    mutable QMutex mutex;
+    QList<EventLoopStall> entries;
+    quint64 recorded = 0;
+
+    static std::atomic<const char *> activity;
+    static std::atomic<QThread *> watchedThread;
+};
+
+// Занятие GUI-потока от конструктора до деструктора (вложенные восстанавливают внешнее).
+// Имя - строковый литерал; в других потоках ничего не делает
+class GuiActivityScope
+{
+public:
+    explicit GuiActivityScope(const char *name);
+    ~GuiActivityScope();
+    Q_DISABLE_COPY(GuiActivityScope)
+
+private:
+    const char *previous = nullptr;
+    bool active = false;
+};
+
+#define BD_GUI_ACTIVITY_CONCAT_(a, b) a##b
+#define BD_GUI_ACTIVITY_CONCAT(a, b) BD_GUI_ACTIVITY_CONCAT_(a, b)
+
+#define BD_GUI_ACTIVITY(name) \
+    GuiActivityScope BD_GUI_ACTIVITY_CONCAT(bdGuiActivity_, __LINE__)(name)
+
+#endif // STALLWATCHDOG_H
@@ -0,0 +1,36 @@
+#include "stringinterner.h"
+
+StringInterner &StringInterner::instance()
+{
+    static StringInterner interner;
+    return interner;
+}
+
+QString StringInterner::intern(const QString &value)
+{
+    if (value.isEmpty()) {
+        return QString();
+    }
+
+    QMutexLocker locker(&mutex);
+
+    auto it = pool.constFind(value);
+    if (it != pool.constEnd()) {
+        return *it;
+    }
+
+    pool.insert(value);
+    return value;
+}
+
+int StringInterner::size() const
+{
+    QMutexLocker locker(&mutex);
+    return pool.size();
+}
+
+void StringInterner::clear()
+{
+    QMutexLocker locker(&mutex);
+    pool.clear();
+}
@@ -0,0 +1,27 @@
+#ifndef STRINGINTERNER_H
+#define STRINGINTERNER_H
+
+#include <QString>
+#include <QSet>
+#include <QMutex>
+
+// Общий для парсеров пул строк: одинаковые названия свойств, единиц
+// и типов расчетов хранятся в памяти в одном экземпляре (implicit sharing QString)
+class StringInterner
+{
+public:
+    static StringInterner &instance();
+
+    QString intern(const QString &value);
+    int size() const;
+    void clear();
+
+private:
+    StringInterner() = default;
+    Q_DISABLE_COPY(StringInterner)
+
+    mutable QMutex mutex;
+    QSet<QString> pool;
+};
+
+#endif // STRINGINTERNER_H
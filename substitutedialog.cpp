@@ -0,0 +1,168 @@
+#include "substitutedialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGroupBox>
+#include <QHeaderView>
+#include <QDoubleSpinBox>
+#include <QElapsedTimer>
+
+SubstituteDialog::SubstituteDialog(Database *database, MaterialSelector *selector,
+                                   const QString &material,
+                                   const QVector<RangePredicate> &selectionConstraints,
+                                   QWidget *parent)
+    : QDialog(parent)
+    , db(database)
+    , search(database, selector)
+    , materialName(material)
+    , constraints(selectionConstraints)
+{
+    setWindowTitle(QString("Замена материала: %1").arg(materialName));
+    resize(700, 600);
+
+    setupUI();
+    fillProperties();
+}
+
+void SubstituteDialog::setupUI()
+{
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    // Веса свойств
+    QGroupBox *weightsGroup = new QGroupBox("Свойства для сравнения", this);
+    QVBoxLayout *weightsLayout = new QVBoxLayout(weightsGroup);
+
+    weightsTable = new QTableWidget(this);
+    weightsTable->setColumnCount(3);
+    weightsTable->setHorizontalHeaderLabels({"Свойство", "Значение", "Вес"});
+    weightsTable->setSelectionMode(QAbstractItemView::NoSelection);
+    weightsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    weightsTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    weightsTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+    weightsLayout->addWidget(weightsTable);
+
+    mainLayout->addWidget(weightsGroup, 1);
+
+    // Параметры поиска
+    QHBoxLayout *optionsLayout = new QHBoxLayout();
+    optionsLayout->addWidget(new QLabel("Количество:", this));
+
+    countSpinBox = new QSpinBox(this);
+    countSpinBox->setRange(1, 500);
+    countSpinBox->setValue(10);
+    optionsLayout->addWidget(countSpinBox);
+
+    constraintsCheckBox = new QCheckBox(QString("Учитывать условия подбора (%1)")
+                                            .arg(constraints.size()), this);
+    constraintsCheckBox->setEnabled(!constraints.isEmpty());
+    constraintsCheckBox->setChecked(!constraints.isEmpty());
+    optionsLayout->addWidget(constraintsCheckBox);
+    optionsLayout->addStretch();
+
+    searchButton = new QPushButton("🔁 Найти замену", this);
+    searchButton->setDefault(true);
+    connect(searchButton, &QPushButton::clicked, this, &SubstituteDialog::runSearch);
+    optionsLayout->addWidget(searchButton);
+
+    mainLayout->addLayout(optionsLayout);
+
+    // Результаты
+    resultsTable = new QTableWidget(this);
+    resultsTable->setColumnCount(3);
+    resultsTable->setHorizontalHeaderLabels({"Материал", "Расстояние", "Совпало свойств"});
+    resultsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    resultsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    resultsTable->setAlternatingRowColors(true);
+    resultsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    mainLayout->addWidget(resultsTable, 1);
+
+    statusLabel = new QLabel(this);
+    statusLabel->setStyleSheet("color: gray; font-style: italic;");
+    mainLayout->addWidget(statusLabel);
+
+    QPushButton *closeButton = new QPushButton("Закрыть", this);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::accept);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(closeButton);
+    mainLayout->addLayout(buttonLayout);
+}
+
+void SubstituteDialog::fillProperties()
+{
+    MaterialPropertyMatrix &matrix = db->materialMatrix();
+    int row = matrix.rowOf(materialName);
+    if (row < 0) {
+        searchButton->setEnabled(false);
+        return;
+    }
+
+    QVector<int> columns = matrix.columnsOf(row);
+    weightsTable->setRowCount(columns.size());
+
+    for (int i = 0; i < columns.size(); ++i) {
+        int column = columns[i];
+
+        QTableWidgetItem *nameItem = new QTableWidgetItem(matrix.propertyName(column));
+        nameItem->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled);
+        nameItem->setCheckState(Qt::Checked);
+        weightsTable->setItem(i, 0, nameItem);
+
+        QTableWidgetItem *valueItem = new QTableWidgetItem(
+            QString("%1 %2").arg(matrix.displayValue(row, column), 0, 'g', 6)
+                             .arg(matrix.displayUnit(row, column)));
+        valueItem->setFlags(Qt::ItemIsEnabled);
+        weightsTable->setItem(i, 1, valueItem);
+
+        QDoubleSpinBox *weightSpinBox = new QDoubleSpinBox(weightsTable);
+        weightSpinBox->setRange(0.0, 100.0);
+        weightSpinBox->setSingleStep(0.5);
+        weightSpinBox->setValue(1.0);
+        weightsTable->setCellWidget(i, 2, weightSpinBox);
+    }
+}
+
+void SubstituteDialog::runSearch()
+{
+    SubstituteQuery query;
+    query.materialName = materialName;
+    query.k = countSpinBox->value();
+
+    if (constraintsCheckBox->isChecked()) {
+        query.constraints = constraints;
+    }
+
+    for (int i = 0; i < weightsTable->rowCount(); ++i) {
+        QTableWidgetItem *nameItem = weightsTable->item(i, 0);
+        auto *weightSpinBox = qobject_cast<QDoubleSpinBox *>(weightsTable->cellWidget(i, 2));
+
+        if (nameItem && weightSpinBox && nameItem->checkState() == Qt::Checked) {
+            query.properties.append({nameItem->text(), weightSpinBox->value()});
+        }
+    }
+
+    if (query.properties.isEmpty()) {
+        statusLabel->setText("Выберите хотя бы одно свойство");
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<SubstituteHit> hits = search.search(query);
+    double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    MaterialPropertyMatrix &matrix = db->materialMatrix();
+    resultsTable->setRowCount(hits.size());
+
+    for (int i = 0; i < hits.size(); ++i) {
+        resultsTable->setItem(i, 0, new QTableWidgetItem(matrix.materialName(hits[i].row)));
+        resultsTable->setItem(i, 1, new QTableWidgetItem(QString::number(hits[i].distance, 'f', 4)));
+        resultsTable->setItem(i, 2, new QTableWidgetItem(QString("%1 из %2")
+                                                             .arg(hits[i].matchedProperties)
+                                                             .arg(query.properties.size())));
+    }
+
+    statusLabel->setText(QString("Найдено кандидатов: %1 за %2 мс")
+                             .arg(hits.size())
+                             .arg(elapsedMs, 0, 'f', 2));
+}
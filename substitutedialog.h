@@ -0,0 +1,43 @@
+#ifndef SUBSTITUTEDIALOG_H
+#define SUBSTITUTEDIALOG_H
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QLabel>
+#include <QPushButton>
+#include "database.h"
+#include "substitutesearch.h"
+
+class SubstituteDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    SubstituteDialog(Database *database, MaterialSelector *selector,
+                     const QString &materialName,
+                     const QVector<RangePredicate> &constraints,
+                     QWidget *parent = nullptr);
+
+private slots:
+    void runSearch();
+
+private:
+    void setupUI();
+    void fillProperties();
+
+    Database *db;
+    SubstituteSearch search;
+    QString materialName;
+    QVector<RangePredicate> constraints;
+
+    QTableWidget *weightsTable;
+    QSpinBox *countSpinBox;
+    QCheckBox *constraintsCheckBox;
+    QPushButton *searchButton;
+    QTableWidget *resultsTable;
+    QLabel *statusLabel;
+};
+
+#endif // SUBSTITUTEDIALOG_H
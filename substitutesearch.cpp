@@ -0,0 +1,153 @@
+#include "substitutesearch.h"
+#include "database.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int BlockSize = 256;
+
+}
+
+SubstituteSearch::SubstituteSearch(Database *database, MaterialSelector *materialSelector)
+    : db(database)
+    , selector(materialSelector)
+{
+}
+
+void SubstituteSearch::syncWithMatrix()
+{
+    matrix = &db->materialMatrix();
+
+    if (matrix->revision() != normalizedRevision) {
+        normalized.clear();
+        normalizedRevision = matrix->revision();
+    }
+    if (normalized.size() < matrix->columnCount()) {
+        normalized.resize(matrix->columnCount());
+    }
+}
+
+const QVector<float> &SubstituteSearch::normalizedColumn(int column)
+{
+    QVector<float> &result = normalized[column];
+    if (result.size() == matrix->rowCount()) {
+        return result;
+    }
+
+    const QVector<double> &values = matrix->values(column);
+    const DenseBitmap &present = matrix->presence(column);
+
+    double minimum = std::numeric_limits<double>::max();
+    double maximum = std::numeric_limits<double>::lowest();
+    for (int row = present.nextSetBit(0); row >= 0; row = present.nextSetBit(row + 1)) {
+        minimum = qMin(minimum, values[row]);
+        maximum = qMax(maximum, values[row]);
+    }
+
+    const double range = maximum - minimum;
+    const double scale = range > 0.0 ? 1.0 / range : 0.0;
+
+    result = QVector<float>(matrix->rowCount(), std::numeric_limits<float>::quiet_NaN());
+    for (int row = present.nextSetBit(0); row >= 0; row = present.nextSetBit(row + 1)) {
+        result[row] = float((values[row] - minimum) * scale);
+    }
+    return result;
+}
+
+QVector<SubstituteHit> SubstituteSearch::search(const SubstituteQuery &query)
+{
+    QVector<SubstituteHit> hits;
+
+    // Кандидаты: живые материалы, удовлетворяющие жестким ограничениям
+    DenseBitmap candidates = selector->match(query.constraints);
+    syncWithMatrix();
+
+    int reference = matrix->rowOf(query.materialName);
+    if (reference < 0 || query.k <= 0) {
+        return hits;
+    }
+    candidates.reset(reference);
+
+    QVector<PropertyWeight> properties = query.properties;
+    if (properties.isEmpty()) {
+        for (int column : matrix->columnsOf(reference)) {
+            properties.append({matrix->propertyName(column), 1.0});
+        }
+    }
+
+    // Свойства, которых нет у исходного материала, сравнить не с чем - пропускаем
+    QVector<const float *> columns;
+    QVector<float> referenceValues;
+    QVector<float> weights;
+    float totalWeight = 0.0f;
+
+    for (const PropertyWeight &property : properties) {
+        int column = matrix->columnOf(property.propertyName);
+        if (column < 0 || property.weight <= 0.0 || !matrix->hasValue(reference, column)) {
+            continue;
+        }
+
+        const QVector<float> &values = normalizedColumn(column);
+        columns.append(values.constData());
+        referenceValues.append(values[reference]);
+        weights.append(float(property.weight));
+        totalWeight += float(property.weight);
+    }
+
+    if (columns.isEmpty()) {
+        return hits;
+    }
+
+    const int rowCount = matrix->rowCount();
+    const float penalty = float(query.missingPenalty * query.missingPenalty);
+    float distances[BlockSize];
+    int matched[BlockSize];
+
+    // Max-куча из k лучших кандидатов (наибольшее расстояние - в вершине)
+    auto worseFirst = [](const SubstituteHit &a, const SubstituteHit &b) {
+        return a.distance < b.distance;
+    };
+    hits.reserve(query.k + 1);
+
+    for (int blockStart = 0; blockStart < rowCount; blockStart += BlockSize) {
+        const int blockSize = qMin(BlockSize, rowCount - blockStart);
+
+        std::fill(distances, distances + blockSize, 0.0f);
+        std::fill(matched, matched + blockSize, 0);
+
+        for (int p = 0; p < columns.size(); ++p) {
+            const float *values = columns[p] + blockStart;
+            const float ref = referenceValues[p];
+            const float weight = weights[p];
+
+            for (int i = 0; i < blockSize; ++i) {
+                const float d = values[i] - ref;
+                const bool missing = d != d;
+                distances[i] += weight * (missing ? penalty : d * d);
+                matched[i] += missing ? 0 : 1;
+            }
+        }
+
+        for (int i = 0; i < blockSize; ++i) {
+            const int row = blockStart + i;
+            if (!candidates.test(row) || matched[i] == 0) {
+                continue;
+            }
+
+            const double distance = std::sqrt(double(distances[i]) / totalWeight);
+            if (hits.size() < query.k) {
+                hits.append({row, distance, matched[i]});
+                std::push_heap(hits.begin(), hits.end(), worseFirst);
+            } else if (distance < hits.first().distance) {
+                std::pop_heap(hits.begin(), hits.end(), worseFirst);
+                hits.last() = {row, distance, matched[i]};
+                std::push_heap(hits.begin(), hits.end(), worseFirst);
+            }
+        }
+    }
+
+    std::sort_heap(hits.begin(), hits.end(), worseFirst);
+    return hits;
+}
@@ -0,0 +1,51 @@
+#ifndef SUBSTITUTESEARCH_H
+#define SUBSTITUTESEARCH_H
+
+#include <QString>
+#include <QVector>
+#include "materialselector.h"
+
+struct PropertyWeight {
+    QString propertyName;
+    double weight = 1.0;
+};
+
+struct SubstituteQuery {
+    QString materialName;                 // материал, которому ищется замена
+    QVector<PropertyWeight> properties;   // пусто - все свойства материала с весом 1
+    QVector<RangePredicate> constraints;  // жесткие ограничения для кандидатов
+    int k = 10;
+    double missingPenalty = 1.0;          // вклад отсутствующего значения (в нормированных единицах)
+};
+
+struct SubstituteHit {
+    int row = -1;
+    double distance = 0.0;
+    int matchedProperties = 0;
+};
+
+// Поиск k ближайших материалов по нормированному профилю свойств.
+// Веса задаются на каждый запрос, поэтому вместо дерева (которое пришлось бы
+// перестраивать под каждый набор весов) используется блочный перебор по
+// непрерывным float-колонкам, который компилятор векторизует.
+class SubstituteSearch
+{
+public:
+    SubstituteSearch(Database *database, MaterialSelector *selector);
+
+    QVector<SubstituteHit> search(const SubstituteQuery &query);
+
+private:
+    void syncWithMatrix();
+    const QVector<float> &normalizedColumn(int column);
+
+    Database *db;
+    MaterialSelector *selector;
+    MaterialPropertyMatrix *matrix = nullptr;
+    quint64 normalizedRevision = 0;
+
+    // Значения, приведенные к [0, 1] по диапазону колонки; NaN - значение отсутствует
+    QVector<QVector<float>> normalized;
+};
+
+#endif // SUBSTITUTESEARCH_H
@@ -0,0 +1,286 @@
+#include "syntheticdata.h"
+#include <QTextStream>
+#include <cmath>
+
+namespace {
+
+// Значение результата: логнормальный разброс вокруг типичной величины, иногда ноль и знак минус
+double resultValue(QRandomGenerator &random)
+{
+    double value = std::exp(random.generateDouble() * 12.0 - 4.0);
+    if (random.bounded(10) == 0) {
+        value = -value;
+    }
+    if (random.bounded(200) == 0) {
+        value = 0.0;
+    }
+    return value;
+}
+
+QString formatNumber(double value, ResultFileOptions::NumberFormat format, bool commaDecimals,
+                     QRandomGenerator &random)
+{
+    if (format == ResultFileOptions::Mixed) {
+        format = ResultFileOptions::NumberFormat(random.bounded(3));
+    }
+
+    QString text;
+    switch (format) {
+    case ResultFileOptions::Fixed:
+        text = QString::number(value, 'f', 6);
+        break;
+    case ResultFileOptions::Exponent:
+        text = QString::number(value, 'E', 6);
+        break;
+    case ResultFileOptions::SpacedExponent:
+        text = QString::number(value, 'E', 6).replace('E', " E");
+        break;
+    case ResultFileOptions::Mixed:
+        break;
+    }
+
+    if (commaDecimals) {
+        text.replace('.', ',');
+    }
+    return text;
+}
+
+}
+
+QByteArray generateResultFile(const ResultFileOptions &options)
+{
+    QRandomGenerator random(quint32(options.seed ^ (options.seed >> 32)));
+
+    QByteArray data;
+    data.reserve(options.nodes * 24);
+    QTextStream out(&data, QIODevice::WriteOnly);
+
+    out << "# Synthetic export, seed " << options.seed << "\n";
+    out << "Node Number\t" << options.calculationType << " (" << options.unit << ")\n";
+
+    const quint32 junkThreshold = quint32(qBound(0.0, options.junkRatio, 1.0) * 1000000);
+    int node = 0;
+    for (int written = 0; written < options.nodes;) {
+        if (junkThreshold > 0 && random.bounded(1000000u) < junkThreshold) {
+            switch (random.bounded(4)) {
+            case 0:
+                out << "# comment line " << node << "\n";
+                break;
+            case 1:
+                out << "\n";
+                break;
+            case 2:
+                out << "// exported by Mechanical\n";
+                break;
+            default:
+                // Узел без значения - парсер записывает 0
+                out << ++node << "\n";
+                written++;
+                break;
+            }
+            continue;
+        }
+
+        // Номера идут с пропусками, как в реальных сетках
+        node += 1 + (random.bounded(8) == 0 ? int(random.bounded(5)) : 0);
+        out << node << "\t"
+            << formatNumber(resultValue(random), options.format, options.commaDecimals, random) << "\n";
+        written++;
+    }
+
+    out.flush();
+    return data;
+}
+
+QString resultFileName(const QString &calculationType, int index)
+{
+    return QString("%1 %2.txt").arg(calculationType).arg(index);
+}
+
+QStringList generateNumbers(int count, ResultFileOptions::NumberFormat format, bool commaDecimals,
+                            quint64 seed)
+{
+    QRandomGenerator random(quint32(seed ^ (seed >> 32)));
+    QStringList numbers;
+    numbers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        numbers.append(formatNumber(resultValue(random), format, commaDecimals, random));
+    }
+    return numbers;
+}
+
+QStringList generateResultFileNames(int count, quint64 seed)
+{
+    static const QStringList patterns = {
+        "Normal Stress %1.txt",
+        "Directional Deformation X %1.txt",
+        "directional_deformation_y_%1.txt",
+        "Shear Stress XY %1.txt",
+        "Total Deformation %1.txt",
+        "Equivalent Stress %1.txt",
+        "Equivalent Elastic Strain %1.txt",
+        "Force Reaction %1.txt",
+        "Pressure_Probe_%1.txt",
+        "Temperature-%1.txt"
+    };
+
+    QRandomGenerator random(quint32(seed ^ (seed >> 32)));
+    QStringList names;
+    names.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        names.append(patterns[int(random.bounded(quint32(patterns.size())))].arg(i));
+    }
+    return names;
+}
+
+const QList<SyntheticProperty> &syntheticProperties()
+{
+    static const QList<SyntheticProperty> properties = {
+        {"Density", "kg m^-3", 7850.0},
+        {"Young's Modulus", "Pa", 2.0e11},
+        {"Poisson's Ratio", "", 0.3},
+        {"Bulk Modulus", "Pa", 1.6e11},
+        {"Shear Modulus", "Pa", 7.7e10},
+        {"Tensile Yield Strength", "Pa", 2.5e8},
+        {"Compressive Yield Strength", "Pa", 2.5e8},
+        {"Tensile Ultimate Strength", "Pa", 4.6e8},
+        {"Coefficient of Thermal Expansion", "C^-1", 1.2e-5},
+        {"Isotropic Thermal Conductivity", "W m^-1 C^-1", 60.5},
+        {"Specific Heat", "J kg^-1 C^-1", 434.0},
+        {"Isotropic Resistivity", "ohm m", 1.7e-7},
+        {"Relative Permeability", "", 10000.0},
+        {"Fatigue Strength", "Pa", 8.6e7},
+        {"Hardness", "Pa", 1.2e9},
+        {"Elongation", "", 0.2}
+    };
+    return properties;
+}
+
+QByteArray generateMatML(const MatMLOptions &options)
+{
+    QRandomGenerator random(quint32(options.seed ^ (options.seed >> 32)));
+    const QList<SyntheticProperty> &properties = syntheticProperties();
+
+    QByteArray data;
+    QTextStream out(&data, QIODevice::WriteOnly);
+
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<EngineeringData version=\"18.0\">\n<Materials>\n<MatML_Doc>\n";
+
+    for (int m = 0; m < options.materials; ++m) {
+        out << "<Material>\n<BulkDetails>\n"
+            << "<Name>Synthetic Material " << options.seed << "-" << m << "</Name>\n"
+            << "<Description>Generated for benchmarks</Description>\n";
+
+        for (int p = 0; p < options.properties; ++p) {
+            const SyntheticProperty &property = properties[p % properties.size()];
+            const double value = property.typical * (0.5 + random.generateDouble());
+            const bool curve = options.curveEvery > 0 && p % options.curveEvery == options.curveEvery - 1;
+
+            out << "<PropertyData property=\"pr" << p << "\">\n<Data format=\"float\">";
+            if (curve) {
+                for (int i = 0; i < options.curvePoints; ++i) {
+                    out << (i > 0 ? "," : "") << QString::number(value * (1.0 - 0.02 * i), 'g', 10);
+                }
+                out << "</Data>\n<Qualifier name=\"Variable Type\">Dependent</Qualifier>\n"
+                    << "<ParameterValue parameter=\"pa0\" format=\"float\">\n<Data>";
+                for (int i = 0; i < options.curvePoints; ++i) {
+                    out << (i > 0 ? "," : "") << 20 + 50 * i;
+                }
+                out << "</Data>\n</ParameterValue>\n";
+            } else {
+                out << QString::number(value, 'g', 10) << "</Data>\n";
+            }
+            if (p == 1) {
+                out << "<Qualifier name=\"Behavior\">Isotropic</Qualifier>\n";
+            }
+            out << "</PropertyData>\n";
+        }
+        out << "</BulkDetails>\n</Material>\n";
+    }
+
+    // Метаданные общие для всех материалов документа
+    out << "<Metadata>\n";
+    for (int p = 0; p < options.properties; ++p) {
+        // Свойства сверх списка получают номер: имена в документе должны различаться
+        const SyntheticProperty &property = properties[p % properties.size()];
+        QString name = property.name;
+        if (p >= properties.size()) {
+            name += QString(" %1").arg(p / properties.size());
+        }
+
+        out << "<PropertyDetails id=\"pr" << p << "\">\n<Name>" << name << "</Name>\n";
+        if (qstrlen(property.unit) > 0) {
+            out << "<Units><Unit><Name>" << property.unit << "</Name></Unit></Units>\n";
+        } else {
+            out << "<Unitless/>\n";
+        }
+        out << "</PropertyDetails>\n";
+    }
+    out << "<ParameterDetails id=\"pa0\">\n<Name>Temperature</Name>\n"
+        << "<Units><Unit><Name>C</Name></Unit></Units>\n</ParameterDetails>\n"
+        << "</Metadata>\n</MatML_Doc>\n</Materials>\n</EngineeringData>\n";
+
+    out.flush();
+    return data;
+}
+
+ParsedData generateParsedData(const QString &calculationType, const QString &unit,
+                              int firstNode, int nodes, quint64 seed)
+{
+    QRandomGenerator random(quint32(seed ^ (seed >> 32)) ^ quint32(firstNode));
+
+    ParsedData data;
+    data.calculationType = calculationType;
+    data.unit = unit;
+    data.sourceUnit = unit;
+    for (int i = 0; i < nodes; ++i) {
+        data.nodeValues.insert(QString::number(firstNode + i), resultValue(random));
+    }
+    return data;
+}
+
+ParsedMaterial generateParsedMaterial(int index, int properties, quint64 seed)
+{
+    static const QStringList families = {
+        "Structural Steel", "Stainless Steel", "Aluminum Alloy", "Titanium Alloy", "Copper Alloy",
+        "Gray Cast Iron", "Magnesium Alloy", "Nickel Alloy", "Polyethylene", "Concrete"
+    };
+
+    QRandomGenerator random(quint32(seed ^ (seed >> 32)) ^ quint32(index * 2654435761u));
+    const QList<SyntheticProperty> &known = syntheticProperties();
+
+    ParsedMaterial material;
+    material.name = QString("%1 %2").arg(families[index % families.size()]).arg(index);
+    material.isotropic = index % 3 != 0;
+
+    for (int p = 0; p < properties; ++p) {
+        const SyntheticProperty &property = known[p % known.size()];
+        const QString id = QString("pr%1").arg(p);
+
+        PropertyMeta meta;
+        meta.name = p < known.size() ? QString(property.name)
+                                     : QString("%1 %2").arg(property.name).arg(p / known.size());
+        meta.unit = property.unit;
+        material.meta.insert(id, meta);
+
+        const double value = property.typical * (0.5 + random.generateDouble());
+        material.values.insert(id, value);
+
+        if (p % 4 == 3) {
+            ParsedCurve curve;
+            curve.parameterId = "pa0";
+            for (int i = 0; i < 6; ++i) {
+                curve.abscissa.append(20 + 50 * i);
+                curve.ordinate.append(value * (1.0 - 0.02 * i));
+            }
+            material.curves.insert(id, curve);
+        }
+    }
+
+    PropertyMeta temperature;
+    temperature.name = "Temperature";
+    temperature.unit = "C";
+    material.parameters.insert("pa0", temperature);
+    return material;
+}
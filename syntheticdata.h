@@ -0,0 +1,73 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include "fileparser.h"
+#include "materialparser.h"
+
+// Детерминированные генераторы тестовых данных для бенчмарков: одинаковые параметры
+// и seed дают побайтно одинаковые файлы на любой машине.
+
+// Текстовый экспорт результатов Workbench: заголовок с единицей, затем "узел<TAB>значение"
+struct ResultFileOptions {
+    enum NumberFormat {
+        Fixed,          // 123.456789
+        Exponent,       // 1.234568E+02
+        SpacedExponent, // 1.234568 E+02 (встречается в старых экспортах)
+        Mixed           // все форматы вперемешку
+    };
+
+    int nodes = 100000;
+    QString calculationType = "Normal Stress";
+    QString unit = "MPa";
+    NumberFormat format = Exponent;
+    bool commaDecimals = false;     // "1,234568E+02"
+    double junkRatio = 0.0;         // доля мусорных строк: комментарии, пустые, узел без значения
+    quint64 seed = 1;
+};
+
+QByteArray generateResultFile(const ResultFileOptions &options);
+
+// Имя файла, по которому FileParser::detectCalculationType узнает вид расчета
+QString resultFileName(const QString &calculationType, int index = 0);
+
+// Отдельные числа в тех же форматах - для FileParser::parseNumber
+QStringList generateNumbers(int count, ResultFileOptions::NumberFormat format, bool commaDecimals,
+                            quint64 seed = 1);
+
+// Имена файлов экспорта всех видов, как их называют пользователи
+QStringList generateResultFileNames(int count, quint64 seed = 1);
+
+// Документ MatML (формат Granta/Workbench): materials материалов в одном документе,
+// у каждого properties свойств; каждое curveEvery-е свойство - зависимость от температуры
+struct MatMLOptions {
+    int materials = 1;
+    int properties = 12;
+    int curveEvery = 4;             // 0 - без зависимостей
+    int curvePoints = 8;
+    quint64 seed = 1;
+};
+
+QByteArray generateMatML(const MatMLOptions &options);
+
+// Уже разобранные данные - для нагрузки на базу без разбора файлов.
+// Узлы firstNode .. firstNode + nodes - 1, значения в СИ
+ParsedData generateParsedData(const QString &calculationType, const QString &unit,
+                              int firstNode, int nodes, quint64 seed = 1);
+
+// Материал с properties свойствами (каждое 4-е - зависимость от температуры).
+// Названия вида "Structural Steel 1234": по ним ищет MaterialSearchIndex
+ParsedMaterial generateParsedMaterial(int index, int properties = 12, quint64 seed = 1);
+
+// Общий список свойств генераторов (имя, единица СИ, типичный порядок величины)
+struct SyntheticProperty {
+    const char *name;
+    const char *unit;
+    double typical;
+};
+const QList<SyntheticProperty> &syntheticProperties();
+
+#endif // SYNTHETICDATA_H
@@ -0,0 +1,206 @@
+#include "tracer.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> Tracer::enabled{false};
+std::atomic<bool> Tracer::detailed{false};
+
+namespace {
+
+struct TraceEvent {
+    const char *category;
+    const char *name;
+    qint64 beginNs;
+    qint64 durationNs;
+};
+
+// Буфер пишет только свой поток; при переполнении затираются самые старые события.
+// Счетчики не сбрасываются: запуск записи отмечается номером сеанса и индексом его начала
+struct ThreadBuffer {
+    static constexpr quint64 Capacity = 1 << 16;    // 64K событий, 2 МБ на поток
+
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<quint64> written{0};
+    std::atomic<quint64> session{0};                // сеанс, в котором поток писал последним
+    std::atomic<quint64> sessionBegin{0};           // значение written в начале этого сеанса
+    quint64 threadId = 0;
+    QString threadName;                             // под mutex реестра
+};
+
+// Растет при каждом Tracer::start()
+std::atomic<quint64> currentSession{0};
+
+struct Registry {
+    QMutex mutex;
+    // Буферы живут и после завершения потока - события пула не теряются
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    quint64 nextThreadId = 1;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+ThreadBuffer &threadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        buffer->threadId = reg.nextThreadId++;
+        reg.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+QByteArray jsonString(const QString &text)
+{
+    QByteArray escaped;
+    for (QChar ch : text) {
+        if (ch == '"' || ch == '\\') {
+            escaped += '\\';
+        }
+        escaped += ch.unicode() < 0x20 ? QByteArray(" ") : QString(ch).toUtf8();
+    }
+    return '"' + escaped + '"';
+}
+
+}
+
+qint64 Tracer::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - processStart).count();
+}
+
+void Tracer::start(bool withDetails)
+{
+    // Буферы других потоков не трогаем - они могут писать в этот момент.
+    // Под mutex реестра: новый сеанс не начнется, пока выгружается прошлый
+    QMutexLocker locker(&registry().mutex);
+    currentSession.fetch_add(1, std::memory_order_relaxed);
+    detailed.store(withDetails, std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_release);
+}
+
+void Tracer::stop()
+{
+    enabled.store(false, std::memory_order_relaxed);
+    detailed.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const QString &name)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    QMutexLocker locker(&registry().mutex);
+    buffer.threadName = name;
+}
+
+void Tracer::record(const char *category, const char *name, qint64 beginNs, qint64 endNs)
+{
+    // Интервал, открытый до stop(), после него не пишется
+    if (!enabled.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    ThreadBuffer &buffer = threadBuffer();
+    if (!buffer.events) {
+        buffer.events.reset(new TraceEvent[ThreadBuffer::Capacity]);
+    }
+
+    const quint64 index = buffer.written.load(std::memory_order_relaxed);
+    const quint64 session = currentSession.load(std::memory_order_relaxed);
+    if (buffer.session.load(std::memory_order_relaxed) != session) {
+        buffer.sessionBegin.store(index, std::memory_order_relaxed);
+        buffer.session.store(session, std::memory_order_release);
+    }
+    buffer.events[index % ThreadBuffer::Capacity] = {category, name, beginNs, endNs - beginNs};
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::writeChromeTrace(const QString &fileName, QString *error)
+{
+    stop();
+
+    if (!compiledIn()) {
+        if (error) {
+            *error = "Built without tracing (qmake \"CONFIG+=tracing\")";
+        }
+        return false;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = "Cannot write trace: " + file.errorString();
+        }
+        return false;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    quint64 dropped = 0;
+    bool first = true;
+    auto separator = [&]() {
+        file.write(first ? "\n" : ",\n");
+        first = false;
+    };
+
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    const quint64 session = currentSession.load(std::memory_order_relaxed);
+    for (const auto &buffer : reg.buffers) {
+        // Сначала сеанс (вместе с ним видно его начало), затем опубликованные до stop() события
+        if (buffer->session.load(std::memory_order_acquire) != session) {
+            continue;
+        }
+        const quint64 sessionBegin = buffer->sessionBegin.load(std::memory_order_relaxed);
+        const quint64 written = buffer->written.load(std::memory_order_acquire);
+        if (written <= sessionBegin) {
+            continue;
+        }
+
+        const QByteArray tid = QByteArray::number(buffer->threadId);
+        const QString threadName = buffer->threadName.isEmpty()
+                                       ? QString("thread %1").arg(buffer->threadId)
+                                       : buffer->threadName;
+        separator();
+        file.write("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid + ",\"tid\":" + tid
+                   + ",\"args\":{\"name\":" + jsonString(threadName) + "}}");
+
+        // Запись, начатая до stop(), может дописываться в самую старую ячейку - ее пропускаем
+        const quint64 kept = ThreadBuffer::Capacity - 1;
+        const quint64 begin = qMax(sessionBegin, written > kept ? written - kept : 0);
+        dropped += begin - sessionBegin;
+        for (quint64 i = begin; i < written; ++i) {
+            const TraceEvent &event = buffer->events[i % ThreadBuffer::Capacity];
+            separator();
+            file.write("{\"ph\":\"X\",\"cat\":\"" + QByteArray(event.category)
+                       + "\",\"name\":\"" + QByteArray(event.name)
+                       + "\",\"ts\":" + QByteArray::number(event.beginNs / 1000.0, 'f', 3)
+                       + ",\"dur\":" + QByteArray::number(event.durationNs / 1000.0, 'f', 3)
+                       + ",\"pid\":" + pid + ",\"tid\":" + tid + "}");
+        }
+    }
+
+    file.write("\n],\"otherData\":{\"droppedEvents\":" + QByteArray::number(dropped) + "}}\n");
+
+    if (!file.commit()) {
+        if (error) {
+            *error = "Cannot write trace: " + file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// Трассировка горячих участков: интервалы пишутся в кольцевой буфер своего потока
+// (без блокировок) и выгружаются в JSON формата Chrome trace (chrome://tracing, Perfetto).
+//
+// Интервалы ставятся макросами BD_TRACE_SCOPE / BD_TRACE_DETAIL. Без сборки с
+//   qmake "CONFIG+=tracing"
+// макросы пустые, и трассировка ничего не стоит. В сборке с трассировкой запись
+// включается только после Tracer::start(), до этого интервал - одна проверка флага.
+class Tracer
+{
+public:
+    // withDetails - писать и мелкие интервалы (BD_TRACE_DETAIL): разбор отдельных чисел и т.п.
+    static void start(bool withDetails = false);
+    static void stop();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static bool isDetailed() { return detailed.load(std::memory_order_relaxed); }
+
+    // Останавливает запись и сохраняет накопленное; false - сборка без трассировки или ошибка записи
+    static bool writeChromeTrace(const QString &fileName, QString *error = nullptr);
+
+    // Имя текущего потока в трассе (иначе - номер)
+    static void setThreadName(const QString &name);
+
+    static qint64 nowNs();
+    static void record(const char *category, const char *name, qint64 beginNs, qint64 endNs);
+
+    static constexpr bool compiledIn()
+    {
+#ifdef BD_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    static std::atomic<bool> enabled;
+    static std::atomic<bool> detailed;
+};
+
+// Интервал от конструктора до деструктора. Имена - строковые литералы (хранится указатель)
+class TraceSpan
+{
+public:
+    TraceSpan(const char *category, const char *name, bool active)
+        : category(category), name(name), beginNs(active ? Tracer::nowNs() : -1) {}
+    ~TraceSpan()
+    {
+        if (beginNs >= 0) {
+            Tracer::record(category, name, beginNs, Tracer::nowNs());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *category;
+    const char *name;
+    qint64 beginNs;
+};
+
+#define BD_TRACE_CONCAT_(a, b) a##b
+#define BD_TRACE_CONCAT(a, b) BD_TRACE_CONCAT_(a, b)
+
+#ifdef BD_TRACING
+#define BD_TRACE_SCOPE(category, name) \
+    TraceSpan BD_TRACE_CONCAT(bdTraceSpan_, __LINE__)(category, name, Tracer::isEnabled())
+#define BD_TRACE_DETAIL(category, name) \
+    TraceSpan BD_TRACE_CONCAT(bdTraceSpan_, __LINE__)(category, name, Tracer::isDetailed())
+#else
+#define BD_TRACE_SCOPE(category, name) ((void)0)
+#define BD_TRACE_DETAIL(category, name) ((void)0)
+#endif
+
+#endif // TRACER_H
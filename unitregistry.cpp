@@ -0,0 +1,159 @@
+#include "unitregistry.h"
+#include <QRegularExpression>
+#include <QStringList>
+
+const UnitRegistry &UnitRegistry::instance()
+{
+    static const UnitRegistry registry;
+    return registry;
+}
+
+UnitRegistry::UnitRegistry()
+{
+    // Длина
+    add("m", {"m", "meter", "metre"}, 1.0);
+    add("m", {"mm"}, 1e-3);
+    add("m", {"cm"}, 1e-2);
+    add("m", {"um", "micron"}, 1e-6);
+    add("m", {"km"}, 1e3);
+    add("m", {"in", "inch"}, 0.0254);
+    add("m", {"ft"}, 0.3048);
+
+    // Давление, напряжение
+    add("Pa", {"Pa", "N/m^2"}, 1.0);
+    add("Pa", {"kPa"}, 1e3);
+    add("Pa", {"MPa", "N/mm^2"}, 1e6);
+    add("Pa", {"GPa"}, 1e9);
+    add("Pa", {"bar"}, 1e5);
+    add("Pa", {"psi"}, 6894.757293168);
+    add("Pa", {"ksi"}, 6894757.293168);
+
+    // Сила
+    add("N", {"N", "newton"}, 1.0);
+    add("N", {"kN"}, 1e3);
+    add("N", {"mN"}, 1e-3);
+    add("N", {"lbf"}, 4.4482216152605);
+
+    // Плотность
+    add("kg/m^3", {"kg/m^3"}, 1.0);
+    add("kg/m^3", {"g/cm^3"}, 1e3);
+    add("kg/m^3", {"t/mm^3", "tonne/mm^3"}, 1e12);
+    add("kg/m^3", {"lb/in^3"}, 27679.9047102);
+    add("kg/m^3", {"lb/ft^3"}, 16.0184633740);
+
+    // Температура
+    add("K", {"K", "kelvin"}, 1.0);
+    add("K", {"C", "degC", "celsius"}, 1.0, 273.15);
+    add("K", {"F", "degF", "fahrenheit"}, 5.0 / 9.0, 273.15 - 32.0 * 5.0 / 9.0);
+
+    // Безразмерные (деформация, коэффициенты)
+    add("dimensionless", {"dimensionless", "-", "m/m", "mm/mm", "in/in", "1"}, 1.0);
+    add("dimensionless", {"%"}, 1e-2);
+
+    // Энергия, масса, время
+    add("J", {"J"}, 1.0);
+    add("J", {"kJ"}, 1e3);
+    add("J", {"mJ"}, 1e-3);
+    add("kg", {"kg"}, 1.0);
+    add("kg", {"g"}, 1e-3);
+    add("kg", {"lb"}, 0.45359237);
+    add("s", {"s", "sec"}, 1.0);
+    add("s", {"ms"}, 1e-3);
+    add("s", {"min"}, 60.0);
+    add("s", {"h", "hr"}, 3600.0);
+
+    // Теплофизические свойства
+    add("W/m.K", {"W/m.K", "W/m.C", "W/m/K", "W/m/C", "W/m.degC"}, 1.0);
+    add("J/kg.K", {"J/kg.K", "J/kg.C", "J/kg/K", "J/kg/C", "J/kg.degC"}, 1.0);
+    add("J/kg.K", {"kJ/kg.K", "kJ/kg.C"}, 1e3);
+    add("1/K", {"1/K", "1/C", "1/degC", "K^-1", "C^-1"}, 1.0);
+    add("1/K", {"1/F", "1/degF", "F^-1"}, 1.8);
+    add("1/K", {"ustrain/C", "ustrain/K", "10^-6/C", "10^-6/K"}, 1e-6);
+
+    // Прочие механические
+    add("Pa.m^0.5", {"Pa.m^0.5", "Pa.m^1/2"}, 1.0);
+    add("Pa.m^0.5", {"MPa.m^0.5", "MPa.m^1/2"}, 1e6);
+    add("J/m^3", {"J/m^3"}, 1.0);
+    add("J/m^3", {"kJ/m^3"}, 1e3);
+    add("J/m^3", {"MJ/m^3"}, 1e6);
+    add("ohm.m", {"ohm.m"}, 1.0);
+    add("ohm.m", {"uohm.cm"}, 1e-8);
+}
+
+void UnitRegistry::add(const QString &siUnit, const QStringList &aliases, double factor, double offset)
+{
+    UnitConversion conversion;
+    conversion.siUnit = siUnit;
+    conversion.factor = factor;
+    conversion.offset = offset;
+    conversion.known = true;
+
+    for (const QString &alias : aliases) {
+        const QString key = canonicalKey(alias);
+        units.insert(key, conversion);
+    }
+}
+
+QString UnitRegistry::canonicalKey(const QString &unit)
+{
+    static const QRegularExpression implicitPower("([A-Za-z])(\\d)");
+
+    QString key = unit.trimmed();
+    key.remove(' ');
+    key.remove('(');
+    key.remove(')');
+    key.remove(QChar(0x00B0));              // °
+    key.replace(QChar(0x00B5), 'u');        // µ
+    key.replace(QChar(0x03BC), 'u');        // μ
+    key.replace(QChar(0x00B2), "^2");
+    key.replace(QChar(0x00B3), "^3");
+    key.replace(QChar(0x00B7), '.');        // ·
+    key.replace("**", "^");
+    key.replace('*', '.');
+    key.replace(implicitPower, "\\1^\\2");  // m3 -> m^3
+    return key;
+}
+
+UnitConversion UnitRegistry::lookup(const QString &unit) const
+{
+    const QString key = canonicalKey(unit);
+
+    // Регистр значим: приставки SI различаются им (MN и mN, MPa и mPa, S и s)
+    auto it = units.constFind(key);
+    if (it != units.constEnd()) {
+        return it.value();
+    }
+
+    // Неизвестная единица остается как есть
+    UnitConversion conversion;
+    conversion.siUnit = unit;
+    return conversion;
+}
+
+UnitConversion UnitRegistry::conversion(const QString &fromUnit, const QString &toUnit) const
+{
+    UnitConversion result;
+    result.siUnit = toUnit;
+
+    if (fromUnit == toUnit) {
+        result.known = true;
+        return result;
+    }
+
+    const UnitConversion from = lookup(fromUnit);
+    const UnitConversion to = lookup(toUnit);
+    if (!from.known || !to.known || from.siUnit != to.siUnit) {
+        return result;
+    }
+
+    // to(from(x)): (x * f1 + o1 - o2) / f2
+    result.factor = from.factor / to.factor;
+    result.offset = (from.offset - to.offset) / to.factor;
+    result.known = true;
+    return result;
+}
+
+double UnitRegistry::convert(double value, const QString &fromUnit, const QString &toUnit) const
+{
+    return conversion(fromUnit, toUnit).toSI(value);
+}
@@ -0,0 +1,43 @@
+#ifndef UNITREGISTRY_H
+#define UNITREGISTRY_H
+
+#include <QString>
+#include <QHash>
+
+// Линейный перевод значения в единицы СИ: si = value * factor + offset
+struct UnitConversion {
+    QString siUnit;
+    double factor = 1.0;
+    double offset = 0.0;    // ненулевой только для температур (°C, °F)
+    bool known = false;
+
+    bool isIdentity() const { return factor == 1.0 && offset == 0.0; }
+    double toSI(double value) const { return value * factor + offset; }
+    double fromSI(double value) const { return (value - offset) / factor; }
+};
+
+// Реестр единиц измерения с заранее вычисленными коэффициентами.
+// Единицы приводятся к СИ при загрузке данных, исходная единица сохраняется для отображения.
+class UnitRegistry
+{
+public:
+    static const UnitRegistry &instance();
+
+    UnitConversion lookup(const QString &unit) const;
+    bool isKnown(const QString &unit) const { return lookup(unit).known; }
+
+    // Перевод между двумя единицами одной величины; при несовместимых единицах - без изменений
+    UnitConversion conversion(const QString &fromUnit, const QString &toUnit) const;
+    double convert(double value, const QString &fromUnit, const QString &toUnit) const;
+
+    static QString canonicalKey(const QString &unit);
+
+private:
+    UnitRegistry();
+
+    void add(const QString &siUnit, const QStringList &aliases, double factor, double offset = 0.0);
+
+    QHash<QString, UnitConversion> units;
+};
+
+#endif // UNITREGISTRY_H
@@ -0,0 +1,251 @@
+#include "watchfolderservice.h"
+#include <QDir>
+#include <QSet>
+
+WatchIngestWorker::WatchIngestWorker(const QString &databaseName, const ModelNamingRule &rule,
+                                     quint64 generation)
+    : databaseName(databaseName)
+    , namingRule(rule)
+    , generation(generation)
+{
+}
+
+WatchIngestWorker::~WatchIngestWorker()
+{
+    delete db;
+}
+
+void WatchIngestWorker::ingest(const QStringList &files)
+{
+    // Соединение создается в потоке загрузчика и используется только в нем.
+    // Схему создало соединение GUI - миграции и индексы здесь не повторяются
+    if (!db) {
+        db = new Database(QString("watch_ingest_%1").arg(quintptr(this)));
+        if (!db->openConnection(databaseName)) {
+            delete db;
+            db = nullptr;
+            emit finished(generation, files, QStringList(), QStringList(), {}, 0, false,
+                          {"Cannot open database: " + databaseName});
+            return;
+        }
+    }
+
+    BatchIngest ingest(db);
+    ingest.setNamingRule(namingRule);
+    BatchIngestStats stats = ingest.run(files);
+
+    emit finished(generation, files, stats.models, stats.calculationTypes, stats.resultSets,
+                  stats.rows, stats.committed, stats.errors);
+}
+
+WatchFolderService::WatchFolderService(const QString &databaseName, QObject *parent)
+    : QObject(parent)
+    , databaseName(databaseName)
+{
+    scanTimer.setInterval(3000);
+    changeTimer.setSingleShot(true);
+    changeTimer.setInterval(500);
+
+    connect(&scanTimer, &QTimer::timeout, this, &WatchFolderService::scan);
+    connect(&changeTimer, &QTimer::timeout, this, &WatchFolderService::scan);
+
+    // Уведомления о папке только ускоряют сканирование, на сетевых дисках их может не быть
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+        changeTimer.start();
+    });
+}
+
+WatchFolderService::~WatchFolderService()
+{
+    stop();
+}
+
+bool WatchFolderService::start(const QString &directory, const ModelNamingRule &rule,
+                               bool includeExisting)
+{
+    stop();
+
+    QDir dir(directory);
+    if (!dir.exists()) {
+        return false;
+    }
+
+    watchedDirectory = dir.absolutePath();
+    observed.clear();
+    ingested.clear();
+
+    if (!includeExisting) {
+        const QFileInfoList files = dir.entryInfoList({"*.txt", "*.csv"}, QDir::Files);
+        for (const QFileInfo &info : files) {
+            ingested.insert(info.absoluteFilePath(), info.lastModified());
+        }
+    }
+
+    worker = new WatchIngestWorker(databaseName, rule, ++runGeneration);
+    worker->moveToThread(&workerThread);
+    connect(&workerThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &WatchIngestWorker::finished, this, &WatchFolderService::onBatchFinished);
+    workerThread.start();
+
+    watcher.addPath(watchedDirectory);
+    scanTimer.start();
+    running = true;
+
+    scan();
+    return true;
+}
+
+void WatchFolderService::stop()
+{
+    if (!running) {
+        return;
+    }
+
+    running = false;
+    scanTimer.stop();
+    changeTimer.stop();
+    if (!watcher.directories().isEmpty()) {
+        watcher.removePaths(watcher.directories());
+    }
+
+    queue.clear();
+    inFlight.clear();
+
+    // Текущий пакет дописывается до конца, новые не начинаются
+    workerThread.quit();
+    workerThread.wait();
+    worker = nullptr;
+
+    emit queueChanged(0, 0);
+}
+
+void WatchFolderService::scan()
+{
+    if (!running) {
+        return;
+    }
+
+    QDir dir(watchedDirectory);
+    const QFileInfoList files = dir.entryInfoList({"*.txt", "*.csv"}, QDir::Files,
+                                                  QDir::Time | QDir::Reversed);
+    const QDateTime now = QDateTime::currentDateTime();
+
+    QSet<QString> present;
+    bool queueFull = false;
+
+    for (const QFileInfo &info : files) {
+        const QString path = info.absoluteFilePath();
+        present.insert(path);
+
+        auto ingestedIt = ingested.constFind(path);
+        if (ingestedIt != ingested.constEnd() && ingestedIt.value() == info.lastModified()) {
+            continue;
+        }
+
+        FileState &state = observed[path];
+        if (state.queued || queueFull) {
+            continue;
+        }
+
+        // Дописанный файл: размер и время не изменились с прошлого сканирования
+        bool stable = state.size == info.size()
+                      && state.modified == info.lastModified()
+                      && info.lastModified().msecsTo(now) >= settleMs;
+        state.size = info.size();
+        state.modified = info.lastModified();
+
+        if (!stable) {
+            continue;
+        }
+
+        Job job;
+        job.path = path;
+        job.priority = priorityOf ? priorityOf(info) : 0;
+        job.modified = info.lastModified();
+
+        if (enqueue(job)) {
+            state.queued = true;
+        } else {
+            queueFull = true;
+        }
+    }
+
+    // Удаленные файлы больше не отслеживаем
+    for (auto it = observed.begin(); it != observed.end();) {
+        if (!present.contains(it.key()) && !it->queued) {
+            it = observed.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    dispatch();
+}
+
+bool WatchFolderService::enqueue(const Job &job)
+{
+    if (queue.size() >= queueCapacity) {
+        return false;
+    }
+
+    int position = 0;
+    while (position < queue.size()
+           && (queue[position].priority > job.priority
+               || (queue[position].priority == job.priority
+                   && queue[position].modified <= job.modified))) {
+        position++;
+    }
+    queue.insert(position, job);
+
+    emit queueChanged(queue.size(), inFlight.size());
+    return true;
+}
+
+void WatchFolderService::dispatch()
+{
+    // Пишет один поток: следующий пакет - только после завершения предыдущего
+    if (!running || !inFlight.isEmpty() || queue.isEmpty()) {
+        return;
+    }
+
+    int count = qMin(batchSize, int(queue.size()));
+    for (int i = 0; i < count; ++i) {
+        inFlight.append(queue[i].path);
+        observed[queue[i].path].modified = queue[i].modified;
+    }
+    queue.erase(queue.begin(), queue.begin() + count);
+
+    QMetaObject::invokeMethod(worker, "ingest", Qt::QueuedConnection,
+                              Q_ARG(QStringList, inFlight));
+    emit queueChanged(queue.size(), inFlight.size());
+}
+
+void WatchFolderService::onBatchFinished(quint64 generation, const QStringList &files,
+                                         const QStringList &models,
+                                         const QStringList &calculationTypes,
+                                         const QList<QPair<QString, QString>> &resultSets,
+                                         qint64 rows, bool committed, const QStringList &errors)
+{
+    if (!running || generation != runGeneration) {
+        return;
+    }
+
+    for (const QString &path : files) {
+        if (committed) {
+            ingested.insert(path, observed.value(path).modified);
+        }
+        // При ошибке записи файл снова пройдет проверку и встанет в очередь
+        observed.remove(path);
+    }
+    inFlight.clear();
+
+    if (committed && rows > 0) {
+        emit resultsCommitted(models, calculationTypes, resultSets, rows);
+    }
+    if (!errors.isEmpty()) {
+        emit ingestFailed(errors);
+    }
+
+    emit queueChanged(queue.size(), inFlight.size());
+    dispatch();
+}
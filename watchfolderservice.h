@@ -0,0 +1,128 @@
+#ifndef WATCHFOLDERSERVICE_H
+#define WATCHFOLDERSERVICE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QList>
+#include <QThread>
+#include <QTimer>
+#include <functional>
+#include "batchingest.h"
+
+// Загрузчик в фоновом потоке: свое соединение с базой, запись пакетами через BatchIngest
+class WatchIngestWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    WatchIngestWorker(const QString &databaseName, const ModelNamingRule &rule, quint64 generation);
+    ~WatchIngestWorker();
+
+public slots:
+    void ingest(const QStringList &files);
+
+signals:
+    // generation - запуск слежения, для которого загружался пакет
+    void finished(quint64 generation, const QStringList &files, const QStringList &models,
+                  const QStringList &calculationTypes,
+                  const QList<QPair<QString, QString>> &resultSets, qint64 rows,
+                  bool committed, const QStringList &errors);
+
+private:
+    QString databaseName;
+    ModelNamingRule namingRule;
+    quint64 generation;
+    Database *db = nullptr;
+};
+
+// Слежение за папкой с результатами решателя.
+// Файл считается дописанным, когда его размер и время изменения не меняются
+// между сканированиями и с последней записи прошло settleMs. Готовые файлы
+// попадают в ограниченную очередь с приоритетами; загрузка идет пакетами в
+// фоновом потоке, одновременно обрабатывается один пакет. При заполненной
+// очереди новые файлы остаются на диске и берутся при следующих сканированиях.
+class WatchFolderService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WatchFolderService(const QString &databaseName, QObject *parent = nullptr);
+    ~WatchFolderService();
+
+    // includeExisting = false - файлы, лежащие в папке на момент запуска, пропускаются
+    bool start(const QString &directory, const ModelNamingRule &rule, bool includeExisting = false);
+    void stop();
+    bool isRunning() const { return running; }
+    QString directory() const { return watchedDirectory; }
+
+    void setQueueCapacity(int jobs) { queueCapacity = qMax(1, jobs); }
+    void setBatchSize(int files) { batchSize = qMax(1, files); }
+    void setSettleTime(int ms) { settleMs = ms; }
+    void setScanInterval(int ms) { scanTimer.setInterval(ms); }
+
+    // Больший приоритет загружается раньше; при равном - более старые файлы
+    void setPriorityFunction(const std::function<int(const QFileInfo &)> &function) { priorityOf = function; }
+
+    int queuedCount() const { return queue.size(); }
+    int inFlightCount() const { return inFlight.size(); }
+
+signals:
+    // Новые результаты записаны в базу (вызывается в потоке GUI).
+    // resultSets - затронутые пары (модель, вид расчета)
+    void resultsCommitted(const QStringList &models, const QStringList &calculationTypes,
+                          const QList<QPair<QString, QString>> &resultSets, qint64 rows);
+    void ingestFailed(const QStringList &errors);
+    void queueChanged(int queued, int inFlight);
+
+private slots:
+    void scan();
+    void onBatchFinished(quint64 generation, const QStringList &files, const QStringList &models,
+                         const QStringList &calculationTypes,
+                         const QList<QPair<QString, QString>> &resultSets, qint64 rows,
+                         bool committed, const QStringList &errors);
+
+private:
+    struct FileState {
+        qint64 size = -1;
+        QDateTime modified;
+        bool queued = false;
+    };
+
+    struct Job {
+        QString path;
+        int priority = 0;
+        QDateTime modified;
+    };
+
+    bool enqueue(const Job &job);
+    void dispatch();
+
+    QString databaseName;
+    QString watchedDirectory;
+    bool running = false;
+    // Растет при каждом start(): сигнал пакета прошлого запуска, пришедший
+    // из очереди событий после перезапуска, не трогает новый inFlight
+    quint64 runGeneration = 0;
+
+    QFileSystemWatcher watcher;
+    QTimer scanTimer;
+    QTimer changeTimer;
+
+    QHash<QString, FileState> observed;
+    QHash<QString, QDateTime> ingested;     // путь -> время изменения загруженной версии
+    QList<Job> queue;                       // по убыванию приоритета
+    QStringList inFlight;
+
+    int queueCapacity = 256;
+    int batchSize = 16;
+    int settleMs = 2000;
+    std::function<int(const QFileInfo &)> priorityOf;
+
+    QThread workerThread;
+    WatchIngestWorker *worker = nullptr;
+};
+
+#endif // WATCHFOLDERSERVICE_H